@@ -123,23 +123,14 @@ void Controller::showSendersInfo() {
 
 void Controller::calculatePacketTypePercentage() {
     visual.displayPacketTypeMenu();
-    int choice = getNum<int>(1, 3);
+    int choice = getNum<int>(1, static_cast<int>(Server::packetTypes.size()));
 
-    std::string packetType;
-    switch (choice) {
-        case 1:
-            packetType = "HT";
-            break;
-        case 2:
-            packetType = "F";
-            break;
-        case 3:
-            packetType = "M";
-            break;
-        default:
-            visual.displayInvalidChoiceMessage();
-            packetType = "HT";
-            break;
+    // The menu lists the packet types in the order of Server::packetTypes.
+    std::string packetType(Server::packetTypes.key(0));
+    if (choice >= 1 && static_cast<std::size_t>(choice) <= Server::packetTypes.size()) {
+        packetType = Server::packetTypes.key(choice - 1);
+    } else {
+        visual.displayInvalidChoiceMessage();
     }
 
     visual.displayThreadModeMenu();
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "../unordered_map/unordered_map.h"
+
+/**
+ * @brief Burst ingest and batched lookup benchmark for Unordered_map.
+ *
+ * Inserts bursts of IP+type keys into a table that starts empty, once with one insert() per
+ * element and once with insert_bulk() per burst, then looks every key up with find() and with
+ * find_many(). Tables well beyond the last-level cache make the per-key cache misses dominate,
+ * which is what the batched operations overlap.
+ *
+ * Usage: BulkBenchmark [keys = 4000000] [burst = 4096]
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Map = Unordered_map<std::string, int>;
+
+std::vector<std::pair<std::string, int>> makeValues(std::size_t count) {
+    static const char* types[] = {"HT", "F", "M"};
+    std::vector<std::pair<std::string, int>> values;
+    values.reserve(count);
+    std::mt19937_64 rng(42);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t ip = rng();
+        values.emplace_back(std::to_string(ip & 0xFF) + "." + std::to_string((ip >> 8) & 0xFF) + "." +
+                            std::to_string((ip >> 16) & 0xFF) + "." + std::to_string((ip >> 24) & 0xFF) + types[i % 3],
+                            static_cast<int>(i));
+    }
+    return values;
+}
+
+double nsPer(Clock::time_point start, std::size_t count) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(count);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    std::size_t burst = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4096;
+
+    auto values = makeValues(count);
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (const auto& value : values) {
+        keys.push_back(value.first);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(7));
+
+    Map single;
+    auto start = Clock::now();
+    for (const auto& value : values) {
+        single.insert(value);
+    }
+    double singleInsert = nsPer(start, count);
+
+    Map bulk;
+    start = Clock::now();
+    for (std::size_t i = 0; i < count; i += burst) {
+        bulk.insert_bulk(values.begin() + i, values.begin() + std::min(count, i + burst));
+    }
+    double bulkInsert = nsPer(start, count);
+
+    std::size_t found = 0;
+    start = Clock::now();
+    for (const auto& key : keys) {
+        found += single.find(key) != single.end();
+    }
+    double singleFind = nsPer(start, count);
+
+    std::vector<Map::const_iterator> results(burst);
+    const Map& constBulk = bulk;
+    start = Clock::now();
+    for (std::size_t i = 0; i < count; i += burst) {
+        auto last = keys.begin() + std::min(count, i + burst);
+        auto written = constBulk.find_many(keys.begin() + i, last, results.begin());
+        for (auto it = results.begin(); it != written; ++it) {
+            found += *it != constBulk.end();
+        }
+    }
+    double bulkFind = nsPer(start, count);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << std::setw(16) << "" << std::setw(14) << "one by one" << std::setw(14) << "batched" << std::endl
+              << std::setw(16) << "insert ns/key" << std::setw(14) << singleInsert << std::setw(14) << bulkInsert << std::endl
+              << std::setw(16) << "find ns/key" << std::setw(14) << singleFind << std::setw(14) << bulkFind << std::endl;
+    if (found != 2 * count) {
+        std::cerr << "lost keys" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../unordered_map/unordered_map.h"
+
+/**
+ * @brief Compares the modulo and power-of-two capacity policies of Unordered_map.
+ *
+ * For each policy the benchmark inserts IP+type keys into an empty table, then looks up every
+ * key once (hits) and as many absent keys (misses), and prints the time per operation.
+ *
+ * Usage: CapacityBenchmark [keys = 1000000]
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<std::string> makeKeys(std::size_t count, std::uint64_t seed) {
+    static const char* types[] = {"HT", "F", "M"};
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    std::mt19937_64 rng(seed);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t ip = rng();
+        keys.push_back(std::to_string(ip & 0xFF) + "." + std::to_string((ip >> 8) & 0xFF) + "." +
+                       std::to_string((ip >> 16) & 0xFF) + "." + std::to_string((ip >> 24) & 0xFF) + types[i % 3]);
+    }
+    return keys;
+}
+
+double nsPerOp(Clock::time_point start, std::size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(ops);
+}
+
+template<class Map>
+void run(const char* name, const std::vector<std::string>& keys, const std::vector<std::string>& absent) {
+    Map map;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        map.insert({keys[i], static_cast<int>(i)});
+    }
+    double insertNs = nsPerOp(start, keys.size());
+
+    std::size_t found = 0;
+    start = Clock::now();
+    for (const auto& key : keys) {
+        found += map.contains(key);
+    }
+    double hitNs = nsPerOp(start, keys.size());
+
+    start = Clock::now();
+    for (const auto& key : absent) {
+        found += map.contains(key);
+    }
+    double missNs = nsPerOp(start, absent.size());
+
+    std::cout << std::setw(14) << name << std::fixed << std::setprecision(1)
+              << std::setw(12) << insertNs << std::setw(12) << hitNs << std::setw(12) << missNs
+              << std::setw(12) << map.capacity() << "  (" << found << " found)" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    auto keys = makeKeys(count, 1);
+    auto absent = makeKeys(count, 2);
+
+    std::cout << std::setw(14) << "policy" << std::setw(12) << "insert ns" << std::setw(12) << "hit ns"
+              << std::setw(12) << "miss ns" << std::setw(12) << "capacity" << std::endl;
+    run<Unordered_map<std::string, int>>("modulo", keys, absent);
+    run<Unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, PowerOfTwoMapPolicy>>("power of two", keys, absent);
+    return 0;
+}
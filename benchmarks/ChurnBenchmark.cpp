@@ -0,0 +1,116 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "../unordered_map/unordered_map.h"
+
+/**
+ * @brief Insert/erase churn benchmark for the Unordered_map policies.
+ *
+ * Keeps a fixed number of live IP+type keys in the table: every cycle erases the oldest key and
+ * inserts a new one, the way delivered packets leave the transmission table. After every window
+ * of cycles the average latency of lookups of live keys is reported, so growing probe chains show
+ * up as a rising column.
+ *
+ * The default tombstone policy degrades to full-table probes under this load, so it is only run
+ * alongside the Robin Hood policy when --tombstones is given.
+ *
+ * Usage: ChurnBenchmark [cycles = 100000000] [live keys = 100000] [windows = 20] [--tombstones]
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<std::string> makeKeys(std::size_t count) {
+    static const char* types[] = {"HT", "F", "M"};
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    std::mt19937_64 rng(42);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t ip = rng();
+        keys.push_back(std::to_string(ip & 0xFF) + "." + std::to_string((ip >> 8) & 0xFF) + "." +
+                       std::to_string((ip >> 16) & 0xFF) + "." + std::to_string((ip >> 24) & 0xFF) + types[i % 3]);
+    }
+    return keys;
+}
+
+template<class Map>
+class ChurnRun {
+public:
+    ChurnRun(const std::vector<std::string>& keys, std::size_t live) : keys(keys), live(live) {
+        for (std::size_t i = 0; i < live; ++i) {
+            map.insert({keys[i], static_cast<int>(i)});
+        }
+    }
+
+    void churn(std::size_t cycles) {
+        for (std::size_t i = 0; i < cycles; ++i, ++oldest) {
+            map.erase(keys[oldest % keys.size()]);
+            map.insert({keys[(oldest + live) % keys.size()], static_cast<int>(oldest)});
+        }
+    }
+
+    double lookupNs(std::size_t lookups, std::mt19937_64& rng) {
+        std::size_t found = 0;
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < lookups; ++i) {
+            found += map.contains(keys[(oldest + rng() % live) % keys.size()]);
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        if (found != lookups) {
+            std::cerr << "lost keys: " << lookups - found << std::endl;
+        }
+        return elapsed / static_cast<double>(lookups);
+    }
+
+    std::size_t capacity() const {
+        return map.capacity();
+    }
+
+private:
+    Map map;
+    const std::vector<std::string>& keys;
+    std::size_t live;
+    std::size_t oldest = 0;
+};
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t cycles = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+    std::size_t live = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+    std::size_t windows = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 20;
+    bool compare = argc > 4 && std::string(argv[4]) == "--tombstones";
+    std::size_t lookups = 100000;
+
+    auto keys = makeKeys(live * 4);
+    ChurnRun<Unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, RobinHoodMapPolicy>> robinHood(keys, live);
+    std::unique_ptr<ChurnRun<Unordered_map<std::string, int>>> tombstones;
+    if (compare) {
+        tombstones = std::make_unique<ChurnRun<Unordered_map<std::string, int>>>(keys, live);
+    }
+    std::mt19937_64 rng(7);
+
+    std::cout << std::setw(14) << "cycles" << std::setw(18) << "robin hood ns";
+    if (compare) {
+        std::cout << std::setw(18) << "tombstones ns";
+    }
+    std::cout << std::endl;
+    for (std::size_t window = 1; window <= windows; ++window) {
+        robinHood.churn(cycles / windows);
+        std::cout << std::setw(14) << window * (cycles / windows)
+                  << std::setw(18) << std::fixed << std::setprecision(1) << robinHood.lookupNs(lookups, rng);
+        if (compare) {
+            tombstones->churn(cycles / windows);
+            std::cout << std::setw(18) << tombstones->lookupNs(lookups, rng);
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "capacity: " << robinHood.capacity() << std::endl;
+    return 0;
+}
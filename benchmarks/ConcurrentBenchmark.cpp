@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../unordered_map/concurrent_unordered_map.h"
+
+/**
+ * @brief Thread scaling benchmark for ConcurrentUnordered_map.
+ *
+ * Every thread runs a transmission-table-like mix over its own IP+type keys: insert a packet,
+ * look up two keys and erase the oldest packet. The sharded map is compared with a single
+ * Unordered_map behind one mutex, for 1, 2, 4, ... threads up to the given maximum. Both use the
+ * Robin Hood policy, which keeps probe lengths flat under this churn.
+ *
+ * Usage: ConcurrentBenchmark [operations per thread = 2000000] [max threads = hardware threads]
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Policy = RobinHoodMapPolicy;
+
+std::string makeKey(std::size_t thread, std::size_t i) {
+    static const char* types[] = {"HT", "F", "M"};
+    return "10." + std::to_string(thread) + "." + std::to_string(i / 3) + types[i % 3];
+}
+
+/**
+ * @brief A single Unordered_map behind one mutex, the baseline for the sharded map.
+ */
+class LockedMap {
+public:
+    bool insert(std::pair<std::string, int>&& value) {
+        std::lock_guard lock(mutex);
+        return map.insert(std::move(value)).second;
+    }
+
+    bool contains(const std::string& key) {
+        std::lock_guard lock(mutex);
+        return map.contains(key);
+    }
+
+    std::size_t erase(const std::string& key) {
+        std::lock_guard lock(mutex);
+        return map.erase(key);
+    }
+
+private:
+    std::mutex mutex;
+    Unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, Policy> map;
+};
+
+template<class Map>
+double run(Map& map, std::size_t threads, std::size_t operations) {
+    const std::size_t live = 10000;
+    std::vector<std::vector<std::string>> keys(threads);
+    for (std::size_t t = 0; t < threads; ++t) {
+        for (std::size_t i = 0; i < operations + live; ++i) {
+            keys[t].push_back(makeKey(t, i));
+        }
+    }
+
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&map, &keys = keys[t], operations] {
+            std::size_t found = 0;
+            for (std::size_t i = 0; i < operations; ++i) {
+                map.insert({keys[i + live], static_cast<int>(i)});
+                found += map.contains(keys[i + live / 2]);
+                found += map.contains(keys[i + live - 1]);
+                map.erase(keys[i]);
+            }
+            if (found == 0) {
+                std::cerr << "no lookup hit" << std::endl;
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return static_cast<double>(threads * operations * 4) / seconds / 1e6;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t operations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    std::size_t maxThreads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "sharded Mops/s" << std::setw(10) << "speedup"
+              << std::setw(16) << "locked Mops/s" << std::endl;
+    double base = 0;
+    for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ConcurrentUnordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, Policy> sharded;
+        LockedMap locked;
+        double shardedRate = run(sharded, threads, operations);
+        double lockedRate = run(locked, threads, operations);
+        if (threads == 1) {
+            base = shardedRate;
+        }
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(2)
+                  << std::setw(16) << shardedRate << std::setw(10) << shardedRate / base
+                  << std::setw(16) << lockedRate << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../unordered_map/unordered_map.h"
+
+/**
+ * @brief Lookup tail latency benchmark of the cuckoo policy against the probing policies.
+ *
+ * Fills a table of fixed capacity with IP+type keys up to several load factors, after a round of
+ * insert/erase churn, and times individual lookups of present and absent keys. Reports the 50th,
+ * 99th and 99.99th percentile latency and the longest probe sequence for each policy; the
+ * cuckoo policy never examines more than two buckets, however high the load.
+ *
+ * Every lookup is timed on its own, so the figures include the overhead of reading the clock.
+ *
+ * Usage: CuckooBenchmark [capacity = 262144] [lookups = 2000000]
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct StoredHashPowerOfTwoPolicy : PowerOfTwoMapPolicy {
+    static constexpr bool store_hash = true;
+};
+
+struct RobinHoodPowerOfTwoPolicy : StoredHashPowerOfTwoPolicy {
+    static constexpr bool robin_hood = true;
+};
+
+std::vector<std::string> makeKeys(std::size_t count) {
+    static const char* types[] = {"HT", "F", "M"};
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        // Multiplying by an odd constant scatters the addresses without repeating any.
+        std::uint32_t ip = static_cast<std::uint32_t>(i * 2654435761u);
+        keys.push_back(std::to_string(ip >> 24) + "." + std::to_string((ip >> 16) & 0xFF) + "." +
+                       std::to_string((ip >> 8) & 0xFF) + "." + std::to_string(ip & 0xFF) + types[i % 3]);
+    }
+    return keys;
+}
+
+template<class Policy>
+void run(const char* name, const std::vector<std::string>& keys, std::size_t capacity, double load, std::size_t lookups) {
+    Unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, Policy> map;
+    map.reserve(capacity);
+    std::size_t count = static_cast<std::size_t>(static_cast<double>(map.capacity()) * load);
+    std::size_t next = 0;
+    for (; next < count; ++next) {
+        map.insert({keys[next], static_cast<int>(next)});
+    }
+    for (std::size_t i = 0; i < count; ++i, ++next) {
+        map.erase(keys[i]);
+        map.insert({keys[next], static_cast<int>(next)});
+    }
+
+    std::mt19937_64 rng(7);
+    std::vector<double> latencies;
+    latencies.reserve(lookups);
+    std::size_t found = 0;
+    std::size_t longest = 0;
+    for (std::size_t i = 0; i < lookups; ++i) {
+        // Every other lookup is of a key erased by the churn.
+        const std::string& key = i % 2 == 0 ? keys[count + rng() % count] : keys[rng() % count];
+        auto start = Clock::now();
+        found += map.contains(key);
+        latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        if (i % 64 == 0) {
+            longest = std::max(longest, map.probe_length(key));
+        }
+    }
+    if (found != (lookups + 1) / 2) {
+        std::cerr << "lost keys: " << (lookups + 1) / 2 - found << std::endl;
+    }
+    auto percentile = [&](double p) {
+        auto nth = latencies.begin() + static_cast<std::ptrdiff_t>(p * static_cast<double>(latencies.size() - 1));
+        std::nth_element(latencies.begin(), nth, latencies.end());
+        return *nth;
+    };
+    std::cout << std::setw(8) << std::fixed << std::setprecision(2) << load << std::setw(12) << name
+              << std::setw(10) << std::setprecision(1) << percentile(0.5) << std::setw(10) << percentile(0.99)
+              << std::setw(12) << percentile(0.9999) << std::setw(12) << longest << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t capacity = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 262144;
+    std::size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+    auto keys = makeKeys(capacity * 2);
+
+    std::cout << std::setw(8) << "load" << std::setw(12) << "policy" << std::setw(10) << "p50 ns"
+              << std::setw(10) << "p99 ns" << std::setw(12) << "p99.99 ns" << std::setw(12) << "max probes" << std::endl;
+    for (double load : {0.5, 0.7, 0.79}) {
+        run<StoredHashPowerOfTwoPolicy>("linear", keys, capacity, load, lookups);
+        run<RobinHoodPowerOfTwoPolicy>("robin hood", keys, capacity, load, lookups);
+        run<CuckooMapPolicy>("cuckoo", keys, capacity, load, lookups);
+    }
+    return 0;
+}
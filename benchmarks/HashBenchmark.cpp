@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../unordered_map/unordered_map.h"
+
+/**
+ * @brief Throughput and flooding benchmark of std::hash against the seeded FastHash.
+ *
+ * The normal key set holds random IP+type keys: for each hash function the benchmark reports
+ * the time to hash a key and to look one up in a filled table.
+ *
+ * The adversarial key set models a sender that knows the table uses std::hash and how big it
+ * is: it searches for receiver addresses whose home slots all fall into the first few control
+ * groups of a table of that capacity. The benchmark inserts the flood into both tables and
+ * reports the insertion time and the mean probe length of the flooded keys. Under std::hash
+ * the flood piles up into one cluster; the FastHash table draws a seed the sender cannot know
+ * and spreads the same keys like random ones.
+ *
+ * Usage: HashBenchmark [capacity = 65536] [flood keys = 8192] [lookups = 1000000]
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string makeKey(std::uint32_t ip, std::size_t i) {
+    static const char* types[] = {"HT", "F", "M"};
+    return std::to_string(ip >> 24) + "." + std::to_string((ip >> 16) & 0xFF) + "." +
+           std::to_string((ip >> 8) & 0xFF) + "." + std::to_string(ip & 0xFF) + types[i % 3];
+}
+
+std::vector<std::string> randomKeys(std::size_t count) {
+    std::vector<std::string> keys;
+    std::mt19937 rng(42);
+    for (std::size_t i = 0; i < count; ++i) {
+        keys.push_back(makeKey(rng(), i));
+    }
+    return keys;
+}
+
+/**
+ * @brief Searches consecutive addresses for keys whose std::hash home slot lies in the first window slots.
+ */
+std::vector<std::string> floodKeys(std::size_t count, std::size_t capacity, std::size_t window) {
+    using Capacity = DefaultMapPolicy::capacity_policy;
+    std::vector<std::string> keys;
+    std::hash<std::string> hash;
+    for (std::uint32_t ip = 1; keys.size() < count; ++ip) {
+        std::string key = makeKey(ip, ip);
+        if (Capacity::index(Capacity::mix(hash(key)), capacity) < window) {
+            keys.push_back(std::move(key));
+        }
+    }
+    return keys;
+}
+
+template<class Hash>
+double hashNs(const std::vector<std::string>& keys, std::size_t rounds) {
+    Hash hash;
+    std::size_t sink = 0;
+    auto start = Clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (const auto& key : keys) {
+            sink += hash(key);
+        }
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    if (sink == 42) {
+        std::cerr << "unlikely" << std::endl;
+    }
+    return elapsed / static_cast<double>(keys.size() * rounds);
+}
+
+template<class Hash>
+double lookupNs(const std::vector<std::string>& keys, std::size_t capacity, std::size_t lookups) {
+    Unordered_map<std::string, int, Hash> map;
+    map.reserve(capacity);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        map.insert({keys[i], static_cast<int>(i)});
+    }
+    std::mt19937_64 rng(7);
+    std::size_t found = 0;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < lookups; ++i) {
+        found += map.contains(keys[rng() % keys.size()]);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    if (found != lookups) {
+        std::cerr << "lost keys: " << lookups - found << std::endl;
+    }
+    return elapsed / static_cast<double>(lookups);
+}
+
+template<class Hash>
+void flood(const char* name, const std::vector<std::string>& keys, std::size_t capacity) {
+    Unordered_map<std::string, int, Hash> map;
+    map.reserve(capacity);
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        map.insert({keys[i], static_cast<int>(i)});
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    double probes = 0;
+    for (const auto& key : keys) {
+        probes += static_cast<double>(map.probe_length(key));
+    }
+    std::cout << std::setw(12) << name << std::setw(16) << std::fixed << std::setprecision(1) << elapsed
+              << std::setw(16) << std::setprecision(2) << probes / static_cast<double>(keys.size()) << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t capacity = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 65536;
+    std::size_t floodCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 8192;
+    std::size_t lookups = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+
+    Unordered_map<std::string, int> probe;
+    probe.reserve(capacity);
+    capacity = probe.capacity();
+    auto keys = randomKeys(capacity / 2);
+
+    std::cout << "normal keys: " << keys.size() << " in " << capacity << " slots" << std::endl;
+    std::cout << std::setw(12) << "hash" << std::setw(16) << "hash ns" << std::setw(16) << "lookup ns" << std::endl;
+    std::cout << std::setw(12) << "std::hash" << std::setw(16) << std::fixed << std::setprecision(2)
+              << hashNs<std::hash<std::string>>(keys, 20) << std::setw(16) << lookupNs<std::hash<std::string>>(keys, capacity, lookups) << std::endl;
+    std::cout << std::setw(12) << "FastHash" << std::setw(16) << hashNs<FastHash>(keys, 20)
+              << std::setw(16) << lookupNs<FastHash>(keys, capacity, lookups) << std::endl;
+
+    auto flooded = floodKeys(floodCount, capacity, ControlGroup::width * 4);
+    std::cout << std::endl << "flood: " << flooded.size() << " keys aimed at the first " << ControlGroup::width * 4
+              << " slots" << std::endl;
+    std::cout << std::setw(12) << "hash" << std::setw(16) << "insert ms" << std::setw(16) << "mean probes" << std::endl;
+    flood<std::hash<std::string>>("std::hash", flooded, capacity);
+    flood<FastHash>("FastHash", flooded, capacity);
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include "../unordered_map/unordered_map.h"
+
+/**
+ * @brief Full-table scan benchmark for sparse Unordered_map tables.
+ *
+ * Reserves a fixed capacity and fills it with random keys to a decreasing fraction of its slots, the way the
+ * transmission table looks after a rehash or after most packets have been delivered, then times
+ * complete iterations. With group-wise skipping of free slots the time per scan follows the
+ * number of elements rather than the capacity.
+ *
+ * Usage: IterationBenchmark [capacity = 1000000] [scans = 200]
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double scanUs(const Unordered_map<int, int>& map, std::size_t scans) {
+    long long sum = 0;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < scans; ++i) {
+        for (const auto& entry : map) {
+            sum += entry.second;
+        }
+    }
+    auto elapsed = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    if (sum == -1) {
+        std::cerr << "unreachable" << std::endl;
+    }
+    return elapsed / static_cast<double>(scans);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t capacity = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::size_t scans = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200;
+
+    std::cout << std::setw(12) << "elements" << std::setw(12) << "capacity" << std::setw(14) << "scan us" << std::endl;
+    for (std::size_t fill = 2; fill <= 4096; fill *= 4) {
+        Unordered_map<int, int> map;
+        map.reserve(capacity);
+        std::mt19937 rng(42);
+        while (map.size() < capacity / fill) {
+            map.insert({static_cast<int>(rng()), 1});
+        }
+        std::cout << std::setw(12) << map.size() << std::setw(12) << map.capacity()
+                  << std::setw(14) << std::fixed << std::setprecision(1) << scanUs(map, scans) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../unordered_map/unordered_map.h"
+
+/**
+ * @brief Probe length and lookup throughput benchmark for the Unordered_map probing policies.
+ *
+ * Fills a table of fixed capacity to several load factors with IP+type keys, either random
+ * addresses or consecutive addresses of a few subnets, and reports for every probing policy the
+ * mean and 99th percentile number of control groups probed by successful lookups, the mean for
+ * unsuccessful lookups, and the throughput of successful lookups.
+ *
+ * Usage: ProbingBenchmark [capacity = 1048576] [lookups = 1000000]
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template<class Probing>
+struct ProbingPolicy : PowerOfTwoMapPolicy {
+    using probing = Probing;
+};
+
+std::string makeKey(std::uint32_t ip, std::size_t i) {
+    static const char* types[] = {"HT", "F", "M"};
+    return std::to_string(ip >> 24) + "." + std::to_string((ip >> 16) & 0xFF) + "." +
+           std::to_string((ip >> 8) & 0xFF) + "." + std::to_string(ip & 0xFF) + types[i % 3];
+}
+
+std::vector<std::string> randomKeys(std::size_t count) {
+    std::vector<std::string> keys;
+    std::mt19937 rng(42);
+    for (std::size_t i = 0; i < count; ++i) {
+        keys.push_back(makeKey(rng(), i));
+    }
+    return keys;
+}
+
+std::vector<std::string> subnetKeys(std::size_t count) {
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint32_t subnet = static_cast<std::uint32_t>(i / 3 / 65536);
+        keys.push_back(makeKey((10u << 24) + (subnet << 16) + static_cast<std::uint32_t>(i / 3 % 65536), i));
+    }
+    return keys;
+}
+
+template<class Policy>
+void run(const char* name, const std::vector<std::string>& keys, const std::vector<std::string>& missing,
+         std::size_t capacity, double load, std::size_t lookups) {
+    Unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, Policy> map;
+    map.reserve(capacity);
+    std::size_t count = static_cast<std::size_t>(static_cast<double>(map.capacity()) * load);
+    for (std::size_t i = 0; i < count; ++i) {
+        map.insert({keys[i], static_cast<int>(i)});
+    }
+
+    std::vector<std::size_t> probes;
+    probes.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        probes.push_back(map.probe_length(keys[i]));
+    }
+    double mean = 0;
+    for (std::size_t p : probes) {
+        mean += static_cast<double>(p);
+    }
+    mean /= static_cast<double>(count);
+    std::nth_element(probes.begin(), probes.begin() + count * 99 / 100, probes.end());
+    std::size_t p99 = probes[count * 99 / 100];
+
+    double missMean = 0;
+    for (const auto& key : missing) {
+        missMean += static_cast<double>(map.probe_length(key));
+    }
+    missMean /= static_cast<double>(missing.size());
+
+    std::mt19937 rng(7);
+    std::size_t found = 0;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < lookups; ++i) {
+        found += map.contains(keys[rng() % count]);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (found != lookups) {
+        std::cerr << "lost keys" << std::endl;
+    }
+
+    std::cout << std::setw(12) << name << std::setw(7) << std::setprecision(2) << load
+              << std::setw(11) << std::setprecision(3) << mean << std::setw(6) << p99
+              << std::setw(11) << missMean << std::setw(11) << std::setprecision(1)
+              << static_cast<double>(lookups) / seconds / 1e6 << std::endl;
+}
+
+void runAll(const char* distribution, const std::vector<std::string>& keys, const std::vector<std::string>& missing,
+            std::size_t capacity, std::size_t lookups) {
+    std::cout << distribution << " keys" << std::endl
+              << std::setw(12) << "probing" << std::setw(7) << "load" << std::setw(11) << "hit mean" << std::setw(6) << "p99"
+              << std::setw(11) << "miss mean" << std::setw(11) << "Mlookups/s" << std::endl
+              << std::fixed;
+    for (double load : {0.5, 0.7, 0.79}) {
+        run<DefaultMapPolicy>("linear mod", keys, missing, capacity, load, lookups);
+        run<ProbingPolicy<LinearProbing>>("linear", keys, missing, capacity, load, lookups);
+        run<ProbingPolicy<QuadraticProbing>>("quadratic", keys, missing, capacity, load, lookups);
+        run<ProbingPolicy<TriangularProbing>>("triangular", keys, missing, capacity, load, lookups);
+        run<ProbingPolicy<DoubleHashProbing>>("double hash", keys, missing, capacity, load, lookups);
+    }
+    std::cout << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t capacity = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1048576;
+    std::size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+
+    auto random = randomKeys(capacity + 100000);
+    std::vector<std::string> randomMissing(random.end() - 100000, random.end());
+    runAll("random", random, randomMissing, capacity, lookups);
+
+    auto subnet = subnetKeys(capacity + 100000);
+    std::vector<std::string> subnetMissing(subnet.end() - 100000, subnet.end());
+    runAll("subnet", subnet, subnetMissing, capacity, lookups);
+    return 0;
+}
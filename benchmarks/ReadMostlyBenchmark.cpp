@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../unordered_map/concurrent_unordered_map.h"
+#include "../unordered_map/read_mostly_unordered_map.h"
+
+/**
+ * @brief Reader scaling benchmark for ReadMostlyUnordered_map.
+ *
+ * A growing number of reader threads looks up live IP+type keys while one writer keeps inserting
+ * and erasing packets at a low rate. The lock-free read map is compared with the sharded map,
+ * whose readers take shared locks.
+ *
+ * Usage: ReadMostlyBenchmark [milliseconds per run = 1000] [max readers = hardware threads]
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<std::string> makeKeys(std::size_t count) {
+    static const char* types[] = {"HT", "F", "M"};
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < count; ++i) {
+        keys.push_back("10.0." + std::to_string(i / 3) + types[i % 3]);
+    }
+    return keys;
+}
+
+template<class Map>
+double run(std::size_t readers, std::chrono::milliseconds duration) {
+    const std::size_t live = 100000;
+    auto keys = makeKeys(live * 2);
+    Map map;
+    for (std::size_t i = 0; i < live; ++i) {
+        map.insert({keys[i], static_cast<int>(i)});
+    }
+
+    std::atomic<bool> done = false;
+    std::atomic<std::size_t> lookups = 0;
+    std::thread writer([&] {
+        for (std::size_t i = 0; !done.load(std::memory_order_relaxed); ++i) {
+            map.insert({keys[live + i % live], static_cast<int>(i)});
+            map.erase(keys[live + (i + live / 2) % live]);
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    });
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < readers; ++t) {
+        workers.emplace_back([&, t] {
+            std::size_t count = 0;
+            std::size_t found = 0;
+            for (std::size_t i = t * 7919; !done.load(std::memory_order_relaxed); ++i, ++count) {
+                found += map.contains(keys[i % live]);
+            }
+            if (found != count) {
+                std::cerr << "lost keys" << std::endl;
+            }
+            lookups += count;
+        });
+    }
+    std::this_thread::sleep_for(duration);
+    done = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    writer.join();
+    return static_cast<double>(lookups.load()) / std::chrono::duration<double>(duration).count() / 1e6;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::chrono::milliseconds duration(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000);
+    std::size_t maxReaders = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << std::setw(8) << "readers" << std::setw(18) << "lock-free Mops/s" << std::setw(18) << "sharded Mops/s" << std::endl;
+    for (std::size_t readers = 1; readers <= maxReaders; readers *= 2) {
+        double lockFree = run<ReadMostlyUnordered_map<std::string, int>>(readers, duration);
+        double sharded = run<ConcurrentUnordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, RobinHoodMapPolicy>>(readers, duration);
+        std::cout << std::setw(8) << readers << std::fixed << std::setprecision(2)
+                  << std::setw(18) << lockFree << std::setw(18) << sharded << std::endl;
+    }
+    return 0;
+}
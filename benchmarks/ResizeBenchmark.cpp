@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../unordered_map/unordered_map.h"
+
+/**
+ * @brief Insertion latency benchmark for synchronous and incremental resizing.
+ *
+ * Times every single insertion of a growing table of string keys and reports the mean, the
+ * 99.9th percentile and the worst insertion, the latter being dominated by resizing.
+ *
+ * Usage: ResizeBenchmark [keys = 4000000]
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template<class Map>
+void run(const char* name, const std::vector<std::string>& keys) {
+    Map map;
+    std::vector<double> latencies;
+    latencies.reserve(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        auto start = Clock::now();
+        map.insert({keys[i], static_cast<int>(i)});
+        latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    double mean = 0;
+    for (double latency : latencies) {
+        mean += latency;
+    }
+    mean /= static_cast<double>(latencies.size());
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << std::setw(14) << name << std::fixed << std::setprecision(3)
+              << std::setw(12) << mean
+              << std::setw(12) << latencies[latencies.size() * 999 / 1000]
+              << std::setw(14) << latencies.back() << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        keys.push_back("10.0." + std::to_string(i) + "HT");
+    }
+
+    std::cout << std::setw(14) << "policy" << std::setw(12) << "mean us" << std::setw(12) << "p99.9 us" << std::setw(14) << "worst us" << std::endl;
+    run<Unordered_map<std::string, int>>("synchronous", keys);
+    run<Unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, IncrementalResizeMapPolicy>>("incremental", keys);
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../unordered_map/unordered_map.h"
+
+/**
+ * @brief Restart time benchmark: rebuilding a table by insertion against loading a saved one.
+ *
+ * For a table of integer keys and values and for a table of IP+type string keys, the benchmark
+ * times inserting every entry into an empty table, saving the table, loading it back and looking
+ * up a thousand keys in the loaded table. The integer table is mapped as it is and only the pages
+ * of the looked-up keys are read; the string table is decoded without hashing any key.
+ *
+ * The saved files go to the temporary directory and are removed afterwards. The load figures of
+ * the integer table depend on whether the file is still in the page cache, as it is right after
+ * saving.
+ *
+ * Usage: RestartBenchmark [entries = 4000000]
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template<class Map, class Make>
+void run(const char* name, std::size_t count, Make make) {
+    std::vector<typename Map::value_type> entries;
+    entries.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        entries.push_back(make(i));
+    }
+    std::string path = (std::filesystem::temp_directory_path() / "RestartBenchmark.umap").string();
+
+    auto start = Clock::now();
+    Map map;
+    for (const auto& entry : entries) {
+        map.insert(entry);
+    }
+    double insertMs = msSince(start);
+
+    start = Clock::now();
+    map.save(path);
+    double saveMs = msSince(start);
+
+    start = Clock::now();
+    Map loaded = Map::load(path);
+    double loadMs = msSince(start);
+
+    start = Clock::now();
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        found += loaded.contains(entries[i * 7919 % count].first);
+    }
+    double lookupMs = msSince(start);
+    if (found != 1000 || loaded.size() != map.size()) {
+        std::cerr << "lost keys" << std::endl;
+    }
+
+    std::cout << std::setw(10) << name << std::setw(14) << std::fixed << std::setprecision(1) << insertMs
+              << std::setw(12) << saveMs << std::setw(12) << std::setprecision(3) << loadMs << std::setw(16) << lookupMs
+              << std::setw(12) << std::filesystem::file_size(path) / (1 << 20) << std::endl;
+    std::filesystem::remove(path);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+
+    std::cout << count << " entries" << std::endl;
+    std::cout << std::setw(10) << "keys" << std::setw(14) << "insert ms" << std::setw(12) << "save ms" << std::setw(12)
+              << "load ms" << std::setw(16) << "1000 finds ms" << std::setw(12) << "file MiB" << std::endl;
+    run<Unordered_map<std::uint64_t, std::uint64_t>>("integer", count, [](std::size_t i) {
+        return std::pair<std::uint64_t, std::uint64_t>(i * 0x9E3779B97F4A7C15ull, i);
+    });
+    run<Unordered_map<std::string, std::uint64_t>>("string", count, [](std::size_t i) {
+        static const char* types[] = {"HT", "F", "M"};
+        std::uint32_t ip = static_cast<std::uint32_t>(i * 2654435761u);
+        return std::pair<std::string, std::uint64_t>(std::to_string(ip >> 24) + "." + std::to_string((ip >> 16) & 0xFF) + "." +
+                                                     std::to_string((ip >> 8) & 0xFF) + "." + std::to_string(ip & 0xFF) + types[i % 3], i);
+    });
+    return 0;
+}
@@ -5,10 +5,13 @@
 #include <string>
 #include <unordered_map>
 #include <memory>
+#include <memory_resource>
 #include <future>
 #include <algorithm>
 #include <numeric>
+#include <array>
 #include "TransmissionTable.h"
+#include "../unordered_map/static_map.h"
 #include "Funcs.h"
 
 /**
@@ -21,13 +24,58 @@ class Server {
 private:
     std::string serverName; /**< The name of the server. */
     std::string serverAddress; /**< The IP address of the server. */
-    TransmissionTable transmissionTable; /**< The transmission table for storing packets. */
+
+    /**
+     * @brief The transmission table together with the pool holding the table and its keys.
+     *
+     * Kept on the heap, so that moving a server leaves the pool where the table allocated from it,
+     * and shared with the snapshots of the table, which may need the pool after the server is gone.
+     */
+    struct PacketStore {
+        std::pmr::unsynchronized_pool_resource packetMemory; /**< Pool holding the transmission table and its keys. */
+        TransmissionTable transmissionTable; /**< The transmission table for storing packets. */
+
+        /**
+         * @brief Constructs an empty transmission table on a new pool.
+         */
+        PacketStore();
+
+        /**
+         * @brief Copies a transmission table onto a new pool.
+         *
+         * @param table The transmission table to copy.
+         */
+        explicit PacketStore(const TransmissionTable& table);
+    };
+
+    std::shared_ptr<PacketStore> packetStore; /**< The transmission table and its pool, shared with the snapshots of the table. */
 
 public:
+    /**
+     * @brief The packet type codes in order of priority, each mapped to the name of its type.
+     *
+     * Resolved by a perfect hash built at compile time, so dispatching on a type code costs one
+     * hash of a short string and one comparison.
+     */
+    static constexpr StaticMap<std::string_view, 3> packetTypes{{{"HT", "HyperText"}, {"F", "File"}, {"M", "Mail"}}};
+
+    typedef std::array<std::size_t, packetTypes.size()> PacketTypeCounts; /**< Number of packets of every type, in the order of packetTypes. */
+
+    /**
+     * @brief A snapshot of the transmission table that keeps the pool of the table alive.
+     *
+     * Should the server free the table while copying the packets still shared with the snapshot
+     * runs out of memory, the snapshot is left the slots themselves, which live in the pool.
+     */
+    struct TableSnapshot {
+        std::shared_ptr<std::pmr::memory_resource> packetMemory; /**< The pool of the table, released after the snapshot. */
+        TransmissionTable::Snapshot table; /**< The snapshot of the transmission table. */
+    };
+
     /**
      * @brief Default constructor.
      */
-    Server() = default;
+    Server();
 
     /**
      * @brief Constructs a server with the specified name and IP address.
@@ -37,6 +85,48 @@ public:
      */
     Server(const std::string& name, const std::string& address);
 
+    /**
+     * @brief Copy constructor.
+     *
+     * The copy gets a transmission table of its own, allocated from a pool of its own.
+     *
+     * @param other The server to copy.
+     */
+    Server(const Server& other);
+
+    /**
+     * @brief Move constructor.
+     *
+     * Takes over the transmission table along with its pool, so no packet is moved. The moved-from
+     * server may only be assigned to or destroyed.
+     *
+     * @param other The server to move.
+     */
+    Server(Server&& other) noexcept;
+
+    /**
+     * @brief Copy assignment operator.
+     *
+     * @param other The server to copy.
+     * @return Reference to this server.
+     */
+    Server& operator=(const Server& other);
+
+    /**
+     * @brief Move assignment operator.
+     *
+     * Takes over the transmission table along with its pool, see the move constructor.
+     *
+     * @param other The server to move.
+     * @return Reference to this server.
+     */
+    Server& operator=(Server&& other) noexcept;
+
+    /**
+     * @brief Destructor.
+     */
+    ~Server();
+
     /**
      * @brief Gets the name of the server.
      *
@@ -101,6 +191,15 @@ public:
      */
     std::ostream& showSendersInfo(std::ostream& os) const;
 
+    /**
+     * @brief Displays sender information from a snapshot of the transmission table.
+     *
+     * @param os The output stream.
+     * @param snapshot The snapshot, see snapshotTable().
+     * @return The modified output stream.
+     */
+    static std::ostream& showSendersInfo(std::ostream& os, const TableSnapshot& snapshot);
+
     /**
      * @brief Calculates the percentage of packets of the specified type in the transmission table.
      *
@@ -117,6 +216,41 @@ public:
      */
     float calculatePacketTypePercentageMT(const std::string& type) const;
 
+    /**
+     * @brief Counts the packets of every type in the transmission table in one pass.
+     *
+     * @return The counts, in the order of packetTypes; packets of other types are not counted.
+     */
+    PacketTypeCounts getPacketTypeCounts() const;
+
+    /**
+     * @brief Gets the probe length, occupancy and rehash statistics of the transmission table.
+     *
+     * Rising mean probe lengths or effective load point to a degrading table before lookups
+     * become slow enough to notice.
+     *
+     * @return The statistics.
+     */
+    MapStats getTableStats() const;
+
+    /**
+     * @brief Takes a snapshot of the transmission table for dumps and statistics off the ingest path.
+     *
+     * Taking it copies no packets, and packets may keep being added and erased while another
+     * thread reads it. The snapshot may outlive the server.
+     *
+     * @return The snapshot.
+     */
+    TableSnapshot snapshotTable();
+
+    /**
+     * @brief Counts the packets of every type in a snapshot of the transmission table.
+     *
+     * @param snapshot The snapshot, see snapshotTable().
+     * @return The counts, in the order of packetTypes; packets of other types are not counted.
+     */
+    static PacketTypeCounts getPacketTypeCounts(const TableSnapshot& snapshot);
+
     /**
      * @brief Overloaded stream insertion operator to output the server details.
      *
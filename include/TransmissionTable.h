@@ -2,13 +2,134 @@
 #define TRANSMISSIONTABLE_H
 
 #include <iostream>
+#include <algorithm>
 #include <unordered_map>
 #include <string>
+#include <string_view>
+#include <memory_resource>
+#include <cstring>
 #include <memory>
+#include <vector>
 #include <sstream>
+#include <initializer_list>
+#include <span>
+#include <optional>
+#include <utility>
 #include "Packets/FilePacket.h"
 #include "Packets/MailPacket.h"
 #include "../unordered_map/unordered_map.h"
+#include "../unordered_map/blocked_bloom_filter.h"
+
+/**
+ * @brief A transmission table key given by its parts, the receiver IP address and the packet type.
+ *
+ * Lets the table be searched without concatenating the parts into a temporary string.
+ */
+struct PacketKey {
+    std::string_view ip; /**< The receiver IP address. */
+    std::string_view type; /**< The packet type. */
+};
+
+/**
+ * @brief Transparent hash of transmission table keys.
+ *
+ * A PacketKey hashes to the same value as the concatenation of its parts. Keys are hashed by a
+ * FastHash with a random seed per instance, so every table lays out its keys differently and
+ * receiver addresses chosen to collide cannot degrade its probe sequences.
+ *
+ * A key is hashed in two steps: the IP address, everything up to the last digit, is hashed as a
+ * string, and the packet type after it is folded into that hash by a single multiplication. The
+ * hashes of the keys of one receiver can therefore be derived from one hashed IP address.
+ */
+struct PacketKeyHash {
+    using is_transparent = void; /**< Enables heterogeneous lookup in Unordered_map. */
+
+    FastHash hash; /**< The seeded string hash. */
+
+    /**
+     * @brief Hashes a concatenated key.
+     *
+     * @param key The receiver IP address followed by the packet type.
+     * @return The hash of the key.
+     */
+    std::size_t operator()(std::string_view key) const;
+
+    /**
+     * @brief Hashes a key given by its parts.
+     *
+     * @param key The parts of the key.
+     * @return The hash of the concatenated key.
+     */
+    std::size_t operator()(const PacketKey& key) const;
+
+    /**
+     * @brief Hashes the IP address part of a key.
+     *
+     * @param ip The receiver IP address, ending in a digit.
+     * @return The hash to pass to combine().
+     */
+    std::size_t hashIp(std::string_view ip) const;
+
+    /**
+     * @brief Derives the hash of a key from the hash of its IP address.
+     *
+     * @param ipHash The hash of the receiver IP address returned by hashIp().
+     * @param type The packet type, without digits.
+     * @return The hash of the concatenated key.
+     */
+    std::size_t combine(std::size_t ipHash, std::string_view type) const;
+
+    /**
+     * @brief Returns the IP address part of a concatenated key, up to its last digit.
+     *
+     * @param key The receiver IP address followed by the packet type.
+     * @return The receiver IP address.
+     */
+    static std::string_view ipOf(std::string_view key);
+
+    /**
+     * @brief Returns the packet type part of a concatenated key, after the last digit.
+     *
+     * @param key The receiver IP address followed by the packet type.
+     * @return The packet type.
+     */
+    static std::string_view typeOf(std::string_view key);
+};
+
+/**
+ * @brief Transparent comparison of transmission table keys.
+ */
+struct PacketKeyEqual {
+    using is_transparent = void; /**< Enables heterogeneous lookup in Unordered_map. */
+
+    /**
+     * @brief Compares two concatenated keys.
+     */
+    bool operator()(std::string_view lhs, std::string_view rhs) const;
+
+    /**
+     * @brief Compares a stored concatenated key with a key given by its parts.
+     */
+    bool operator()(std::string_view stored, const PacketKey& key) const;
+
+    /**
+     * @brief Compares a key given by its parts with a stored concatenated key.
+     */
+    bool operator()(const PacketKey& key, std::string_view stored) const;
+};
+
+/**
+ * @brief Options of the transmission table map: cached key hashes and incremental growth,
+ * so adding a packet never stalls on migrating the whole table, collected statistics,
+ * so lengthening probe sequences show up before latencies do, and copy-on-write snapshots,
+ * so dumps and statistics can read a consistent table while packets keep arriving.
+ */
+struct TransmissionTablePolicy : DefaultMapPolicy {
+    static constexpr bool store_hash = true;
+    static constexpr std::size_t resize_step = IncrementalResizeMapPolicy::resize_step;
+    static constexpr bool collect_stats = true;
+    static constexpr bool snapshots = true;
+};
 
 /**
  * @brief A class representing a transmission table for storing packets.
@@ -18,10 +139,36 @@
  */
 class TransmissionTable {
 public:
+    /**
+     * @brief Type of the underlying unordered map, keyed by the receiver IP address followed by the packet type.
+     *
+     * The slot array and the key strings share one memory resource.
+     */
+    using map_type = pmr::Unordered_map<std::pmr::string, std::shared_ptr<Packet>, PacketKeyHash, PacketKeyEqual, TransmissionTablePolicy>;
+
+    using Snapshot = map_type::snapshot_type; /**< Type of the copy-on-write snapshots of the table. */
+
+    static constexpr float minLoadFactor = 0.2f; /**< Load factor below which removing packets shrinks the table. */
+
     /**
      * @brief Default constructor.
      */
-    TransmissionTable() = default;
+    TransmissionTable();
+
+    /**
+     * @brief Constructs a transmission table allocating from a memory resource.
+     *
+     * @param resource The memory resource for the table and its keys, must outlive the table.
+     */
+    explicit TransmissionTable(std::pmr::memory_resource* resource);
+
+    /**
+     * @brief Copies a transmission table onto a memory resource.
+     *
+     * @param other The transmission table to copy.
+     * @param resource The memory resource for the copy and its keys, must outlive the copy.
+     */
+    TransmissionTable(const TransmissionTable& other, std::pmr::memory_resource* resource);
 
     /**
      * @brief Inserts a packet into the transmission table.
@@ -31,6 +178,17 @@ public:
      */
     bool insert(const std::shared_ptr<Packet>& packet);
 
+    /**
+     * @brief Inserts a burst of packets into the transmission table.
+     *
+     * The table grows at most once for the whole burst, and the slots of the packets are
+     * prefetched in batches before they are written.
+     *
+     * @param burst The packets to be inserted.
+     * @return The number of packets inserted; packets whose key is already present are skipped.
+     */
+    std::size_t insert(const std::vector<std::shared_ptr<Packet>>& burst);
+
     /**
      * @brief Finds a packet in the transmission table based on the receiver IP address and packet type.
      *
@@ -38,7 +196,15 @@ public:
      * @param type The packet type.
      * @return A shared pointer to the found packet, or nullptr if not found.
      */
-    std::shared_ptr<Packet> find(const std::string& ip, const std::string& type) const;
+    std::shared_ptr<Packet> find(std::string_view ip, std::string_view type) const;
+
+    /**
+     * @brief Finds the packets of a batch of keys, prefetching their slots in batches.
+     *
+     * @param keys The receiver IP addresses and packet types to look up.
+     * @return For every key in order, a shared pointer to the found packet, or nullptr if not found.
+     */
+    std::vector<std::shared_ptr<Packet>> find(const std::vector<PacketKey>& keys) const;
 
     /**
      * @brief Erases a packet from the transmission table based on the receiver IP address and packet type.
@@ -47,7 +213,68 @@ public:
      * @param type The packet type.
      * @return true if the erasure was successful, false otherwise.
      */
-    bool erase(const std::string& ip, const std::string& type);
+    bool erase(std::string_view ip, std::string_view type);
+
+    /**
+     * @brief Finds the packet of the first of several packet types present for a receiver.
+     *
+     * The receiver IP address is hashed once and the hashes of the individual keys are derived
+     * from it.
+     *
+     * @param ip The receiver IP address.
+     * @param types The packet types in order of priority.
+     * @return A shared pointer to the packet of the first type found, or nullptr if none is found.
+     */
+    std::shared_ptr<Packet> findFirst(std::string_view ip, std::span<const std::string_view> types) const;
+
+    /**
+     * @brief Finds the packet of the first of several packet types present for a receiver (list version).
+     */
+    std::shared_ptr<Packet> findFirst(std::string_view ip, std::initializer_list<std::string_view> types) const;
+
+    /**
+     * @brief Erases the packet of the first of several packet types present for a receiver.
+     *
+     * The receiver IP address is hashed once and the hashes of the individual keys are derived
+     * from it.
+     *
+     * @param ip The receiver IP address.
+     * @param types The packet types in order of priority.
+     * @return true if a packet was erased, false otherwise.
+     */
+    bool eraseFirst(std::string_view ip, std::span<const std::string_view> types);
+
+    /**
+     * @brief Erases the packet of the first of several packet types present for a receiver (list version).
+     */
+    bool eraseFirst(std::string_view ip, std::initializer_list<std::string_view> types);
+
+    /**
+     * @brief Removes a packet from the transmission table without destroying it.
+     *
+     * @param ip The receiver IP address.
+     * @param type The packet type.
+     * @return A node handle owning the key and the packet, empty if the packet was not found.
+     */
+    map_type::node_type extract(std::string_view ip, std::string_view type);
+
+    /**
+     * @brief Inserts a packet extracted from this or another transmission table.
+     *
+     * The packet pointer is moved, not copied. The key string is reused if both tables share a
+     * memory resource and copied into this table's resource otherwise.
+     *
+     * @param node The node handle, left empty if the insertion was successful.
+     * @return true if the insertion was successful, false if a packet with the same key is present.
+     */
+    bool insert(map_type::node_type&& node);
+
+    /**
+     * @brief Moves the packets of another transmission table whose keys are not present here into this one.
+     *
+     * @param other The table to take packets from; packets with keys already present stay there.
+     */
+    void merge(TransmissionTable& other);
 
     /**
      * @brief Checks if the transmission table is empty.
@@ -63,6 +290,14 @@ public:
      */
     std::size_t size() const;
 
+    /**
+     * @brief Shrinks the table and the receiver filter to the smallest size holding the current packets.
+     *
+     * Removing packets already shrinks both once the load drops below minLoadFactor; this
+     * releases the rest of the memory left over from a drained burst at once.
+     */
+    void shrinkToFit();
+
     /**
      * @brief Checks if the transmission table contains a packet based on the receiver IP address and packet type.
      *
@@ -70,7 +305,7 @@ public:
      * @param type The packet type.
      * @return true if the transmission table contains the packet, false otherwise.
      */
-    bool contains(const std::string& ip, const std::string& type) const;
+    bool contains(std::string_view ip, std::string_view type) const;
 
     /**
      * @brief Accesses a packet in the transmission table using the receiver IP address as the key.
@@ -102,31 +337,146 @@ public:
      *
      * @return An iterator to the beginning.
      */
-    Unordered_map<std::string, std::shared_ptr<Packet>>::iterator begin();
+    map_type::iterator begin();
 
     /**
      * @brief Returns a const iterator to the beginning of the transmission table.
      *
      * @return A const iterator to the beginning.
      */
-    Unordered_map<std::string, std::shared_ptr<Packet>>::const_iterator begin() const;
+    map_type::const_iterator begin() const;
 
     /**
      * @brief Returns an iterator to the end of the transmission table.
      *
      * @return An iterator to the end.
      */
-    Unordered_map<std::string, std::shared_ptr<Packet>>::iterator end();
+    map_type::iterator end();
 
     /**
      * @brief Returns a const iterator to the end of the transmission table.
      *
      * @return A const iterator to the end.
      */
-    Unordered_map<std::string, std::shared_ptr<Packet>>::const_iterator end() const;
+    map_type::const_iterator end() const;
+
+    /**
+     * @brief Splits the transmission table into ranges that can be scanned in parallel.
+     *
+     * @param count Number of ranges, at least 1.
+     * @return The ranges, together covering every packet exactly once.
+     */
+    std::vector<map_type::const_range> partitions(std::size_t count) const;
+
+    /**
+     * @brief Takes a snapshot of the packets without copying them.
+     *
+     * The snapshot may be read on another thread while packets keep being inserted and erased
+     * here; a page of the table is copied into it only when first changed or read. It must not
+     * outlive the memory resource of the table, see Unordered_map::snapshot.
+     *
+     * @return The snapshot.
+     */
+    Snapshot snapshot();
+
+    /**
+     * @brief Puts a Bloom filter of receiver IP addresses in front of the lookups.
+     *
+     * Lookups of receivers without packets are then answered from one cache line of the
+     * filter, without probing the table. The filter is built from the current packets and
+     * kept up to date by every modification, growing with the table.
+     *
+     * @param expectedPackets Number of packets to size the filter for initially.
+     */
+    void enableReceiverFilter(std::size_t expectedPackets = 1024);
+
+    /**
+     * @brief Removes the receiver filter, if any.
+     */
+    void disableReceiverFilter();
+
+    /**
+     * @brief Reports the memory use and hit rates of the receiver filter.
+     *
+     * A positive answer counts as false when the table then held no packet of any type for the
+     * receiver; a receiver with packets of other types than those requested was rightly passed.
+     *
+     * @return The statistics, all zero if the filter is disabled.
+     */
+    BlockedBloomFilter::Stats receiverFilterStats() const;
+
+    /**
+     * @brief Reports the probe lengths, occupancy and rehashes of the underlying map.
+     *
+     * Lookups answered by the receiver filter never reach the map and are not counted. Packets
+     * are erased at the position of a lookup, so their probes count as lookups.
+     *
+     * @return The statistics.
+     */
+    MapStats tableStats() const;
 
 private:
-    Unordered_map<std::string, std::shared_ptr<Packet>> packets; /**< The underlying unordered map storing packets. */
+    map_type packets; /**< The underlying unordered map storing packets. */
+    std::optional<BlockedBloomFilter> receivers; /**< Counting filter of the receiver IP addresses with packets, if enabled. */
+    std::vector<std::string> receiverTypes; /**< Packet types stored since the receiver filter was built, never shrinking. */
+
+    /**
+     * @brief Finds the packet of the first of several packet types present for a receiver.
+     *
+     * Asks the receiver filter first, if enabled, and hashes the IP address once for all types.
+     *
+     * @param ip The receiver IP address.
+     * @param types The packet types in order of priority.
+     * @return Iterator to the packet of the first type found, or the end iterator.
+     */
+    map_type::const_iterator lookup(std::string_view ip, std::span<const std::string_view> types) const;
+
+    /**
+     * @brief Counts a packet stored under a key in the receiver filter, if enabled.
+     *
+     * @param key The stored key.
+     */
+    void addReceiver(std::string_view key);
+
+    /**
+     * @brief Checks if a receiver that passed the receiver filter has a packet of any type.
+     *
+     * Tries the types stored since the filter was built that the lookup has not already tried, so
+     * a miss of the requested types is not taken for a false positive of the filter.
+     *
+     * @param ip The receiver IP address, as given to the lookup.
+     * @param checked The packet types the lookup found no packet of.
+     * @return True if the table holds a packet for the receiver.
+     */
+    bool hasReceiver(std::string_view ip, std::span<const std::string_view> checked) const;
+
+    /**
+     * @brief Uncounts a packet removed from under a key in the receiver filter, if enabled.
+     *
+     * @param key The key the packet was stored under.
+     */
+    void removeReceiver(std::string_view key);
+
+    /**
+     * @brief Shrinks the table and the receiver filter after removals left them sized for far more packets.
+     */
+    void shrinkAfterRemoval();
+
+    /**
+     * @brief Refills the receiver filter from the packets in the table, if enabled.
+     *
+     * @param capacity Number of packets to size the filter for, raised to the number of packets present.
+     */
+    void rebuildReceiverFilter(std::size_t capacity);
+
+    /**
+     * @brief Builds a stored key from the receiver IP address and the packet type.
+     *
+     * @param ip The receiver IP address.
+     * @param type The packet type.
+     * @return The concatenated key, allocated from the memory resource of the table.
+     */
+    map_type::key_type makeKey(std::string_view ip, std::string_view type) const;
 };
 
 #endif // TRANSMISSIONTABLE_H
@@ -1,7 +1,34 @@
 #include "../include/Server.h"
 
+Server::PacketStore::PacketStore() : transmissionTable(&packetMemory) {}
+
+Server::PacketStore::PacketStore(const TransmissionTable& table) : transmissionTable(table, &packetMemory) {}
+
+Server::Server() : packetStore(std::make_shared<PacketStore>()) {
+    packetStore->transmissionTable.enableReceiverFilter();
+}
+
 Server::Server(const std::string& name, const std::string& address)
-        : serverName(name), serverAddress(address) {}
+        : serverName(name), serverAddress(address), packetStore(std::make_shared<PacketStore>()) {
+    packetStore->transmissionTable.enableReceiverFilter();
+}
+
+Server::Server(const Server& other)
+        : serverName(other.serverName), serverAddress(other.serverAddress),
+          packetStore(std::make_shared<PacketStore>(other.packetStore->transmissionTable)) {}
+
+Server::Server(Server&& other) noexcept = default;
+
+Server& Server::operator=(const Server& other) {
+    if (this != &other) {
+        *this = Server(other);
+    }
+    return *this;
+}
+
+Server& Server::operator=(Server&& other) noexcept = default;
+
+Server::~Server() = default;
 
 std::string Server::getServerName() const {
     return serverName;
@@ -24,83 +51,128 @@ void Server::setIPAddress(const std::string& newServerAddress) {
 }
 
 bool Server::addPacketToTransmissionTable(const std::shared_ptr<Packet>& packet) {
-    return transmissionTable.insert(packet);
+    return packetStore->transmissionTable.insert(packet);
 }
 
 std::shared_ptr<Packet> Server::findByPriority(const std::string& ip) const {
-    std::shared_ptr<Packet> packet = nullptr;
-    if ((packet = transmissionTable.find(ip, "HT"))) return packet;
-    if ((packet = transmissionTable.find(ip, "F"))) return packet;
-    if ((packet = transmissionTable.find(ip, "M"))) return packet;
-    return nullptr;
+    return packetStore->transmissionTable.findFirst(ip, packetTypes.keys());
 }
 
 bool Server::eraseByPriority(const std::string& ip) {
-    if (transmissionTable.erase(ip, "HT")) return true;
-    if (transmissionTable.erase(ip, "F")) return true;
-    if (transmissionTable.erase(ip, "M")) return true;
-    return false;
+    return packetStore->transmissionTable.eraseFirst(ip, packetTypes.keys());
 }
 
 std::ostream& Server::showSendersInfo(std::ostream& os) const {
-    for (const auto& entry : transmissionTable) {
+    for (const auto& entry : packetStore->transmissionTable) {
         os << "Sender Address: " << entry.second->getSenderAddress() << std::endl;
     }
     return os;
 }
 
-float Server::calculatePacketTypePercentage(const std::string& type) const {
-    int totalPacketsOfType = 0;
-    int totalPackets = transmissionTable.size();
+std::ostream& Server::showSendersInfo(std::ostream& os, const TableSnapshot& snapshot) {
+    snapshot.table.for_each([&os](const auto& entry) {
+        os << "Sender Address: " << entry.second->getSenderAddress() << std::endl;
+    });
+    return os;
+}
+
+namespace {
+
+/**
+ * @brief Packet counts by position in Server::packetTypes, followed by the count of packets of other types.
+ */
+using TypeCounters = std::array<std::size_t, Server::packetTypes.size() + 1>;
+
+/**
+ * @brief Counts one packet by type.
+ *
+ * The type is read from the packet, as the key cannot be split into address and type when the
+ * receiver address does not end in a digit.
+ */
+template<class Entry>
+void countType(TypeCounters& counts, const Entry& entry) {
+    if (entry.second != nullptr) {
+        ++counts[Server::packetTypes.index_of(entry.second->getType())];
+    }
+}
 
-    for (const auto& entry : transmissionTable) {
-        if (entry.second->getType() == type) {
-            totalPacketsOfType++;
-        }
+/**
+ * @brief Counts the packets of a range by type.
+ */
+template<class Range>
+TypeCounters countTypes(const Range& range) {
+    TypeCounters counts{};
+    for (const auto& entry : range) {
+        countType(counts, entry);
     }
+    return counts;
+}
+
+/**
+ * @brief Counts the packets of a snapshot by type.
+ */
+TypeCounters countTypes(const TransmissionTable::Snapshot& snapshot) {
+    TypeCounters counts{};
+    snapshot.for_each([&counts](const auto& entry) { countType(counts, entry); });
+    return counts;
+}
+
+/**
+ * @brief Converts the count of packets of one type into a percentage of all packets.
+ */
+float typePercentage(const TypeCounters& counts, const std::string& type, std::size_t totalPackets) {
+    std::size_t index = Server::packetTypes.index_of(type);
+    std::size_t totalPacketsOfType = index < Server::packetTypes.size() ? counts[index] : 0;
+    return (static_cast<float>(totalPacketsOfType) / totalPackets) * 100.0f;
+}
 
-    float percentage = (static_cast<float>(totalPacketsOfType) / totalPackets) * 100.0f;
-    return percentage;
+}
+
+float Server::calculatePacketTypePercentage(const std::string& type) const {
+    return typePercentage(countTypes(packetStore->transmissionTable), type, packetStore->transmissionTable.size());
 }
 
 float Server::calculatePacketTypePercentageMT(const std::string& type) const {
-    unsigned int numThreads = std::thread::hardware_concurrency();
-
-    std::size_t totalPackets = transmissionTable.size();
-    std::size_t packetsPerThread = totalPackets / numThreads;
-
-    auto countPacketsOfType = [type](Unordered_map<std::string, std::shared_ptr<Packet>>::const_iterator begin, Unordered_map<std::string, std::shared_ptr<Packet>>::const_iterator end) {
-        int count = 0;
-        for (auto it = begin; it != end; ++it) {
-            if(it -> second != nullptr) {
-                if (it->second->getType() == type) {
-                    count++;
-                }
-            }
-        }
-        return count;
-    };
-
-    std::vector<std::future<int>> futures;
-    auto it = transmissionTable.begin();
-    for (unsigned int i = 0; i < numThreads; ++i) {
-        auto startIt = it;
-        std::advance(it, packetsPerThread);
-        auto endIt = (i == numThreads - 1) ? transmissionTable.end() : it;
-        futures.emplace_back(std::async(std::launch::async, countPacketsOfType, startIt, endIt));
+    unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::future<TypeCounters>> futures;
+    for (const auto& range : packetStore->transmissionTable.partitions(numThreads)) {
+        futures.emplace_back(std::async(std::launch::async, countTypes<TransmissionTable::map_type::const_range>, range));
     }
 
-    int totalCount = std::accumulate(futures.begin(), futures.end(), 0, [](int sum, std::future<int>& f) {
-        return sum + f.get();
-    });
+    TypeCounters counts{};
+    for (auto& future : futures) {
+        TypeCounters partial = future.get();
+        std::transform(counts.begin(), counts.end(), partial.begin(), counts.begin(), std::plus<>());
+    }
+    return typePercentage(counts, type, packetStore->transmissionTable.size());
+}
+
+Server::PacketTypeCounts Server::getPacketTypeCounts() const {
+    TypeCounters counts = countTypes(packetStore->transmissionTable);
+    PacketTypeCounts result;
+    std::copy_n(counts.begin(), result.size(), result.begin());
+    return result;
+}
+
+MapStats Server::getTableStats() const {
+    return packetStore->transmissionTable.tableStats();
+}
+
+Server::TableSnapshot Server::snapshotTable() {
+    return {std::shared_ptr<std::pmr::memory_resource>(packetStore, &packetStore->packetMemory), packetStore->transmissionTable.snapshot()};
+}
 
-    float percentage = (static_cast<float>(totalCount) / totalPackets) * 100.0f;
-    return percentage;
+Server::PacketTypeCounts Server::getPacketTypeCounts(const TableSnapshot& snapshot) {
+    TypeCounters counts = countTypes(snapshot.table);
+    PacketTypeCounts result;
+    std::copy_n(counts.begin(), result.size(), result.begin());
+    return result;
 }
 
 std::ostream& operator<<(std::ostream& os, const Server& server) {
     os << server.getServerName() << " - " << server.getServerAddress() << std::endl;
-    os << server.transmissionTable;
+    os << server.packetStore->transmissionTable;
     return os;
 }
 
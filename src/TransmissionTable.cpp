@@ -1,20 +1,216 @@
 #include "../include/TransmissionTable.h"
 
+namespace {
+
+/**
+ * @brief Returns the length of the IP address part of a concatenated key, up to its last digit.
+ */
+std::size_t ipLength(std::string_view key) {
+    std::size_t digit = key.find_last_of("0123456789");
+    return digit == std::string_view::npos ? 0 : digit + 1;
+}
+
+/**
+ * @brief Hashes a key given by its parts, deriving the hash from a precomputed IP address hash when the parts allow it.
+ */
+std::size_t keyHash(const PacketKeyHash& hash, std::size_t ipHash, const PacketKey& key) {
+    if (ipLength(key.ip) == key.ip.size() && ipLength(key.type) == 0) {
+        return hash.combine(ipHash, key.type);
+    }
+    return hash(key);
+}
+
+/**
+ * @brief Checks that no packet type contains a digit, so keys made with them split where their IP address ends.
+ */
+bool digitFree(std::span<const std::string_view> types) {
+    return std::all_of(types.begin(), types.end(), [](std::string_view type) { return ipLength(type) == 0; });
+}
+
+/**
+ * @brief Appends a packet type to a list of types unless it is already there.
+ */
+void addType(std::vector<std::string>& types, std::string_view type) {
+    if (std::find(types.begin(), types.end(), type) == types.end())
+        types.emplace_back(type);
+}
+
+}
+
+std::size_t PacketKeyHash::operator()(std::string_view key) const {
+    std::size_t length = ipLength(key);
+    return combine(hashIp(key.substr(0, length)), key.substr(length));
+}
+
+std::size_t PacketKeyHash::operator()(const PacketKey& key) const {
+    if (ipLength(key.ip) == key.ip.size() && ipLength(key.type) == 0) {
+        return combine(hashIp(key.ip), key.type);
+    }
+    // The parts do not split where the concatenation does, so the concatenation is hashed.
+    char buffer[64];
+    std::size_t length = key.ip.size() + key.type.size();
+    if (length > sizeof(buffer)) {
+        std::string joined;
+        joined.reserve(length);
+        joined.append(key.ip).append(key.type);
+        return (*this)(std::string_view(joined));
+    }
+    std::memcpy(buffer, key.ip.data(), key.ip.size());
+    std::memcpy(buffer + key.ip.size(), key.type.data(), key.type.size());
+    return (*this)(std::string_view(buffer, length));
+}
+
+std::string_view PacketKeyHash::ipOf(std::string_view key) {
+    return key.substr(0, ipLength(key));
+}
+
+std::string_view PacketKeyHash::typeOf(std::string_view key) {
+    return key.substr(ipLength(key));
+}
+
+std::size_t PacketKeyHash::hashIp(std::string_view ip) const {
+    return hash(ip);
+}
+
+std::size_t PacketKeyHash::combine(std::size_t ipHash, std::string_view type) const {
+    std::uint64_t bits;
+    if (type.size() < sizeof(bits)) {
+        bits = static_cast<std::uint64_t>(type.size()) << 56;
+        std::memcpy(&bits, type.data(), type.size());
+    } else {
+        bits = hash(type);
+    }
+    return hash(ipHash ^ bits);
+}
+
+bool PacketKeyEqual::operator()(std::string_view lhs, std::string_view rhs) const {
+    return lhs == rhs;
+}
+
+bool PacketKeyEqual::operator()(std::string_view stored, const PacketKey& key) const {
+    return stored.size() == key.ip.size() + key.type.size() &&
+           stored.starts_with(key.ip) && stored.ends_with(key.type);
+}
+
+bool PacketKeyEqual::operator()(const PacketKey& key, std::string_view stored) const {
+    return (*this)(stored, key);
+}
+
+TransmissionTable::TransmissionTable() : TransmissionTable(std::pmr::get_default_resource()) {}
+
+TransmissionTable::TransmissionTable(std::pmr::memory_resource* resource) : packets(map_type::allocator_type(resource)) {
+    packets.min_load_factor(minLoadFactor);
+}
+
+TransmissionTable::TransmissionTable(const TransmissionTable& other, std::pmr::memory_resource* resource)
+        : packets(other.packets, map_type::allocator_type(resource)), receivers(other.receivers), receiverTypes(other.receiverTypes) {}
+
+TransmissionTable::map_type::key_type TransmissionTable::makeKey(std::string_view ip, std::string_view type) const {
+    map_type::key_type key(packets.get_allocator());
+    key.reserve(ip.size() + type.size());
+    key.append(ip).append(type);
+    return key;
+}
+
 bool TransmissionTable::insert(const std::shared_ptr<Packet>& packet) {
-    std::stringstream ss;
-    ss << packet->getReceiverAddress() << packet->getType();
-    return packets.insert(std::make_pair(ss.str(), packet)).second;
+    auto [it, inserted] = packets.insert({makeKey(packet->getReceiverAddress(), packet->getType()), packet});
+    if (inserted)
+        addReceiver(it->first);
+    return inserted;
+}
+
+std::size_t TransmissionTable::insert(const std::vector<std::shared_ptr<Packet>>& burst) {
+    std::vector<map_type::value_type> entries;
+    entries.reserve(burst.size());
+    for (const auto& packet : burst) {
+        entries.emplace_back(makeKey(packet->getReceiverAddress(), packet->getType()), packet);
+    }
+    std::vector<std::size_t> receiverHashes;
+    if (receivers) {
+        receiverHashes.reserve(entries.size());
+        for (const auto& entry : entries) {
+            receiverHashes.push_back(packets.hash_function().hashIp(PacketKeyHash::ipOf(entry.first)));
+        }
+    }
+    std::size_t inserted = packets.insert_bulk(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+    if (receivers) {
+        // Which packets were skipped as duplicates is not known, so a burst with duplicates rebuilds the filter.
+        if (inserted != entries.size() || receivers->size() + inserted > receivers->capacity()) {
+            rebuildReceiverFilter(std::max(receivers->capacity(), packets.size() * 2));
+        } else {
+            for (std::size_t receiverHash : receiverHashes) {
+                receivers->add(receiverHash);
+            }
+        }
+    }
+    return inserted;
+}
+
+std::shared_ptr<Packet> TransmissionTable::find(std::string_view ip, std::string_view type) const {
+    return findFirst(ip, {type});
 }
 
-std::shared_ptr<Packet> TransmissionTable::find(const std::string& ip, const std::string& type) const {
-    auto it = packets.find(ip + type);
+std::vector<std::shared_ptr<Packet>> TransmissionTable::find(const std::vector<PacketKey>& keys) const {
+    std::vector<map_type::const_iterator> found;
+    found.reserve(keys.size());
+    packets.find_many(keys.begin(), keys.end(), std::back_inserter(found));
+    std::vector<std::shared_ptr<Packet>> result;
+    result.reserve(keys.size());
+    for (const auto& it : found) {
+        result.push_back(it != packets.end() ? it->second : nullptr);
+    }
+    return result;
+}
+
+bool TransmissionTable::erase(std::string_view ip, std::string_view type) {
+    return eraseFirst(ip, {type});
+}
+
+std::shared_ptr<Packet> TransmissionTable::findFirst(std::string_view ip, std::span<const std::string_view> types) const {
+    auto it = lookup(ip, types);
     if (it != packets.end())
         return it->second;
     return nullptr;
 }
 
-bool TransmissionTable::erase(const std::string& ip, const std::string& type) {
-    return packets.erase(ip + type);
+std::shared_ptr<Packet> TransmissionTable::findFirst(std::string_view ip, std::initializer_list<std::string_view> types) const {
+    return findFirst(ip, std::span(types.begin(), types.size()));
+}
+
+bool TransmissionTable::eraseFirst(std::string_view ip, std::initializer_list<std::string_view> types) {
+    return eraseFirst(ip, std::span(types.begin(), types.size()));
+}
+
+bool TransmissionTable::eraseFirst(std::string_view ip, std::span<const std::string_view> types) {
+    auto it = lookup(ip, types);
+    if (it == packets.end())
+        return false;
+    removeReceiver(it->first);
+    packets.erase(it);
+    shrinkAfterRemoval();
+    return true;
+}
+
+TransmissionTable::map_type::node_type TransmissionTable::extract(std::string_view ip, std::string_view type) {
+    auto node = packets.extract(PacketKey{ip, type});
+    if (node) {
+        removeReceiver(node.key());
+        shrinkAfterRemoval();
+    }
+    return node;
+}
+
+bool TransmissionTable::insert(map_type::node_type&& node) {
+    auto result = packets.insert(std::move(node));
+    if (result.inserted)
+        addReceiver(result.position->first);
+    return result.inserted;
+}
+
+void TransmissionTable::merge(TransmissionTable& other) {
+    packets.merge(other.packets);
+    rebuildReceiverFilter(receivers ? receivers->capacity() : 0);
+    other.rebuildReceiverFilter(other.receivers ? other.receivers->capacity() : 0);
 }
 
 bool TransmissionTable::empty() const {
@@ -25,16 +221,27 @@ std::size_t TransmissionTable::size() const {
     return packets.size();
 }
 
-bool TransmissionTable::contains(const std::string& ip, const std::string& type) const {
-    return packets.contains(ip + type);
+void TransmissionTable::shrinkToFit() {
+    packets.shrink_to_fit();
+    rebuildReceiverFilter(packets.size());
+}
+
+bool TransmissionTable::contains(std::string_view ip, std::string_view type) const {
+    return lookup(ip, std::span(&type, 1)) != packets.end();
 }
 
 std::shared_ptr<Packet>& TransmissionTable::operator[](std::pair<const std::string&, const std::string&> key_and_value) {
-    return packets[key_and_value.first + key_and_value.second];
+    auto it = packets.find(PacketKey{key_and_value.first, key_and_value.second});
+    if (it != packets.end())
+        return it->second;
+    auto [inserted, done] = packets.try_emplace(makeKey(key_and_value.first, key_and_value.second));
+    if (done)
+        addReceiver(inserted->first);
+    return inserted->second;
 }
 
 const std::shared_ptr<Packet>& TransmissionTable::operator[](std::pair<const std::string&, const std::string&> key_and_value) const {
-    auto it = packets.find(key_and_value.first + key_and_value.second);
+    auto it = packets.find(PacketKey{key_and_value.first, key_and_value.second});
     if (it != packets.end()) {
         return it->second;
     } else {
@@ -50,18 +257,108 @@ std::ostream& operator<<(std::ostream& os, const TransmissionTable& table) {
     return os;
 }
 
-Unordered_map<std::string, std::shared_ptr<Packet>>::iterator TransmissionTable::begin() {
+TransmissionTable::map_type::iterator TransmissionTable::begin() {
     return packets.begin();
 }
 
-Unordered_map<std::string, std::shared_ptr<Packet>>::const_iterator TransmissionTable::begin() const {
+TransmissionTable::map_type::const_iterator TransmissionTable::begin() const {
     return packets.begin();
 }
 
-Unordered_map<std::string, std::shared_ptr<Packet>>::iterator TransmissionTable::end() {
+TransmissionTable::map_type::iterator TransmissionTable::end() {
     return packets.end();
 }
 
-Unordered_map<std::string, std::shared_ptr<Packet>>::const_iterator TransmissionTable::end() const {
+TransmissionTable::map_type::const_iterator TransmissionTable::end() const {
     return packets.end();
 }
+
+std::vector<TransmissionTable::map_type::const_range> TransmissionTable::partitions(std::size_t count) const {
+    return packets.partitions(count);
+}
+
+TransmissionTable::Snapshot TransmissionTable::snapshot() {
+    return packets.snapshot();
+}
+
+void TransmissionTable::enableReceiverFilter(std::size_t expectedPackets) {
+    receivers.emplace(expectedPackets);
+    rebuildReceiverFilter(expectedPackets);
+}
+
+void TransmissionTable::disableReceiverFilter() {
+    receivers.reset();
+    receiverTypes.clear();
+}
+
+BlockedBloomFilter::Stats TransmissionTable::receiverFilterStats() const {
+    return receivers ? receivers->stats() : BlockedBloomFilter::Stats{};
+}
+
+MapStats TransmissionTable::tableStats() const {
+    return packets.stats();
+}
+
+TransmissionTable::map_type::const_iterator TransmissionTable::lookup(std::string_view ip, std::span<const std::string_view> types) const {
+    PacketKeyHash hash = packets.hash_function();
+    std::size_t ipHash = hash.hashIp(ip);
+    // The filter counts the stored keys under their IP address part, which is ip cut after its last digit.
+    bool filtered = receivers && digitFree(types);
+    if (filtered && !receivers->might_contain(PacketKeyHash::ipOf(ip).size() == ip.size() ? ipHash : hash.hashIp(PacketKeyHash::ipOf(ip))))
+        return packets.end();
+    for (std::string_view type : types) {
+        auto it = packets.find(PacketKey{ip, type}, keyHash(hash, ipHash, PacketKey{ip, type}));
+        if (it != packets.end())
+            return it;
+    }
+    if (filtered && !hasReceiver(ip, types))
+        receivers->report_false_positive();
+    return packets.end();
+}
+
+bool TransmissionTable::hasReceiver(std::string_view ip, std::span<const std::string_view> checked) const {
+    PacketKeyHash hash = packets.hash_function();
+    std::string_view receiver = PacketKeyHash::ipOf(ip);
+    std::size_t ipHash = hash.hashIp(receiver);
+    // The checked types were probed under the same keys only if ip is its own IP address part.
+    if (receiver.size() != ip.size())
+        checked = {};
+    return std::any_of(receiverTypes.begin(), receiverTypes.end(), [&](const std::string& type) {
+        if (std::find(checked.begin(), checked.end(), type) != checked.end())
+            return false;
+        PacketKey key{receiver, type};
+        return packets.find(key, keyHash(hash, ipHash, key)) != packets.end();
+    });
+}
+
+void TransmissionTable::addReceiver(std::string_view key) {
+    if (!receivers)
+        return;
+    receivers->add(packets.hash_function().hashIp(PacketKeyHash::ipOf(key)));
+    addType(receiverTypes, PacketKeyHash::typeOf(key));
+    if (receivers->size() > receivers->capacity())
+        rebuildReceiverFilter(receivers->capacity() * 2);
+}
+
+void TransmissionTable::removeReceiver(std::string_view key) {
+    if (receivers)
+        receivers->remove(packets.hash_function().hashIp(PacketKeyHash::ipOf(key)));
+}
+
+void TransmissionTable::shrinkAfterRemoval() {
+    packets.shrink_if_underloaded();
+    if (receivers && receivers->capacity() > 4 * packets.size())
+        rebuildReceiverFilter(2 * packets.size());
+}
+
+void TransmissionTable::rebuildReceiverFilter(std::size_t capacity) {
+    if (!receivers)
+        return;
+    PacketKeyHash hash = packets.hash_function();
+    receivers->reset(std::max(capacity, packets.size()));
+    receiverTypes.clear();
+    for (const auto& entry : std::as_const(packets)) {
+        receivers->add(hash.hashIp(PacketKeyHash::ipOf(entry.first)));
+        addType(receiverTypes, PacketKeyHash::typeOf(entry.first));
+    }
+}
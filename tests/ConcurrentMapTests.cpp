@@ -0,0 +1,63 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../unordered_map/concurrent_unordered_map.h"
+
+TEST_CASE("Test ConcurrentUnordered_map methods", "[ConcurrentUnordered_map]") {
+    ConcurrentUnordered_map<std::string, int> map(8);
+    REQUIRE(map.shard_count() == 8);
+    REQUIRE(map.empty());
+
+    SECTION("Test insert, find and erase") {
+        REQUIRE(map.insert({"192.168.1.1HT", 1}));
+        REQUIRE_FALSE(map.insert({"192.168.1.1HT", 2}));
+        REQUIRE(map.emplace("192.168.1.2F", 3));
+        REQUIRE(map.size() == 2);
+        REQUIRE(map.find("192.168.1.1HT") == 1);
+        REQUIRE_FALSE(map.find("192.168.1.3M").has_value());
+        REQUIRE(map.contains("192.168.1.2F"));
+        REQUIRE(map.erase("192.168.1.2F") == 1);
+        REQUIRE(map.erase("192.168.1.2F") == 0);
+        REQUIRE(map.size() == 1);
+    }
+
+    SECTION("Test visit and for_each") {
+        map.insert({"a", 1});
+        map.insert({"b", 2});
+        REQUIRE(map.visit("a", [](int& value) { value += 10; }));
+        REQUIRE_FALSE(map.visit("c", [](int&) {}));
+        int sum = 0;
+        map.for_each([&](const std::pair<std::string, int>& entry) { sum += entry.second; });
+        REQUIRE(sum == 13);
+        map.clear();
+        REQUIRE(map.empty());
+    }
+}
+
+TEST_CASE("Test ConcurrentUnordered_map with concurrent writers", "[ConcurrentUnordered_map]") {
+    ConcurrentUnordered_map<int, int> map(16);
+    const int threads = 4;
+    const int perThread = 20000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&map, t] {
+            for (int i = t * perThread; i < (t + 1) * perThread; ++i) {
+                map.insert({i, i});
+                map.contains(i / 2);
+                if (i % 4 == 0) {
+                    map.erase(i);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    REQUIRE(map.size() == threads * perThread * 3 / 4);
+    for (int i = 0; i < threads * perThread; ++i) {
+        REQUIRE(map.contains(i) == (i % 4 != 0));
+    }
+}
@@ -1,6 +1,19 @@
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <set>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 #include "../unordered_map/unordered_map.h"
+#include "../unordered_map/blocked_bloom_filter.h"
+#include "../unordered_map/static_map.h"
 
 TEST_CASE("Test Unordered_map default constructor", "[Unordered_map]") {
     Unordered_map<int, int> map;
@@ -56,7 +69,6 @@ TEST_CASE("Test Unordered_map erase", "[Unordered_map]") {
     SECTION("Test erase by iterator") {
         auto it = map.find(2);
         map.erase(it);
-        std::cout << map.find(2) -> second;
         REQUIRE(map.size() == 2);
         REQUIRE(map.capacity() == 4);
         REQUIRE(map.find(2) == map.end());
@@ -106,6 +118,67 @@ TEST_CASE("Test Unordered_map subscript operator", "[Unordered_map]") {
     }
 }
 
+struct CountedValue {
+    static inline int constructed = 0;
+    static inline int assigned = 0;
+    int value;
+    CountedValue() : value(0) { ++constructed; }
+    explicit CountedValue(int value) : value(value) { ++constructed; }
+    CountedValue(const CountedValue& other) : value(other.value) { ++constructed; }
+    CountedValue& operator=(const CountedValue& other) {
+        value = other.value;
+        ++assigned;
+        return *this;
+    }
+};
+
+TEST_CASE("Test Unordered_map try_emplace and insert_or_assign", "[Unordered_map]") {
+    CountedValue::constructed = 0;
+    CountedValue::assigned = 0;
+    Unordered_map<std::string, CountedValue> map;
+
+    SECTION("Test try_emplace constructs the value in place only when inserting") {
+        auto [it, inserted] = map.try_emplace("one", 1);
+        REQUIRE(inserted);
+        REQUIRE(it->second.value == 1);
+        REQUIRE(CountedValue::constructed == 1);
+        std::string key = "one";
+        auto [again, insertedAgain] = map.try_emplace(std::move(key), 2);
+        REQUIRE_FALSE(insertedAgain);
+        REQUIRE(again == it);
+        REQUIRE(again->second.value == 1);
+        REQUIRE(key == "one");
+        REQUIRE(CountedValue::constructed == 1);
+    }
+
+    SECTION("Test insert_or_assign assigns to an existing value") {
+        REQUIRE(map.insert_or_assign("one", CountedValue(1)).second);
+        REQUIRE(CountedValue::assigned == 0);
+        auto [it, inserted] = map.insert_or_assign("one", CountedValue(2));
+        REQUIRE_FALSE(inserted);
+        REQUIRE(it->second.value == 2);
+        REQUIRE(CountedValue::assigned == 1);
+        REQUIRE(map.size() == 1);
+    }
+
+    SECTION("Test subscript operator inserts a value-initialized value once") {
+        map["one"].value = 7;
+        REQUIRE(CountedValue::constructed == 1);
+        REQUIRE(map["one"].value == 7);
+        REQUIRE(CountedValue::constructed == 1);
+        REQUIRE(map.size() == 1);
+    }
+
+    SECTION("Test move-only values") {
+        Unordered_map<int, std::unique_ptr<int>> owners;
+        REQUIRE(owners.try_emplace(1, std::make_unique<int>(1)).second);
+        auto replacement = std::make_unique<int>(2);
+        REQUIRE_FALSE(owners.insert_or_assign(1, std::move(replacement)).second);
+        REQUIRE(*owners[1] == 2);
+        REQUIRE(owners[2] == nullptr);
+    }
+}
+
 TEST_CASE("Test Unordered_map count", "[Unordered_map]") {
     Unordered_map<int, std::string> map;
     map.insert({1, "one"});
@@ -214,6 +287,74 @@ TEST_CASE("Test Unordered_map merge", "[Unordered_map]") {
     }
 }
 
+TEMPLATE_TEST_CASE("Test Unordered_map node extraction and splicing", "[Unordered_map]", DefaultMapPolicy, RobinHoodMapPolicy, IncrementalResizeMapPolicy, StoredHashMapPolicy) {
+    using Map = Unordered_map<std::string, std::shared_ptr<int>, std::hash<std::string>, std::equal_to<std::string>, TestType>;
+    Map map;
+    for (int i = 0; i < 100; ++i) {
+        map.insert({"key" + std::to_string(i), std::make_shared<int>(i)});
+    }
+
+    SECTION("Test extracting by key and reinserting") {
+        auto value = map.find("key7")->second;
+        auto node = map.extract("key7");
+        REQUIRE(node);
+        REQUIRE(node.key() == "key7");
+        REQUIRE(node.mapped() == value);
+        REQUIRE(value.use_count() == 2);
+        REQUIRE(map.size() == 99);
+        REQUIRE_FALSE(map.contains("key7"));
+        REQUIRE(map.extract("key7").empty());
+
+        node.key() = "renamed";
+        auto result = map.insert(std::move(node));
+        REQUIRE(result.inserted);
+        REQUIRE(result.node.empty());
+        REQUIRE(node.empty());
+        REQUIRE(result.position->second == value);
+        REQUIRE(value.use_count() == 2);
+        REQUIRE(map.at("renamed") == value);
+    }
+
+    SECTION("Test extracting by iterator") {
+        auto it = map.find("key3");
+        auto node = map.extract(typename Map::const_iterator(it));
+        REQUIRE(*node.mapped() == 3);
+        REQUIRE(map.size() == 99);
+    }
+
+    SECTION("Test inserting a node with a present key hands it back") {
+        auto node = map.extract("key1");
+        map.insert({"key1", std::make_shared<int>(-1)});
+        auto result = map.insert(std::move(node));
+        REQUIRE_FALSE(result.inserted);
+        REQUIRE(*result.position->second == -1);
+        REQUIRE(*result.node.mapped() == 1);
+        REQUIRE_FALSE(map.insert(typename Map::node_type()).inserted);
+    }
+
+    SECTION("Test merge leaves conflicting elements in the source") {
+        Map other;
+        auto kept = std::make_shared<int>(-5);
+        other.insert({"key5", kept});
+        for (int i = 100; i < 300; ++i) {
+            other.insert({"key" + std::to_string(i), std::make_shared<int>(i)});
+        }
+        auto moved = other.find("key150")->second;
+        map.merge(other);
+        REQUIRE(map.size() == 300);
+        REQUIRE(other.size() == 1);
+        REQUIRE(other.at("key5") == kept);
+        REQUIRE(*map.at("key5") == 5);
+        REQUIRE(map.at("key150") == moved);
+        REQUIRE(moved.use_count() == 2);
+        for (int i = 0; i < 300; ++i) {
+            REQUIRE(*map.at("key" + std::to_string(i)) == (i == 5 ? 5 : i));
+        }
+        map.merge(map);
+        REQUIRE(map.size() == 300);
+    }
+}
+
 TEST_CASE("Test Unordered_map clear", "[Unordered_map]") {
     Unordered_map<int, std::string> map;
     map.insert({1, "one"});
@@ -473,3 +614,1507 @@ TEST_CASE("Unordered_map tests", "[Unordered_map]") {
         }
     }
 }
+
+TEST_CASE("Test Unordered_map probing across control groups", "[Unordered_map]") {
+    Unordered_map<std::string, int> map;
+    for (int i = 0; i < 1000; ++i) {
+        map.insert({"192.168.0." + std::to_string(i), i});
+    }
+
+    SECTION("Test finding all elements") {
+        REQUIRE(map.size() == 1000);
+        for (int i = 0; i < 1000; ++i) {
+            auto it = map.find("192.168.0." + std::to_string(i));
+            REQUIRE(it != map.end());
+            REQUIRE(it->second == i);
+        }
+        REQUIRE(map.find("10.0.0.1") == map.end());
+    }
+
+    SECTION("Test erasing and reinserting elements") {
+        for (int i = 0; i < 1000; i += 2) {
+            REQUIRE(map.erase("192.168.0." + std::to_string(i)) == 1);
+        }
+        REQUIRE(map.size() == 500);
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(map.contains("192.168.0." + std::to_string(i)) == (i % 2 == 1));
+        }
+        for (int i = 0; i < 1000; i += 2) {
+            REQUIRE(map.insert({"192.168.0." + std::to_string(i), -i}).second);
+        }
+        REQUIRE(map.size() == 1000);
+        REQUIRE(map.at("192.168.0.10") == -10);
+
+        int count = 0;
+        for (auto it = map.begin(); it != map.end(); ++it) {
+            count++;
+        }
+        REQUIRE(count == 1000);
+    }
+}
+
+TEST_CASE("Test Unordered_map hash fragments of small integer keys", "[Unordered_map]") {
+    std::set<std::int8_t> fragments;
+    for (int key = 0; key < 256; ++key) {
+        std::int8_t fragment = Ctrl::h2(ModuloCapacity::mix(std::hash<int>{}(key)));
+        REQUIRE(Ctrl::is_full(fragment));
+        fragments.insert(fragment);
+    }
+    REQUIRE(fragments.size() > 64);
+
+    Unordered_map<int, int> map;
+    for (int key = 0; key < 256; ++key) {
+        map.insert({key, key});
+    }
+    for (int key = 0; key < 256; ++key) {
+        REQUIRE(map.at(key) == key);
+    }
+    REQUIRE(map.find(256) == map.end());
+}
+
+struct CollidingHash {
+    std::size_t operator()(int key) const {
+        return static_cast<std::size_t>(key / 8);
+    }
+};
+
+TEST_CASE("Test Unordered_map Robin Hood policy", "[Unordered_map]") {
+    Unordered_map<int, std::string, CollidingHash, std::equal_to<int>, RobinHoodMapPolicy> map;
+    for (int i = 0; i < 200; ++i) {
+        map.insert({i, std::to_string(i)});
+    }
+
+    SECTION("Test finding elements of long clusters") {
+        REQUIRE(map.size() == 200);
+        for (int i = 0; i < 200; ++i) {
+            REQUIRE(map.at(i) == std::to_string(i));
+        }
+        REQUIRE_FALSE(map.contains(200));
+    }
+
+    SECTION("Test backward-shift erase") {
+        for (int i = 0; i < 200; i += 3) {
+            REQUIRE(map.erase(i) == 1);
+        }
+        for (int i = 0; i < 200; ++i) {
+            REQUIRE(map.contains(i) == (i % 3 != 0));
+        }
+        for (int i = 0; i < 200; i += 3) {
+            REQUIRE(map.insert({i, "again"}).second);
+        }
+        REQUIRE(map.size() == 200);
+        REQUIRE(map.at(99) == "again");
+        REQUIRE(map.at(100) == "100");
+    }
+
+    SECTION("Test erase while iterating") {
+        std::size_t visited = 0;
+        for (auto it = map.begin(); it != map.end();) {
+            it = map.erase(it);
+            ++visited;
+        }
+        REQUIRE(visited == 200);
+        REQUIRE(map.empty());
+    }
+}
+
+TEST_CASE("Test Unordered_map Robin Hood erase while iterating a wrapped cluster", "[Unordered_map]") {
+    Unordered_map<int, int, std::hash<int>, std::equal_to<int>, RobinHoodMapPolicy> map;
+    map.reserve(16);
+    int capacity = static_cast<int>(map.capacity());
+    // Keys congruent to capacity - 1 start a cluster in the last slot that wraps around to the first slots.
+    std::vector<int> keys;
+    for (int i = 0; i < 4; ++i) {
+        keys.push_back(capacity - 1 + i * capacity);
+    }
+    keys.push_back(0);
+    keys.push_back(1);
+    for (int key : keys) {
+        map.insert({key, key});
+    }
+
+    SECTION("Test erasing every other element") {
+        std::map<int, int> visits;
+        std::set<int> erased;
+        for (auto it = map.begin(); it != map.end();) {
+            ++visits[it->first];
+            if (visits.size() % 2 == 1) {
+                erased.insert(it->first);
+                it = map.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        REQUIRE(visits.size() == keys.size());
+        for (auto [key, count] : visits) {
+            REQUIRE(count == 1);
+        }
+        REQUIRE(map.size() == keys.size() / 2);
+        for (int key : keys) {
+            REQUIRE(map.contains(key) == (erased.count(key) == 0));
+        }
+        for (int key : keys) {
+            map.insert({key, -key});
+        }
+        REQUIRE(map.size() == keys.size());
+        for (int key : keys) {
+            REQUIRE(map.contains(key));
+        }
+    }
+
+    SECTION("Test erasing every element") {
+        std::map<int, int> visits;
+        for (auto it = map.begin(); it != map.end();) {
+            ++visits[it->first];
+            it = map.erase(it);
+        }
+        REQUIRE(visits.size() == keys.size());
+        for (auto [key, count] : visits) {
+            REQUIRE(count == 1);
+        }
+        REQUIRE(map.empty());
+        map.insert({capacity - 1, 0});
+        REQUIRE(map.at(capacity - 1) == 0);
+    }
+
+    SECTION("Test random erasures") {
+        std::mt19937 rng(7);
+        for (int round = 0; round < 200; ++round) {
+            map.clear();
+            std::vector<int> inserted;
+            for (int i = 0; i < 12; ++i) {
+                int key = static_cast<int>(rng() % 64);
+                if (map.insert({key, key}).second) {
+                    inserted.push_back(key);
+                }
+            }
+            std::map<int, int> visits;
+            std::vector<int> kept;
+            for (auto it = map.begin(); it != map.end();) {
+                ++visits[it->first];
+                if (rng() % 2 == 0) {
+                    it = map.erase(it);
+                } else {
+                    kept.push_back(it->first);
+                    ++it;
+                }
+            }
+            REQUIRE(visits.size() == inserted.size());
+            for (auto [key, count] : visits) {
+                REQUIRE(count == 1);
+            }
+            REQUIRE(map.size() == kept.size());
+            for (int key : kept) {
+                REQUIRE(map.at(key) == key);
+            }
+        }
+    }
+}
+
+TEST_CASE("Test Unordered_map power-of-two capacity policy", "[Unordered_map]") {
+    Unordered_map<int, std::string, std::hash<int>, std::equal_to<int>, PowerOfTwoMapPolicy> map;
+
+    SECTION("Test reserve rounds up to a power of two") {
+        map.reserve(10);
+        REQUIRE(map.capacity() == 16);
+        REQUIRE(map.empty());
+    }
+
+    SECTION("Test inserting, finding and erasing elements") {
+        for (int i = 0; i < 1000; ++i) {
+            map.insert({i * 64, std::to_string(i)});
+        }
+        REQUIRE(map.size() == 1000);
+        REQUIRE(std::has_single_bit(map.capacity()));
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(map.at(i * 64) == std::to_string(i));
+        }
+        for (int i = 0; i < 1000; i += 2) {
+            REQUIRE(map.erase(i * 64) == 1);
+        }
+        REQUIRE(map.size() == 500);
+        REQUIRE_FALSE(map.contains(0));
+        REQUIRE(map.contains(64));
+    }
+}
+
+struct TransparentStringHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view key) const {
+        return std::hash<std::string_view>{}(key);
+    }
+};
+
+TEST_CASE("Test Unordered_map transparent lookup", "[Unordered_map]") {
+    Unordered_map<std::string, int, TransparentStringHash, std::equal_to<>> map;
+    map.insert({"192.168.1.1HT", 1});
+    map.insert({"192.168.1.2F", 2});
+
+    std::string_view present = "192.168.1.1HT";
+    std::string_view absent = "192.168.1.3M";
+
+    SECTION("Test find, contains, count and at") {
+        REQUIRE(map.find(present) != map.end());
+        REQUIRE(map.find(present)->second == 1);
+        REQUIRE(map.find(absent) == map.end());
+        REQUIRE(map.contains(present));
+        REQUIRE_FALSE(map.contains(absent));
+        REQUIRE(map.count(present) == 1);
+        REQUIRE(map.at(std::string_view("192.168.1.2F")) == 2);
+        REQUIRE_THROWS_AS(map.at(absent), std::out_of_range);
+    }
+
+    SECTION("Test erase") {
+        REQUIRE(map.erase(absent) == 0);
+        REQUIRE(map.erase(present) == 1);
+        REQUIRE(map.size() == 1);
+        REQUIRE_FALSE(map.contains(present));
+    }
+}
+
+struct CountingHash {
+    static inline std::size_t calls = 0;
+    std::size_t operator()(const std::string& key) const {
+        ++calls;
+        return std::hash<std::string>{}(key);
+    }
+};
+
+TEST_CASE("Test Unordered_map stored hash policy", "[Unordered_map]") {
+    CountingHash::calls = 0;
+    Unordered_map<std::string, int, CountingHash, std::equal_to<std::string>, StoredHashMapPolicy> map;
+    for (int i = 0; i < 1000; ++i) {
+        map.insert({std::to_string(i), i});
+    }
+
+    SECTION("Test resizing does not rehash keys") {
+        REQUIRE(map.capacity() >= 1024);
+        REQUIRE(CountingHash::calls == 1000);
+    }
+
+    SECTION("Test finding and erasing elements") {
+        for (int i = 0; i < 1000; i += 2) {
+            REQUIRE(map.erase(std::to_string(i)) == 1);
+        }
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(map.contains(std::to_string(i)) == (i % 2 == 1));
+        }
+        Unordered_map<std::string, int, CountingHash, std::equal_to<std::string>, StoredHashMapPolicy> copy(map);
+        copy.reserve(10000);
+        REQUIRE(copy.size() == 500);
+        REQUIRE(copy.at("999") == 999);
+    }
+}
+
+struct IncrementalRobinHoodPolicy : IncrementalResizeMapPolicy {
+    static constexpr bool robin_hood = true;
+};
+
+TEMPLATE_TEST_CASE("Test Unordered_map incremental resize policy", "[Unordered_map]", IncrementalResizeMapPolicy, IncrementalRobinHoodPolicy) {
+    Unordered_map<int, int, std::hash<int>, std::equal_to<int>, TestType> map;
+    // The 410th insertion grows the table from 512 to 1024 slots and leaves the old table to be migrated.
+    for (int i = 0; i < 410; ++i) {
+        map.insert({i, i * 2});
+    }
+    REQUIRE(map.capacity() == 1024);
+
+    SECTION("Test finding elements while migrating") {
+        REQUIRE(map.size() == 410);
+        for (int i = 0; i < 410; ++i) {
+            REQUIRE(map.at(i) == i * 2);
+        }
+        REQUIRE_FALSE(map.contains(410));
+    }
+
+    SECTION("Test iterating over both tables") {
+        std::vector<bool> seen(410, false);
+        std::size_t count = 0;
+        for (const auto& [key, value] : map) {
+            REQUIRE_FALSE(seen[key]);
+            seen[key] = true;
+            ++count;
+        }
+        REQUIRE(count == 410);
+    }
+
+    SECTION("Test partitioning both tables") {
+        for (std::size_t count : {1, 3, 7, 64, 2000}) {
+            std::vector<bool> seen(410, false);
+            std::size_t total = 0;
+            auto ranges = std::as_const(map).partitions(count);
+            REQUIRE(ranges.size() == count);
+            for (const auto& range : ranges) {
+                for (const auto& [key, value] : range) {
+                    REQUIRE_FALSE(seen[key]);
+                    seen[key] = true;
+                    ++total;
+                }
+            }
+            REQUIRE(total == 410);
+        }
+    }
+
+    SECTION("Test updating and erasing elements while migrating") {
+        REQUIRE_FALSE(map.insert({409, 0}).second);
+        REQUIRE(map.erase(1) == 1);
+        REQUIRE(map.erase(1) == 0);
+        auto it = map.begin();
+        int erased = it->first;
+        it = map.erase(it);
+        REQUIRE(map.size() == 408);
+        REQUIRE_FALSE(map.contains(erased));
+        int updated = erased == 0 ? 2 : 0;
+        map[updated] = -1;
+        REQUIRE(map.at(updated) == -1);
+        REQUIRE(map.at(409) == 818);
+        Unordered_map<int, int, std::hash<int>, std::equal_to<int>, TestType> copy(map);
+        REQUIRE(std::distance(copy.begin(), copy.end()) == 408);
+    }
+
+    SECTION("Test erasing at iterators while migrating") {
+        std::vector<int> visits(410, 0);
+        for (auto it = map.begin(); it != map.end();) {
+            ++visits[it->first];
+            it = it->first % 2 == 0 ? map.erase(it) : std::next(it);
+        }
+        REQUIRE(std::count(visits.begin(), visits.end(), 1) == 410);
+        REQUIRE(map.size() == 205);
+        for (auto it = std::as_const(map).begin(); it != std::as_const(map).end();) {
+            it = map.erase(it);
+        }
+        REQUIRE(map.empty());
+        REQUIRE(map.stats().capacity == 1024);
+        map.insert({1, 2});
+        REQUIRE(map.at(1) == 2);
+    }
+
+    SECTION("Test finishing the migration") {
+        for (int i = 410; i < 10000; ++i) {
+            map.insert({i, i * 2});
+        }
+        for (int i = 0; i < 10000; i += 3) {
+            REQUIRE(map.erase(i) == 1);
+        }
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(map.contains(i) == (i % 3 != 0));
+        }
+        REQUIRE(std::distance(map.begin(), map.end()) == static_cast<std::ptrdiff_t>(map.size()));
+    }
+}
+
+TEST_CASE("Test Unordered_map iterating a sparse table", "[Unordered_map]") {
+    Unordered_map<int, int> map;
+    map.reserve(1000);
+    const int last = static_cast<int>(map.capacity()) - 1;
+    // The identity hash puts 0 into the first slot, whose control byte is cloned past the end, and last into the last slot.
+    for (int key : {0, 1, 31, 32, 33, 500, last}) {
+        map.insert({key, key});
+    }
+    std::vector<int> keys;
+    for (const auto& [key, value] : map) {
+        keys.push_back(key);
+    }
+    REQUIRE(keys == std::vector<int>{0, 1, 31, 32, 33, 500, last});
+
+    map.erase(0);
+    map.erase(last);
+    REQUIRE(std::distance(map.begin(), map.end()) == 5);
+    REQUIRE(map.begin()->first == 1);
+    for (int key : {1, 31, 32, 33, 500}) {
+        map.erase(key);
+    }
+    REQUIRE(map.begin() == map.end());
+}
+
+TEMPLATE_TEST_CASE("Test Unordered_map bulk insert and batched find", "[Unordered_map]", DefaultMapPolicy, RobinHoodMapPolicy, IncrementalResizeMapPolicy, StoredHashMapPolicy) {
+    Unordered_map<int, int, std::hash<int>, std::equal_to<int>, TestType> map;
+    map.insert({5, -5});
+    std::vector<std::pair<int, int>> values;
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back({i, i * 2});
+    }
+
+    SECTION("Test inserting a range") {
+        REQUIRE(map.insert_bulk(values.begin(), values.end()) == 999);
+        REQUIRE(map.size() == 1000);
+        REQUIRE(map.at(5) == -5);
+        REQUIRE(map.at(999) == 1998);
+        REQUIRE(map.insert_bulk(values.begin(), values.begin()) == 0);
+    }
+
+    SECTION("Test the range grows the table once") {
+        // Doubling one insertion at a time would end at 2048 slots.
+        map.insert_bulk(values.begin(), values.end());
+        REQUIRE(map.capacity() < 2048);
+        REQUIRE(map.load() <= map.get_max_load());
+    }
+
+    SECTION("Test finding a range of keys") {
+        map.insert_bulk(values.begin(), values.end());
+        std::vector<int> keys{3, 1000, 5, -1, 999};
+        std::vector<typename decltype(map)::iterator> found;
+        map.find_many(keys.begin(), keys.end(), std::back_inserter(found));
+        REQUIRE(found.size() == 5);
+        REQUIRE(found[0]->second == 6);
+        REQUIRE(found[1] == map.end());
+        REQUIRE(found[2]->second == -5);
+        REQUIRE(found[3] == map.end());
+        found[4]->second = 0;
+        REQUIRE(map.at(999) == 0);
+
+        const auto& constMap = map;
+        std::vector<typename decltype(map)::const_iterator> constFound(keys.size());
+        REQUIRE(constMap.find_many(keys.begin(), keys.end(), constFound.begin()) == constFound.end());
+        REQUIRE(constFound[0]->second == 6);
+        REQUIRE(constFound[1] == constMap.end());
+    }
+
+    SECTION("Test finding in an empty map") {
+        decltype(map) empty;
+        std::vector<int> keys{1, 2};
+        std::vector<typename decltype(map)::iterator> found;
+        empty.find_many(keys.begin(), keys.end(), std::back_inserter(found));
+        REQUIRE(found == std::vector<typename decltype(map)::iterator>{empty.end(), empty.end()});
+    }
+}
+
+TEST_CASE("Test Unordered_map partitions", "[Unordered_map]") {
+    Unordered_map<int, int> map;
+
+    SECTION("Test partitioning an empty map") {
+        auto ranges = map.partitions(4);
+        REQUIRE(ranges.size() == 4);
+        for (const auto& range : ranges) {
+            REQUIRE(range.begin() == range.end());
+        }
+        REQUIRE(map.partitions(0).size() == 1);
+    }
+
+    SECTION("Test partitions cover every element once") {
+        for (int i = 0; i < 1000; ++i) {
+            map.insert({i, i});
+        }
+        for (int i = 0; i < 1000; i += 4) {
+            map.erase(i);
+        }
+        for (std::size_t count : {1, 2, 5, 8, 5000}) {
+            std::vector<int> visits(1000, 0);
+            for (auto& range : map.partitions(count)) {
+                for (auto& entry : range) {
+                    ++entry.second;
+                    ++visits[entry.first];
+                }
+            }
+            for (int i = 0; i < 1000; ++i) {
+                REQUIRE(visits[i] == (i % 4 != 0 ? 1 : 0));
+            }
+        }
+        REQUIRE(map.at(1) == 6);
+    }
+}
+
+template<class Probing>
+struct ProbingPolicy : PowerOfTwoMapPolicy {
+    using probing = Probing;
+};
+
+struct ConstantHash {
+    std::size_t operator()(int) const {
+        return 12345;
+    }
+};
+
+TEMPLATE_TEST_CASE("Test Unordered_map probing policies", "[Unordered_map]", LinearProbing, QuadraticProbing, TriangularProbing, DoubleHashProbing) {
+    SECTION("Test inserting, finding and erasing under churn") {
+        Unordered_map<int, int, std::hash<int>, std::equal_to<int>, ProbingPolicy<TestType>> map;
+        for (int i = 0; i < 5000; ++i) {
+            map.insert({i, i});
+        }
+        for (int round = 0; round < 20000; ++round) {
+            REQUIRE(map.erase(round) == 1);
+            REQUIRE(map.insert({round + 5000, round}).second);
+        }
+        REQUIRE(map.size() == 5000);
+        for (int i = 20000; i < 25000; ++i) {
+            REQUIRE(map.at(i) == i - 5000);
+            REQUIRE(map.probe_length(i) >= 1);
+        }
+        REQUIRE_FALSE(map.contains(0));
+    }
+
+    SECTION("Test the probe sequence reaches every group") {
+        // Every key starts at the same home group, so the table only fills up if the sequence visits all groups.
+        Unordered_map<int, int, ConstantHash, std::equal_to<int>, ProbingPolicy<TestType>> map;
+        map.reserve(256);
+        for (int i = 0; i < 204; ++i) {
+            map.insert({i, i});
+        }
+        REQUIRE(map.capacity() == 256);
+        for (int i = 0; i < 204; ++i) {
+            REQUIRE(map.at(i) == i);
+        }
+        REQUIRE_FALSE(map.contains(204));
+    }
+}
+
+TEST_CASE("Test Unordered_map probe length", "[Unordered_map]") {
+    Unordered_map<int, int> map;
+    REQUIRE(map.probe_length(1) == 0);
+    map.insert({1, 1});
+    REQUIRE(map.probe_length(1) == 1);
+
+    Unordered_map<int, int, ConstantHash, std::equal_to<int>, RobinHoodMapPolicy> robinHood;
+    for (int i = 0; i < 5; ++i) {
+        robinHood.insert({i, i});
+    }
+    std::size_t total = 0;
+    for (int i = 0; i < 5; ++i) {
+        total += robinHood.probe_length(i);
+    }
+    REQUIRE(total == 1 + 2 + 3 + 4 + 5);
+}
+
+TEST_CASE("Test Unordered_map cuckoo policy", "[Unordered_map]") {
+    Unordered_map<int, int, std::hash<int>, std::equal_to<int>, CuckooMapPolicy> map;
+    for (int i = 0; i < 20000; ++i) {
+        REQUIRE(map.insert({i, i * 2}).second);
+    }
+    REQUIRE(map.size() == 20000);
+
+    SECTION("Test every lookup probes at most two buckets") {
+        for (int i = 0; i < 20000; ++i) {
+            REQUIRE(map.at(i) == i * 2);
+            REQUIRE(map.probe_length(i) <= 2);
+        }
+        for (int i = 20000; i < 30000; ++i) {
+            REQUIRE(map.probe_length(i) == 2);
+            REQUIRE_FALSE(map.contains(i));
+        }
+        REQUIRE(std::distance(map.begin(), map.end()) == 20000);
+    }
+
+    SECTION("Test churn at the maximum load factor") {
+        std::size_t capacity = map.capacity();
+        for (int i = 20000; map.size() < capacity * 4 / 5 - 1; ++i) {
+            REQUIRE(map.insert({i, i * 2}).second);
+        }
+        REQUIRE(map.capacity() == capacity);
+        std::size_t size = map.size();
+        for (int round = 0; round < 20000; ++round) {
+            REQUIRE(map.erase(round) == 1);
+            REQUIRE(map.insert({round + 1000000, round}).second);
+        }
+        REQUIRE(map.size() == size);
+        for (int round = 0; round < 20000; ++round) {
+            REQUIRE(map.at(round + 1000000) == round);
+            REQUIRE(map.probe_length(round + 1000000) <= 2);
+        }
+    }
+
+    SECTION("Test copying, merging and rehashing") {
+        Unordered_map<int, int, std::hash<int>, std::equal_to<int>, CuckooMapPolicy> copy(map);
+        Unordered_map<int, int, std::hash<int>, std::equal_to<int>, CuckooMapPolicy> other;
+        for (int i = 19000; i < 21000; ++i) {
+            other[i] = -i;
+        }
+        copy.merge(other);
+        REQUIRE(copy.size() == 21000);
+        REQUIRE(other.size() == 1000);
+        copy.reserve(100000);
+        for (int i = 0; i < 21000; ++i) {
+            REQUIRE(copy.at(i) == (i < 20000 ? i * 2 : -i));
+        }
+    }
+
+    SECTION("Test more equal hashes than two buckets hold") {
+        Unordered_map<int, int, ConstantHash, std::equal_to<int>, CuckooMapPolicy> colliding;
+        for (int i = 0; i < 8; ++i) {
+            REQUIRE(colliding.insert({i, i}).second);
+        }
+        REQUIRE_THROWS_AS(colliding.insert({8, 8}), std::length_error);
+        REQUIRE(colliding.size() == 8);
+        for (int i = 0; i < 8; ++i) {
+            REQUIRE(colliding.at(i) == i);
+        }
+    }
+}
+
+TEST_CASE("Test Unordered_map seeded hash function", "[Unordered_map]") {
+    SECTION("Test every instance is seeded differently") {
+        FastHash first, second;
+        REQUIRE(first.seed() != second.seed());
+        REQUIRE(first("192.168.1.4HT") != second("192.168.1.4HT"));
+        REQUIRE(first("192.168.1.4HT") == first(std::string("192.168.1.4HT")));
+        REQUIRE(FastHash(42)("192.168.1.4HT") == FastHash(42)("192.168.1.4HT"));
+        REQUIRE(FastHash(42)(std::string(100, 'x')) != FastHash(42)(std::string(99, 'x')));
+        REQUIRE(FastHash(42)(7) != FastHash(43)(7));
+    }
+
+    using Map = Unordered_map<std::string, int, FastHash, std::equal_to<>, IncrementalResizeMapPolicy>;
+    Map map(FastHash(1));
+    for (int i = 0; i < 5000; ++i) {
+        map.insert({std::to_string(i), i});
+    }
+
+    SECTION("Test the map keeps its hash function while growing") {
+        for (int i = 0; i < 5000; ++i) {
+            REQUIRE(map.at(std::to_string(i)) == i);
+        }
+        REQUIRE(map.contains(std::string_view("4999")));
+    }
+
+    SECTION("Test copies, moves and swaps take the hash function along") {
+        Map copy(map);
+        Map moved(std::move(copy));
+        Map other(FastHash(2));
+        other.insert({"x", -1});
+        other.swap(moved);
+        REQUIRE(moved.at("x") == -1);
+        for (int i = 0; i < 5000; i += 7) {
+            REQUIRE(other.at(std::to_string(i)) == i);
+        }
+        moved = other;
+        REQUIRE(moved.at("4999") == 4999);
+    }
+
+    SECTION("Test merging maps seeded differently") {
+        Map other(FastHash(2));
+        for (int i = 4000; i < 6000; ++i) {
+            other.insert({std::to_string(i), -i});
+        }
+        map.merge(other);
+        REQUIRE(map.size() == 6000);
+        REQUIRE(other.size() == 1000);
+        for (int i = 0; i < 6000; ++i) {
+            REQUIRE(map.at(std::to_string(i)) == (i < 5000 ? i : -i));
+        }
+        for (int i = 4000; i < 5000; ++i) {
+            REQUIRE(other.at(std::to_string(i)) == -i);
+        }
+    }
+}
+
+TEST_CASE("Test Unordered_map prehashed lookup", "[Unordered_map]") {
+    Unordered_map<std::string, int, FastHash, std::equal_to<>, IncrementalResizeMapPolicy> map;
+    for (int i = 0; i < 1000; ++i) {
+        map.insert({std::to_string(i), i});
+    }
+    auto hash = map.hash_function();
+    REQUIRE(hash == map.hash_function());
+
+    for (int i = 0; i < 1000; ++i) {
+        std::string key = std::to_string(i);
+        REQUIRE(map.find(key, hash(key))->second == i);
+        REQUIRE(std::as_const(map).find(std::string_view(key), hash(key)) != map.end());
+    }
+    REQUIRE(map.find(std::string("1000"), hash("1000")) == map.end());
+    REQUIRE(map.erase(std::string("7"), hash("7")) == 1);
+    REQUIRE(map.erase(std::string_view("7"), hash("7")) == 0);
+    REQUIRE(map.erase(std::string_view("8"), hash("8")) == 1);
+    REQUIRE(map.size() == 998);
+    REQUIRE_FALSE(map.contains("7"));
+    REQUIRE_FALSE(map.contains("8"));
+}
+
+TEMPLATE_TEST_CASE("Test Unordered_map tombstone cleanup", "[Unordered_map]", LinearProbing, QuadraticProbing, TriangularProbing, DoubleHashProbing) {
+    SECTION("Test churn keeps the capacity and clears tombstones in place") {
+        Unordered_map<int, int, std::hash<int>, std::equal_to<int>, ProbingPolicy<TestType>> map;
+        for (int i = 0; i < 2500; ++i) {
+            map.insert({i, i});
+        }
+        std::size_t capacity = map.capacity();
+        for (int round = 0; round < 50000; ++round) {
+            REQUIRE(map.erase(round) == 1);
+            REQUIRE(map.insert({round + 2500, round}).second);
+            REQUIRE(map.stats().effective_load <= map.max_load_factor());
+        }
+        REQUIRE(map.capacity() == capacity);
+        REQUIRE(map.size() == 2500);
+        for (int i = 50000; i < 52500; ++i) {
+            REQUIRE(map.at(i) == i - 2500);
+        }
+        REQUIRE_FALSE(map.contains(49999));
+    }
+
+    SECTION("Test cleanup of a single cluster") {
+        Unordered_map<int, int, ConstantHash, std::equal_to<int>, ProbingPolicy<TestType>> map;
+        map.reserve(256);
+        for (int i = 0; i < 150; ++i) {
+            map.insert({i, i});
+        }
+        for (int round = 0; round < 2000; ++round) {
+            REQUIRE(map.erase(round) == 1);
+            REQUIRE(map.insert({round + 150, round}).second);
+        }
+        REQUIRE(map.capacity() == 256);
+        for (int i = 2000; i < 2150; ++i) {
+            REQUIRE(map.at(i) == i - 150);
+        }
+        REQUIRE(std::distance(map.begin(), map.end()) == 150);
+    }
+}
+
+TEST_CASE("Test Unordered_map shrinking and load factors", "[Unordered_map]") {
+    Unordered_map<std::string, int> map;
+    for (int i = 0; i < 10000; ++i) {
+        map.insert({std::to_string(i), i});
+    }
+    std::size_t peak = map.capacity();
+
+    SECTION("Test shrink_to_fit") {
+        for (int i = 10; i < 10000; ++i) {
+            map.erase(std::to_string(i));
+        }
+        REQUIRE(map.capacity() == peak);
+        map.shrink_to_fit();
+        REQUIRE(map.capacity() < 16);
+        REQUIRE(map.stats().tombstones == 0);
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(map.at(std::to_string(i)) == i);
+        }
+        map.clear();
+        map.shrink_to_fit();
+        REQUIRE(map.capacity() == 0);
+        map["again"] = 1;
+        REQUIRE(map.at("again") == 1);
+    }
+
+    SECTION("Test the minimum load factor shrinks on erasure by key") {
+        REQUIRE(map.min_load_factor() == 0.0f);
+        map.min_load_factor(0.2f);
+        for (int i = 100; i < 10000; ++i) {
+            REQUIRE(map.erase(std::to_string(i)) == 1);
+            REQUIRE(map.load() >= 0.19f);
+        }
+        REQUIRE(map.capacity() < 512);
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(map.at(std::to_string(i)) == i);
+        }
+
+        std::size_t capacity = map.capacity();
+        for (auto it = map.begin(); it != map.end();) {
+            it = map.erase(it);
+        }
+        REQUIRE(map.empty());
+        REQUIRE(map.capacity() == capacity);
+        REQUIRE(map.shrink_if_underloaded());
+        REQUIRE(map.capacity() < capacity);
+        REQUIRE_FALSE(map.shrink_if_underloaded());
+    }
+
+    SECTION("Test setting the maximum load factor") {
+        REQUIRE(map.max_load_factor() == Approx(0.8));
+        map.max_load_factor(0.5f);
+        REQUIRE(map.capacity() > peak);
+        REQUIRE(map.load() <= 0.5f);
+        for (int i = 10000; i < 20000; ++i) {
+            map.insert({std::to_string(i), i});
+            REQUIRE(map.load() <= 0.5f);
+        }
+        map.max_load_factor(1.0f);
+        REQUIRE(map.get_max_load() == 1.0f);
+        map.clear();
+        REQUIRE(map.max_load_factor() == 1.0f);
+
+        REQUIRE_THROWS_AS(map.max_load_factor(0.0f), std::invalid_argument);
+        REQUIRE_THROWS_AS(map.max_load_factor(1.5f), std::invalid_argument);
+        REQUIRE_THROWS_AS(map.min_load_factor(1.0f), std::invalid_argument);
+        REQUIRE_THROWS_AS(map.min_load_factor(-0.1f), std::invalid_argument);
+    }
+}
+
+TEMPLATE_TEST_CASE("Test Unordered_map shrinking under every policy", "[Unordered_map]", DefaultMapPolicy, RobinHoodMapPolicy, IncrementalResizeMapPolicy, StoredHashMapPolicy, CuckooMapPolicy) {
+    Unordered_map<int, int, std::hash<int>, std::equal_to<int>, TestType> map;
+    map.min_load_factor(0.1f);
+    for (int i = 0; i < 5000; ++i) {
+        map.insert({i, i});
+    }
+    std::size_t peak = map.capacity();
+    for (int i = 0; i < 4950; ++i) {
+        REQUIRE(map.erase(i) == 1);
+    }
+    REQUIRE(map.capacity() < peak / 8);
+    map.shrink_to_fit();
+    REQUIRE(map.capacity() <= 128);
+    for (int i = 4950; i < 5000; ++i) {
+        REQUIRE(map.at(i) == i);
+    }
+    REQUIRE(std::distance(map.begin(), map.end()) == 50);
+
+    for (int i = 4950; i < 4999; ++i) {
+        REQUIRE(map.erase(i) == 1);
+    }
+    map.shrink_if_underloaded();
+    REQUIRE_FALSE(map.shrink_if_underloaded());
+    REQUIRE(map.at(4999) == 4999);
+
+    // Drain the map at iterators right after a growth, leaving the shrink to the caller.
+    std::size_t capacity = map.capacity();
+    int count = 0;
+    while (map.capacity() == capacity) {
+        map.insert({count, count});
+        ++count;
+    }
+    for (int i = 0; i < count; ++i) {
+        map.erase(map.find(i));
+    }
+    REQUIRE(map.erase(map.find(4999)) == map.end());
+    REQUIRE(map.empty());
+    REQUIRE(map.shrink_if_underloaded());
+    REQUIRE(map.capacity() <= 8);
+    REQUIRE(map.stats().capacity == map.capacity());
+    REQUIRE_FALSE(map.shrink_if_underloaded());
+}
+
+/**
+ * @brief Path of a scratch file in the temporary directory, removed when it goes out of scope.
+ */
+struct ScratchFile {
+    std::string path;
+
+    explicit ScratchFile(const std::string& name) : path((std::filesystem::temp_directory_path() / name).string()) {}
+
+    ~ScratchFile() {
+        std::filesystem::remove(path);
+    }
+};
+
+TEMPLATE_TEST_CASE("Test Unordered_map saving and loading", "[Unordered_map]", DefaultMapPolicy, RobinHoodMapPolicy, IncrementalResizeMapPolicy, StoredHashMapPolicy, CuckooMapPolicy) {
+    ScratchFile file("map_tests_saved.umap");
+
+    SECTION("Test a trivially copyable table comes back slot for slot") {
+        Unordered_map<int, int, std::hash<int>, std::equal_to<int>, TestType> map;
+        map.max_load_factor(0.7f);
+        for (int i = 0; i < 3000; ++i) {
+            map.insert({i, -i});
+        }
+        for (int i = 0; i < 3000; i += 3) {
+            map.erase(i);
+        }
+        map.save(file.path);
+
+        auto loaded = decltype(map)::load(file.path);
+        REQUIRE(loaded.size() == map.size());
+        REQUIRE(loaded.max_load_factor() == 0.7f);
+        for (int i = 0; i < 3000; ++i) {
+            REQUIRE(loaded.contains(i) == (i % 3 != 0));
+        }
+        REQUIRE(loaded.probe_length(1) >= 1);
+
+        for (int i = 0; i < 3000; i += 3) {
+            loaded.insert({i, -i});
+        }
+        for (int i = 3000; i < 6000; ++i) {
+            loaded.insert({i, -i});
+        }
+        REQUIRE(loaded.size() == 6000);
+        for (int i = 0; i < 6000; ++i) {
+            REQUIRE(loaded.at(i) == -i);
+        }
+
+        auto reloaded = decltype(map)::load(file.path);
+        REQUIRE(reloaded.size() == 2000);
+        REQUIRE_FALSE(reloaded.contains(3000));
+    }
+
+    SECTION("Test a string-keyed table is decoded into its slots") {
+        Unordered_map<std::string, std::string, std::hash<std::string>, std::equal_to<std::string>, TestType> map;
+        for (int i = 0; i < 1000; ++i) {
+            map.insert({"192.168." + std::to_string(i), std::string(static_cast<std::size_t>(i % 40), 'x')});
+        }
+        map.erase("192.168.7");
+        map.save(file.path);
+
+        auto loaded = decltype(map)::load(file.path);
+        REQUIRE(loaded.size() == 999);
+        REQUIRE(loaded.capacity() >= map.size());
+        REQUIRE_FALSE(loaded.contains("192.168.7"));
+        for (int i = 0; i < 1000; ++i) {
+            if (i != 7) {
+                REQUIRE(loaded.at("192.168." + std::to_string(i)).size() == static_cast<std::size_t>(i % 40));
+            }
+        }
+        loaded.erase("192.168.8");
+        loaded["10.0.0.1"] = "new";
+        REQUIRE(loaded.size() == 999);
+        REQUIRE(decltype(map)(loaded).at("10.0.0.1") == "new");
+    }
+
+    SECTION("Test an empty table") {
+        Unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, TestType> map;
+        map.save(file.path);
+        auto loaded = decltype(map)::load(file.path);
+        REQUIRE(loaded.empty());
+        loaded["a"] = 1;
+        REQUIRE(loaded.at("a") == 1);
+    }
+}
+
+TEST_CASE("Test Unordered_map files", "[Unordered_map]") {
+    ScratchFile file("map_tests_file.umap");
+
+    SECTION("Test a seeded hash function is restored") {
+        Unordered_map<std::string, int, FastHash> map(FastHash(12345));
+        for (int i = 0; i < 500; ++i) {
+            map.insert({std::to_string(i), i});
+        }
+        map.save(file.path);
+        auto loaded = Unordered_map<std::string, int, FastHash>::load(file.path);
+        REQUIRE(loaded.hash_function().seed() == 12345);
+        for (int i = 0; i < 500; ++i) {
+            REQUIRE(loaded.at(std::to_string(i)) == i);
+        }
+    }
+
+    SECTION("Test a table in the middle of a resize is saved whole") {
+        Unordered_map<int, int, std::hash<int>, std::equal_to<int>, IncrementalResizeMapPolicy> map;
+        int i = 0;
+        for (; map.capacity() < 1024; ++i) {
+            map.insert({i, i});
+        }
+        std::size_t capacity = map.capacity();
+        for (; map.capacity() == capacity; ++i) {
+            map.insert({i, i});
+        }
+        REQUIRE(map.stats().capacity > map.capacity());
+        map.save(file.path);
+        auto loaded = decltype(map)::load(file.path);
+        REQUIRE(loaded.size() == static_cast<std::size_t>(i));
+        REQUIRE(loaded.stats().capacity == loaded.capacity());
+        for (int j = 0; j < i; ++j) {
+            REQUIRE(loaded.at(j) == j);
+        }
+    }
+
+    SECTION("Test a loaded table leaves its file untouched") {
+        Unordered_map<int, int> map;
+        map.insert({1, 1});
+        map.save(file.path);
+        {
+            auto loaded = Unordered_map<int, int>::load(file.path);
+            loaded[1] = 2;
+            loaded.erase(1);
+            Unordered_map<int, int> moved(std::move(loaded));
+            moved[3] = 3;
+        }
+        REQUIRE(Unordered_map<int, int>::load(file.path).at(1) == 1);
+    }
+
+    SECTION("Test files that are not maps of the type are rejected") {
+        Unordered_map<int, int> map;
+        map.insert({1, 1});
+        map.save(file.path);
+        REQUIRE_THROWS_AS((Unordered_map<int, long>::load(file.path)), std::runtime_error);
+        REQUIRE_THROWS_AS((Unordered_map<int, int, std::hash<int>, std::equal_to<int>, RobinHoodMapPolicy>::load(file.path)), std::runtime_error);
+
+        std::filesystem::resize_file(file.path, std::filesystem::file_size(file.path) - 1);
+        REQUIRE_THROWS_AS((Unordered_map<int, int>::load(file.path)), std::runtime_error);
+
+        std::ofstream(file.path, std::ios::binary | std::ios::trunc) << "not a map";
+        REQUIRE_THROWS_AS((Unordered_map<int, int>::load(file.path)), std::runtime_error);
+        REQUIRE_THROWS_AS((Unordered_map<int, int>::load(file.path + ".missing")), std::system_error);
+    }
+
+    SECTION("Test a damaged element section is rejected without leaks") {
+        Unordered_map<std::string, std::string> map;
+        for (int i = 0; i < 100; ++i) {
+            map.insert({std::to_string(i), std::string(100, 'v')});
+        }
+        map.save(file.path);
+        std::filesystem::resize_file(file.path, std::filesystem::file_size(file.path) - 50);
+        std::fstream patch(file.path, std::ios::binary | std::ios::in | std::ios::out);
+        MapFileHeader header;
+        patch.read(reinterpret_cast<char*>(&header), sizeof(header));
+        header.file_size -= 50;
+        patch.seekp(0);
+        patch.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        patch.close();
+        REQUIRE_THROWS_AS((Unordered_map<std::string, std::string>::load(file.path)), std::runtime_error);
+    }
+}
+
+template<class Base>
+struct WithSnapshots : Base {
+    static constexpr bool snapshots = true;
+};
+
+/**
+ * @brief Reads the elements of a snapshot, sorted by key.
+ */
+template<class Snapshot>
+std::vector<typename Snapshot::value_type> snapshotElements(const Snapshot& snapshot) {
+    std::vector<typename Snapshot::value_type> elements;
+    snapshot.for_each([&elements](const auto& element) { elements.push_back(element); });
+    std::sort(elements.begin(), elements.end());
+    return elements;
+}
+
+TEMPLATE_TEST_CASE("Test Unordered_map snapshots", "[Unordered_map]", WithSnapshots<DefaultMapPolicy>, WithSnapshots<RobinHoodMapPolicy>,
+                   WithSnapshots<IncrementalResizeMapPolicy>, WithSnapshots<StoredHashMapPolicy>, WithSnapshots<CuckooMapPolicy>) {
+    using Map = Unordered_map<int, std::string, std::hash<int>, std::equal_to<int>, TestType>;
+    Map map;
+    std::vector<std::pair<int, std::string>> original;
+    for (int i = 0; i < 3000; ++i) {
+        map.insert({i, std::to_string(i)});
+        original.emplace_back(i, std::to_string(i));
+    }
+    std::sort(original.begin(), original.end());
+
+    SECTION("Test a snapshot keeps its elements through every kind of modification") {
+        auto snapshot = map.snapshot();
+        REQUIRE(snapshot.size() == 3000);
+        for (int i = 0; i < 3000; i += 5) {
+            map.erase(i);
+        }
+        map[1] = "assigned";
+        map.at(2) = "at";
+        map.find(3)->second = "found";
+        map.insert_or_assign(4, "replaced");
+        REQUIRE_FALSE(map.extract(6).empty());
+        Map other;
+        other.insert({7, "merged"});
+        other.insert({-1, "merged"});
+        map.merge(other);
+        map.try_emplace(-2, "new");
+        REQUIRE(snapshotElements(snapshot) == original);
+
+        for (int i = 3000; i < 12000; ++i) {
+            map.insert({i, "grown"});
+        }
+        for (int i = 3000; i < 12000; ++i) {
+            map.erase(i);
+        }
+        map.shrink_to_fit();
+        REQUIRE(snapshotElements(snapshot) == original);
+        map.clear();
+        REQUIRE(snapshotElements(snapshot) == original);
+    }
+
+    SECTION("Test snapshots taken at different times") {
+        auto first = map.snapshot();
+        map.erase(0);
+        map[1] = "changed";
+        auto second = map.snapshot();
+        map.erase(1);
+        auto third = map.snapshot();
+        REQUIRE(snapshotElements(first) == original);
+        auto changed = original;
+        changed.erase(changed.begin());
+        changed.front().second = "changed";
+        REQUIRE(snapshotElements(second) == changed);
+        REQUIRE(third.size() == 2998);
+        REQUIRE(snapshotElements(third).front().first == 2);
+    }
+
+    SECTION("Test writing through mutable iterators keeps the snapshot") {
+        auto snapshot = map.snapshot();
+        for (auto it = map.begin(); it != map.end(); ++it) {
+            it->second = "overwritten";
+        }
+        REQUIRE(snapshotElements(snapshot) == original);
+        REQUIRE(map.at(10) == "overwritten");
+    }
+
+    SECTION("Test writing through partitions on several threads keeps the snapshot") {
+        auto snapshot = map.snapshot();
+        std::vector<std::pair<int, std::string>> read;
+        std::thread reader([&] {
+            read = snapshotElements(snapshot);
+        });
+        std::vector<std::thread> writers;
+        for (const auto& range : map.partitions(4)) {
+            writers.emplace_back([range] {
+                for (auto& [key, value] : range) {
+                    value = "parallel";
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        reader.join();
+        REQUIRE(read == original);
+        REQUIRE(snapshotElements(snapshot) == original);
+        REQUIRE(map.at(10) == "parallel");
+    }
+
+    SECTION("Test a snapshot outlives its map") {
+        auto snapshot = std::make_unique<Map>(map)->snapshot();
+        REQUIRE(snapshotElements(snapshot) == original);
+        REQUIRE(Map().snapshot().empty());
+    }
+
+    SECTION("Test a snapshot is read while the map keeps changing") {
+        auto snapshot = map.snapshot();
+        std::vector<std::pair<int, std::string>> read;
+        std::thread reader([&] {
+            for (int round = 0; round < 3; ++round) {
+                read = snapshotElements(snapshot);
+            }
+        });
+        for (int i = 0; i < 3000; ++i) {
+            map[i] = "written";
+            if (i % 3 == 0) {
+                map.erase(i);
+            }
+            map.insert({3000 + i, "new"});
+        }
+        reader.join();
+        REQUIRE(read == original);
+        REQUIRE(map.size() == 5000);
+    }
+}
+
+/**
+ * @brief A value counting its copies, whose copying can be made to fail.
+ */
+struct CountedCopy {
+    static inline int copies = 0;
+    static inline bool failing = false;
+    int value = 0;
+
+    CountedCopy(int value) : value(value) {}
+    CountedCopy(CountedCopy&& other) noexcept = default;
+    CountedCopy(const CountedCopy& other) : value(other.value) {
+        if (failing) {
+            throw std::bad_alloc();
+        }
+        ++copies;
+    }
+    CountedCopy& operator=(const CountedCopy& other) = default;
+    CountedCopy& operator=(CountedCopy&& other) noexcept = default;
+};
+
+TEST_CASE("Test Unordered_map snapshots copy only the pages written", "[Unordered_map]") {
+    using Map = Unordered_map<int, CountedCopy, std::hash<int>, std::equal_to<int>, WithSnapshots<DefaultMapPolicy>>;
+    auto sum = [](const auto& snapshot) {
+        long total = 0;
+        snapshot.for_each([&total](const auto& element) { total += element.second.value; });
+        return total;
+    };
+    Map map;
+    for (int i = 0; i < 3000; ++i) {
+        map.insert({i, CountedCopy(1)});
+    }
+    auto snapshot = map.snapshot();
+    CountedCopy::copies = 0;
+
+    SECTION("Test traversing a non-const map copies nothing until an element is accessed") {
+        REQUIRE(std::distance(map.begin(), map.end()) == 3000);
+        std::ptrdiff_t counted = 0;
+        for (const auto& range : map.partitions(4)) {
+            counted += std::distance(range.begin(), range.end());
+        }
+        REQUIRE(counted == 3000);
+        REQUIRE(map.find(10) != map.end());
+        REQUIRE(CountedCopy::copies == 0);
+
+        map.begin()->second.value = 5;
+        REQUIRE(CountedCopy::copies > 0);
+        REQUIRE(CountedCopy::copies <= static_cast<int>(SnapshotPages<Map::value_type>::page_slots));
+        for (auto& [key, value] : map) {
+            value.value = 2;
+        }
+        REQUIRE(sum(snapshot) == 3000);
+        REQUIRE(map.at(10).value == 2);
+    }
+
+    SECTION("Test destroying the map hands the slots over when copying them fails") {
+        auto doomed = std::make_unique<Map>(std::move(map));
+        CountedCopy::failing = true;
+        REQUIRE_NOTHROW(doomed.reset());
+        CountedCopy::failing = false;
+        REQUIRE(snapshot.size() == 3000);
+        REQUIRE(sum(snapshot) == 3000);
+    }
+}
+
+struct IncrementalStatsPolicy : IncrementalResizeMapPolicy {
+    static constexpr bool collect_stats = true;
+};
+
+TEST_CASE("Test Unordered_map statistics", "[Unordered_map]") {
+    SECTION("Test operations are counted by probe length") {
+        Unordered_map<int, int, std::hash<int>, std::equal_to<int>, StatsMapPolicy> map;
+        REQUIRE(MapStats::count(map.stats().find_probes) == 0);
+        REQUIRE_FALSE(map.contains(1));
+        REQUIRE(map.stats().find_probes[0] == 1);
+
+        for (int i = 0; i < 1000; ++i) {
+            map.insert({i, i});
+        }
+        map[0] = 1;
+        for (int i = 0; i < 2000; ++i) {
+            REQUIRE(map.contains(i) == (i < 1000));
+        }
+        for (int i = 0; i < 500; ++i) {
+            REQUIRE(map.erase(i) == 1);
+        }
+        REQUIRE(map.extract(0).empty());
+
+        MapStats stats = map.stats();
+        REQUIRE(MapStats::count(stats.insert_probes) == 1001);
+        REQUIRE(MapStats::count(stats.find_probes) == 2001);
+        REQUIRE(MapStats::count(stats.erase_probes) == 501);
+        REQUIRE(stats.find_probes[0] == 1);
+        REQUIRE(MapStats::mean(stats.find_probes) >= 0.99);
+        REQUIRE(MapStats::percentile(stats.find_probes, 0.5) >= 1);
+        REQUIRE(stats.rehashes >= 10);
+        REQUIRE(stats.longest_rehash <= stats.rehash_time);
+        REQUIRE(stats.size == 500);
+        REQUIRE(stats.capacity == map.capacity());
+        REQUIRE(stats.load == Approx(map.load()));
+        REQUIRE(stats.effective_load == Approx(static_cast<double>(stats.size + stats.tombstones) / stats.capacity));
+        REQUIRE(stats.bytes_allocated == map.capacity() * (1 + sizeof(decltype(map)::entry_type)) + ControlGroup::width - 1);
+
+        map.reserve(map.capacity() * 4);
+        REQUIRE(map.stats().rehashes == stats.rehashes + 1);
+        REQUIRE(map.stats().tombstones == 0);
+    }
+
+    SECTION("Test tombstones raise the effective load") {
+        Unordered_map<int, int, ConstantHash, std::equal_to<int>, StatsMapPolicy> map;
+        for (int i = 0; i < 100; ++i) {
+            map.insert({i, i});
+        }
+        for (int i = 0; i < 50; ++i) {
+            map.erase(i);
+        }
+        MapStats stats = map.stats();
+        REQUIRE(stats.tombstones > 0);
+        REQUIRE(stats.effective_load > stats.load);
+        REQUIRE(MapStats::percentile(stats.insert_probes, 1.0) >= 3);
+    }
+
+    SECTION("Test maps without collected statistics report occupancy only") {
+        Unordered_map<int, int, ConstantHash, std::equal_to<int>, RobinHoodMapPolicy> map;
+        for (int i = 0; i < 100; ++i) {
+            map.insert({i, i});
+        }
+        for (int i = 0; i < 50; ++i) {
+            map.erase(i);
+        }
+        MapStats stats = map.stats();
+        REQUIRE(MapStats::count(stats.insert_probes) == 0);
+        REQUIRE(MapStats::count(stats.erase_probes) == 0);
+        REQUIRE(stats.rehashes == 0);
+        REQUIRE(stats.size == 50);
+        REQUIRE(stats.tombstones == 0);
+        REQUIRE(stats.effective_load == stats.load);
+        REQUIRE(stats.bytes_allocated > map.capacity() * sizeof(std::uint16_t));
+    }
+
+    SECTION("Test the old table counts while growing") {
+        Unordered_map<int, int, std::hash<int>, std::equal_to<int>, IncrementalStatsPolicy> map;
+        int i = 0;
+        for (; map.capacity() < 1024; ++i) {
+            map.insert({i, i});
+        }
+        std::size_t capacity = map.capacity();
+        for (; map.capacity() == capacity; ++i) {
+            map.insert({i, i});
+        }
+        MapStats stats = map.stats();
+        REQUIRE(stats.capacity == map.capacity() + capacity);
+        REQUIRE(stats.size == map.size());
+        REQUIRE(MapStats::count(stats.insert_probes) == static_cast<std::size_t>(i));
+    }
+}
+
+TEST_CASE("Test StaticMap", "[StaticMap]") {
+    static constexpr StaticMap<int, 3> types({{"HT", 10}, {"F", 20}, {"M", 30}});
+    static_assert(types.index_of("HT") == 0 && types.index_of("F") == 1 && types.index_of("M") == 2);
+    static_assert(types.at("F") == 20);
+    static_assert(!types.contains("H") && !types.contains("") && !types.contains("HTM"));
+
+    SECTION("Test lookups at run time") {
+        for (std::size_t i = 0; i < types.size(); ++i) {
+            std::string key(types.key(i));
+            REQUIRE(types.index_of(key) == i);
+            REQUIRE(*types.find(key) == types.value(i));
+        }
+        REQUIRE(types.find("X") == nullptr);
+        REQUIRE(types.index_of("MM") == types.size());
+        REQUIRE_THROWS_AS(types.at("f"), std::out_of_range);
+        REQUIRE(types.keys()[2] == "M");
+    }
+
+    SECTION("Test a larger key set") {
+        static constexpr StaticMap<std::string_view, 20> codes({
+            {"GET", "get"}, {"PUT", "put"}, {"POST", "post"}, {"HEAD", "head"}, {"DELETE", "delete"},
+            {"OPTIONS", "options"}, {"PATCH", "patch"}, {"TRACE", "trace"}, {"CONNECT", "connect"}, {"a", "a"},
+            {"b", "b"}, {"c", "c"}, {"ab", "ab"}, {"ba", "ba"}, {"abc", "abc"},
+            {"cba", "cba"}, {"10.0.0.1", "ip"}, {"x", "x"}, {"y", "y"}, {"z", "z"}});
+        for (std::size_t i = 0; i < codes.size(); ++i) {
+            REQUIRE(codes.index_of(codes.key(i)) == i);
+            REQUIRE(codes.at(codes.key(i)) == codes.value(i));
+        }
+        for (std::string_view absent : {"get", "GETS", "", "abcd", "d", "10.0.0.2"}) {
+            REQUIRE_FALSE(codes.contains(absent));
+        }
+    }
+}
+
+TEST_CASE("Test BlockedBloomFilter", "[BlockedBloomFilter]") {
+    BlockedBloomFilter filter(1000);
+    FastHash hash(3);
+    REQUIRE(filter.capacity() >= 1000);
+    for (int i = 0; i < 1000; ++i) {
+        filter.add(hash(i));
+    }
+    filter.add(hash(0));
+    REQUIRE(filter.size() == 1001);
+
+    SECTION("Test added keys are always found") {
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(filter.might_contain(hash(i)));
+        }
+        REQUIRE(filter.stats().negatives == 0);
+    }
+
+    SECTION("Test absent keys are mostly rejected") {
+        std::size_t passed = 0;
+        for (int i = 1000; i < 101000; ++i) {
+            passed += filter.might_contain(hash(i));
+        }
+        REQUIRE(passed < 1000);
+        auto stats = filter.stats();
+        REQUIRE(stats.queries == 100000);
+        REQUIRE(stats.negatives == 100000 - passed);
+        REQUIRE(stats.estimated_false_positive_rate < 0.01);
+    }
+
+    SECTION("Test removed keys leave the filter") {
+        for (int i = 1; i < 1000; ++i) {
+            filter.remove(hash(i));
+        }
+        REQUIRE(filter.might_contain(hash(0)));
+        filter.remove(hash(0));
+        REQUIRE(filter.might_contain(hash(0)));
+        filter.remove(hash(0));
+        REQUIRE(filter.size() == 0);
+        REQUIRE(filter.stats().estimated_false_positive_rate == 0);
+        REQUIRE_FALSE(filter.might_contain(hash(0)));
+    }
+
+    SECTION("Test saturated counters never underflow") {
+        BlockedBloomFilter tiny(1);
+        for (int i = 0; i < 100; ++i) {
+            tiny.add(hash(i));
+        }
+        for (int i = 1; i < 100; ++i) {
+            tiny.remove(hash(i));
+        }
+        REQUIRE(tiny.might_contain(hash(0)));
+    }
+}
+
+struct Tracked {
+    static inline int live = 0;
+    int value;
+    explicit Tracked(int value) : value(value) { ++live; }
+    Tracked(const Tracked& other) : value(other.value) { ++live; }
+    Tracked(Tracked&& other) noexcept : value(other.value) { ++live; }
+    Tracked& operator=(const Tracked&) = default;
+    ~Tracked() { --live; }
+};
+
+TEMPLATE_TEST_CASE("Test Unordered_map constructs only occupied slots", "[Unordered_map]", DefaultMapPolicy, RobinHoodMapPolicy, IncrementalResizeMapPolicy, StoredHashMapPolicy) {
+    Tracked::live = 0;
+    {
+        Unordered_map<int, Tracked, std::hash<int>, std::equal_to<int>, TestType> map;
+        map.reserve(64);
+        REQUIRE(Tracked::live == 0);
+        for (int i = 0; i < 1000; ++i) {
+            map.emplace(i, i * 3);
+        }
+        REQUIRE(Tracked::live == 1000);
+        REQUIRE(map.at(999).value == 2997);
+
+        for (int i = 0; i < 1000; i += 2) {
+            map.erase(i);
+        }
+        REQUIRE(Tracked::live == 500);
+        REQUIRE_FALSE(map.insert({1, Tracked(0)}).second);
+        REQUIRE(Tracked::live == 500);
+
+        Unordered_map<int, Tracked, std::hash<int>, std::equal_to<int>, TestType> copy(map);
+        REQUIRE(Tracked::live == 1000);
+        copy.clear();
+        REQUIRE(Tracked::live == 500);
+        copy = map;
+        copy.reserve(4096);
+        REQUIRE(Tracked::live == 1000);
+        REQUIRE(copy.at(501).value == 1503);
+    }
+    REQUIRE(Tracked::live == 0);
+}
+
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::size_t outstanding = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        outstanding += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+TEST_CASE("Test Unordered_map polymorphic allocator", "[Unordered_map]") {
+    using Map = pmr::Unordered_map<std::pmr::string, int, TransparentStringHash, std::equal_to<>, RobinHoodMapPolicy>;
+    CountingResource resource;
+    CountingResource other_resource;
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    {
+        Map map{Map::allocator_type(&resource)};
+        for (int i = 0; i < 100; ++i) {
+            map.emplace(std::pmr::string("a key longer than the small string buffer " + std::to_string(i), &resource), i);
+        }
+        REQUIRE(resource.outstanding > 100 * 40);
+        REQUIRE(map.get_allocator().resource() == &resource);
+        REQUIRE(map.begin()->first.get_allocator().resource() == &resource);
+
+        Map copy(map, Map::allocator_type(&other_resource));
+        REQUIRE(copy.size() == 100);
+        REQUIRE(copy.begin()->first.get_allocator().resource() == &other_resource);
+
+        map = std::move(copy);
+        REQUIRE(map.size() == 100);
+        REQUIRE(copy.empty());
+        REQUIRE(map.at(std::string_view("a key longer than the small string buffer 42")) == 42);
+        REQUIRE(map.begin()->first.get_allocator().resource() == &resource);
+
+        map.clear();
+        REQUIRE(resource.outstanding == 0);
+    }
+    std::pmr::set_default_resource(previous);
+    REQUIRE(other_resource.outstanding == 0);
+}
+
+TEST_CASE("Test Unordered_map node handles keep pmr keys in place", "[Unordered_map]") {
+    std::pmr::monotonic_buffer_resource resource;
+    pmr::Unordered_map<std::pmr::string, int> source(&resource);
+    pmr::Unordered_map<std::pmr::string, int> target(&resource);
+    source.insert({std::pmr::string("a key long enough to live outside the string object", &resource), 1});
+    const char* data = source.begin()->first.data();
+
+    auto node = source.extract(source.begin());
+    REQUIRE(node.key().data() == data);
+    REQUIRE(target.insert(std::move(node)).inserted);
+    REQUIRE(target.begin()->first.data() == data);
+
+    target.merge(source);
+    source.merge(target);
+    REQUIRE(target.empty());
+    REQUIRE(source.begin()->first.data() == data);
+}
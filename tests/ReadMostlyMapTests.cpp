@@ -0,0 +1,93 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../unordered_map/read_mostly_unordered_map.h"
+
+TEST_CASE("Test ReadMostlyUnordered_map methods", "[ReadMostlyUnordered_map]") {
+    ReadMostlyUnordered_map<std::string, int> map;
+    REQUIRE(map.empty());
+
+    SECTION("Test insert, find and erase") {
+        REQUIRE(map.insert({"192.168.1.1HT", 1}));
+        REQUIRE_FALSE(map.insert({"192.168.1.1HT", 2}));
+        REQUIRE(map.find("192.168.1.1HT") == 1);
+        REQUIRE_FALSE(map.find("192.168.1.2F").has_value());
+        REQUIRE(map.contains("192.168.1.1HT"));
+        REQUIRE(map.erase("192.168.1.1HT") == 1);
+        REQUIRE(map.erase("192.168.1.1HT") == 0);
+        REQUIRE(map.empty());
+    }
+
+    SECTION("Test insert_or_assign and growth") {
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(map.insert_or_assign(std::to_string(i), i));
+        }
+        REQUIRE_FALSE(map.insert_or_assign("7", 70));
+        REQUIRE(map.size() == 1000);
+        REQUIRE(map.capacity() >= 2000);
+        REQUIRE(map.find("7") == 70);
+        int sum = 0;
+        map.for_each([&](const std::pair<std::string, int>& entry) { sum += entry.second; });
+        REQUIRE(sum == 999 * 1000 / 2 + 63);
+        map.clear();
+        REQUIRE(map.empty());
+        REQUIRE_FALSE(map.contains("7"));
+    }
+}
+
+struct Counted {
+    static inline std::atomic<int> live = 0;
+    int value;
+    explicit Counted(int value) : value(value) { ++live; }
+    Counted(const Counted& other) : value(other.value) { ++live; }
+    ~Counted() { --live; }
+};
+
+TEST_CASE("Test ReadMostlyUnordered_map with concurrent readers", "[ReadMostlyUnordered_map]") {
+    Counted::live = 0;
+    {
+        ReadMostlyUnordered_map<int, Counted> map;
+        for (int i = 0; i < 100; ++i) {
+            map.insert({i, Counted(i)});
+        }
+
+        std::atomic<bool> done = false;
+        std::atomic<int> errors = 0;
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 3; ++t) {
+            readers.emplace_back([&] {
+                while (!done.load()) {
+                    for (int i = 0; i < 100; ++i) {
+                        bool found = map.visit(i, [&](const Counted& value) {
+                            if (value.value != i && value.value != i + 1000) {
+                                ++errors;
+                            }
+                        });
+                        if (!found) {
+                            ++errors;
+                        }
+                    }
+                }
+            });
+        }
+
+        for (int round = 0; round < 20000; ++round) {
+            map.insert_or_assign(round % 100, Counted(round % 100 + (round / 100 % 2) * 1000));
+            map.insert({100 + round, Counted(round)});
+            if (round >= 50) {
+                map.erase(100 + round - 50);
+            }
+        }
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        REQUIRE(errors == 0);
+        REQUIRE(map.size() == 150);
+    }
+    REQUIRE(Counted::live == 0);
+}
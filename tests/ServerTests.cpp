@@ -45,6 +45,27 @@ TEST_CASE("Server tests", "[Server]") {
         REQUIRE(server.findByPriority("192.168.0.2") == nullptr);
     }
 
+    SECTION("Copying and moving servers") {
+        Server server("TestServer", "192.168.0.1");
+        std::shared_ptr<Packet> packet = std::make_shared<MailPacket>("192.168.0.1", "192.168.0.2", "Sender", "Hello");
+        server.addPacketToTransmissionTable(packet);
+
+        Server copy(server);
+        REQUIRE(copy.eraseByPriority("192.168.0.2"));
+        REQUIRE(server.findByPriority("192.168.0.2") == packet);
+
+        Server moved(std::move(server));
+        REQUIRE(moved.getServerName() == "TestServer");
+        REQUIRE(moved.findByPriority("192.168.0.2") == packet);
+
+        server = std::move(moved);
+        copy = server;
+        REQUIRE(copy.findByPriority("192.168.0.2") == packet);
+        REQUIRE(server.eraseByPriority("192.168.0.2"));
+        REQUIRE(copy.findByPriority("192.168.0.2") == packet);
+        REQUIRE(server.findByPriority("192.168.0.2") == nullptr);
+    }
+
 }
 
 TEST_CASE("Server methods", "[Server]") {
@@ -59,7 +80,65 @@ TEST_CASE("Server methods", "[Server]") {
         std::ostringstream oss;
         server.showSendersInfo(oss);
 
-        REQUIRE(oss.str() == "Sender Address: 192.168.1.2\nSender Address: 192.168.1.1\n");
+        // The table is seeded per instance, so the senders may come in either order.
+        REQUIRE((oss.str() == "Sender Address: 192.168.1.2\nSender Address: 192.168.1.1\n" ||
+                 oss.str() == "Sender Address: 192.168.1.1\nSender Address: 192.168.1.2\n"));
+    }
+
+    SECTION("getPacketTypeCounts") {
+        Server server("TestServer", "192.168.1.1");
+        server.addPacketToTransmissionTable(std::make_shared<MailPacket>("192.168.1.1", "192.168.1.2", "John", "Hello"));
+        server.addPacketToTransmissionTable(std::make_shared<MailPacket>("192.168.1.1", "192.168.1.3", "John", "Hello"));
+        server.addPacketToTransmissionTable(std::make_shared<HyperTextPacket>("192.168.1.3", "192.168.1.4", Data::CodeType::ASCII, Data::InfoType::Control, "Hi"));
+
+        Server::PacketTypeCounts counts = server.getPacketTypeCounts();
+        REQUIRE(counts[Server::packetTypes.index_of("HT")] == 1);
+        REQUIRE(counts[Server::packetTypes.index_of("F")] == 0);
+        REQUIRE(counts[Server::packetTypes.index_of("M")] == 2);
+        REQUIRE(Server::packetTypes.at("M") == "Mail");
+        REQUIRE(server.calculatePacketTypePercentage("X") == 0.0f);
+        REQUIRE(server.calculatePacketTypePercentageMT("X") == 0.0f);
+        REQUIRE(server.findByPriority("192.168.1.4")->getType() == "HT");
+    }
+
+    SECTION("snapshotTable") {
+        Server server("TestServer", "192.168.1.1");
+        server.addPacketToTransmissionTable(std::make_shared<MailPacket>("192.168.1.1", "192.168.1.2", "John", "Hello"));
+        Server::TableSnapshot snapshot = server.snapshotTable();
+        server.addPacketToTransmissionTable(std::make_shared<MailPacket>("192.168.1.5", "192.168.1.3", "John", "Hello"));
+        REQUIRE(server.eraseByPriority("192.168.1.2"));
+
+        std::ostringstream oss;
+        Server::showSendersInfo(oss, snapshot);
+        REQUIRE(oss.str() == "Sender Address: 192.168.1.1\n");
+        REQUIRE(Server::getPacketTypeCounts(snapshot)[Server::packetTypes.index_of("M")] == 1);
+        REQUIRE(server.getPacketTypeCounts()[Server::packetTypes.index_of("M")] == 1);
+    }
+
+    SECTION("snapshotTable outliving the server") {
+        Server::TableSnapshot snapshot;
+        {
+            Server server("TestServer", "192.168.1.1");
+            server.addPacketToTransmissionTable(std::make_shared<MailPacket>("192.168.1.1", "192.168.1.2", "John", "Hello"));
+            snapshot = server.snapshotTable();
+        }
+        std::ostringstream oss;
+        Server::showSendersInfo(oss, snapshot);
+        REQUIRE(oss.str() == "Sender Address: 192.168.1.1\n");
+        REQUIRE(Server::getPacketTypeCounts(snapshot)[Server::packetTypes.index_of("M")] == 1);
+    }
+
+    SECTION("getTableStats") {
+        Server server("TestServer", "192.168.1.1");
+        REQUIRE(server.getTableStats().size == 0);
+        server.addPacketToTransmissionTable(std::make_shared<MailPacket>("192.168.1.1", "192.168.1.2", "John", "Hello"));
+        REQUIRE(server.findByPriority("192.168.1.2") != nullptr);
+
+        MapStats stats = server.getTableStats();
+        REQUIRE(stats.size == 1);
+        REQUIRE(MapStats::count(stats.insert_probes) == 1);
+        REQUIRE(MapStats::count(stats.find_probes) >= 1);
+        REQUIRE(stats.bytes_allocated > 0);
     }
 
     SECTION("calculatePacketTypePercentage") {
@@ -82,6 +161,17 @@ TEST_CASE("Server methods", "[Server]") {
         REQUIRE(hyperTextPercentage == Approx(33.3333).epsilon(0.01));
     }
 
+    SECTION("calculatePacketTypePercentage with a receiver address not ending in a digit") {
+        Server server("TestServer", "192.168.1.1");
+        server.addPacketToTransmissionTable(std::make_shared<FilePacket>("10.0.0.1", "10.0.0.2", Data::CodeType::ASCII, Data::InfoType::Control, "Data"));
+        server.addPacketToTransmissionTable(std::make_shared<FilePacket>("10.0.0.1", "mailhost", Data::CodeType::ASCII, Data::InfoType::Control, "Data"));
+
+        REQUIRE(server.calculatePacketTypePercentage("F") == Approx(100.0f));
+        REQUIRE(server.calculatePacketTypePercentageMT("F") == Approx(100.0f));
+        REQUIRE(server.getPacketTypeCounts()[Server::packetTypes.index_of("F")] == 2);
+        REQUIRE(Server::getPacketTypeCounts(server.snapshotTable())[Server::packetTypes.index_of("F")] == 2);
+    }
+
     SECTION("calculatePacketTypePercentageMT") {
         Server server("TestServer", "192.168.1.1");
         std::shared_ptr<Packet> packet1 = std::make_shared<MailPacket>("192.168.1.1", "192.168.1.2", "John", "Hello");
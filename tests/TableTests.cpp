@@ -1,5 +1,6 @@
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch.hpp>
+#include <thread>
 #include "../include/TransmissionTable.h"
 
 TEST_CASE("TransmissionTable tests", "[TransmissionTable]") {
@@ -24,6 +25,18 @@ TEST_CASE("TransmissionTable tests", "[TransmissionTable]") {
             REQUIRE(table.find("192.168.1.4", "F") == nullptr);
         }
 
+        SECTION("Finding and erasing by priority") {
+            REQUIRE(table.findFirst("192.168.1.4", {"F", "HT", "M"}) == packet3);
+            REQUIRE(table.findFirst("192.168.1.1", {"HT", "M"}) == nullptr);
+            REQUIRE(table.eraseFirst("192.168.1.1", {"HT", "F", "M"}));
+            REQUIRE_FALSE(table.eraseFirst("192.168.1.1", {"HT", "F", "M"}));
+            REQUIRE(table.size() == 2);
+            std::shared_ptr<Packet> odd = std::make_shared<MailPacket>("192.168.1.1", "host", "Jon", "Hi");
+            table.insert(odd);
+            REQUIRE(table.findFirst("host", {"HT", "M"}) == odd);
+            REQUIRE(table.eraseFirst("host", {"M"}));
+        }
+
         SECTION("Erasing packets") {
             REQUIRE(table.erase("192.168.1.2", "M"));
             REQUIRE(table.size() == 2);
@@ -45,6 +58,55 @@ TEST_CASE("TransmissionTable tests", "[TransmissionTable]") {
             auto constPacket = constTable[pair2];
             REQUIRE(constPacket == packet2);
         }
+
+        SECTION("Moving packets between tables") {
+            TransmissionTable other;
+            other.insert(std::make_shared<MailPacket>("10.0.0.1", "192.168.1.2", "Jon", "Again"));
+            other.insert(std::make_shared<MailPacket>("10.0.0.1", "10.0.0.2", "Jon", "Hi"));
+
+            auto node = table.extract("192.168.1.1", "F");
+            REQUIRE(node);
+            REQUIRE(node.mapped() == packet2);
+            REQUIRE(table.size() == 2);
+            REQUIRE(table.extract("192.168.1.1", "F").empty());
+            REQUIRE(other.insert(std::move(node)));
+            REQUIRE(other.find("192.168.1.1", "F") == packet2);
+            REQUIRE(packet2.use_count() == 2);
+
+            table.merge(other);
+            REQUIRE(table.size() == 4);
+            REQUIRE(table.find("10.0.0.2", "M") != nullptr);
+            REQUIRE(other.size() == 1);
+            REQUIRE(table.find("192.168.1.2", "M") == packet1);
+        }
+
+        SECTION("Batch insertion and lookup") {
+            std::vector<std::shared_ptr<Packet>> burst;
+            for (int i = 0; i < 100; ++i) {
+                burst.push_back(std::make_shared<MailPacket>("10.0.0.1", "10.0.1." + std::to_string(i), "Jon", "Hi"));
+            }
+            burst.push_back(packet1);
+            REQUIRE(table.insert(burst) == 100);
+            REQUIRE(table.size() == 103);
+
+            std::vector<std::string> addresses;
+            for (int i = 0; i < 100; ++i) {
+                addresses.push_back("10.0.1." + std::to_string(i));
+            }
+            std::vector<PacketKey> keys;
+            for (const auto& address : addresses) {
+                keys.push_back({address, "M"});
+            }
+            keys.push_back({"192.168.1.4", "HT"});
+            keys.push_back({"10.0.1.0", "F"});
+            auto found = table.find(keys);
+            REQUIRE(found.size() == 102);
+            for (int i = 0; i < 100; ++i) {
+                REQUIRE(found[i] == burst[i]);
+            }
+            REQUIRE(found[100] == packet3);
+            REQUIRE(found[101] == nullptr);
+        }
     }
 
     SECTION("Stream insertion operator") {
@@ -88,3 +150,261 @@ TEST_CASE("TransmissionTable tests", "[TransmissionTable]") {
         }
     }
 }
+
+TEST_CASE("TransmissionTable receiver filter", "[TransmissionTable]") {
+    TransmissionTable table;
+    REQUIRE(table.receiverFilterStats().memory_bytes == 0);
+    table.insert(std::make_shared<MailPacket>("10.0.0.1", "10.0.0.2", "Jon", "Hello"));
+    table.enableReceiverFilter(16);
+
+    std::vector<std::shared_ptr<Packet>> burst;
+    for (int i = 0; i < 500; ++i) {
+        burst.push_back(std::make_shared<FilePacket>("10.0.0.1", "10.1." + std::to_string(i / 256) + "." + std::to_string(i % 256),
+                                                     Data::CodeType::ASCII, Data::InfoType::Control, "Data"));
+    }
+    table.insert(burst);
+    for (int i = 0; i < 500; i += 2) {
+        table.insert(std::make_shared<MailPacket>("10.0.0.1", "10.1." + std::to_string(i / 256) + "." + std::to_string(i % 256), "Jon", "Hi"));
+    }
+
+    SECTION("Present receivers pass the filter") {
+        REQUIRE(table.find("10.0.0.2", "M") != nullptr);
+        for (int i = 0; i < 500; ++i) {
+            std::string ip = "10.1." + std::to_string(i / 256) + "." + std::to_string(i % 256);
+            REQUIRE(table.findFirst(ip, {"HT", "F", "M"}) != nullptr);
+            REQUIRE(table.contains(ip, "M") == (i % 2 == 0));
+        }
+        auto stats = table.receiverFilterStats();
+        REQUIRE(stats.keys == 751);
+        REQUIRE(stats.capacity >= 751);
+        REQUIRE(stats.memory_bytes == stats.capacity * BlockedBloomFilter::counters_per_key / 2);
+    }
+
+    SECTION("Absent receivers are mostly rejected by the filter") {
+        std::size_t finds = MapStats::count(table.tableStats().find_probes);
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(table.findFirst("10.2." + std::to_string(i / 256) + "." + std::to_string(i % 256), {"HT", "F", "M"}) == nullptr);
+        }
+        auto stats = table.receiverFilterStats();
+        // Confirming a false positive probes no type the lookup already tried.
+        REQUIRE(MapStats::count(table.tableStats().find_probes) - finds == 3 * stats.false_positives);
+        REQUIRE(stats.queries == 10000);
+        REQUIRE(stats.negatives + stats.false_positives == 10000);
+        REQUIRE(stats.measured_false_positive_rate() < 0.05);
+        REQUIRE(stats.estimated_false_positive_rate < 0.05);
+    }
+
+    SECTION("Misses of other types are not false positives") {
+        for (int i = 0; i < 500; ++i) {
+            REQUIRE(table.findFirst("10.1." + std::to_string(i / 256) + "." + std::to_string(i % 256), {"HT"}) == nullptr);
+        }
+        REQUIRE(table.findFirst("10.0.0.2", {"F", "HT"}) == nullptr);
+        auto stats = table.receiverFilterStats();
+        REQUIRE(stats.queries == 501);
+        REQUIRE(stats.false_positives == 0);
+        REQUIRE(stats.measured_false_positive_rate() == 0);
+    }
+
+    SECTION("Removed packets leave the filter") {
+        for (int i = 0; i < 500; ++i) {
+            std::string ip = "10.1." + std::to_string(i / 256) + "." + std::to_string(i % 256);
+            REQUIRE(table.eraseFirst(ip, {"F"}));
+            REQUIRE(table.erase(ip, "M") == (i % 2 == 0));
+        }
+        auto node = table.extract("10.0.0.2", "M");
+        REQUIRE(table.empty());
+        REQUIRE(table.receiverFilterStats().keys == 0);
+        REQUIRE(table.receiverFilterStats().estimated_false_positive_rate == 0);
+        REQUIRE(table.find("10.0.0.2", "M") == nullptr);
+        REQUIRE(table.insert(std::move(node)));
+        REQUIRE(table.find("10.0.0.2", "M") != nullptr);
+    }
+
+    SECTION("Merged packets are counted by the receiving table") {
+        TransmissionTable other;
+        other.enableReceiverFilter();
+        other.insert(std::make_shared<MailPacket>("10.0.0.1", "10.3.0.1", "Jon", "Hi"));
+        other.insert(std::make_shared<MailPacket>("10.0.0.1", "10.0.0.2", "Jon", "Hi"));
+        table.merge(other);
+        REQUIRE(table.find("10.3.0.1", "M") != nullptr);
+        REQUIRE(other.find("10.0.0.2", "M") != nullptr);
+        REQUIRE(other.receiverFilterStats().keys == 1);
+    }
+
+    SECTION("Disabling the filter keeps the packets") {
+        table.disableReceiverFilter();
+        REQUIRE(table.receiverFilterStats().queries == 0);
+        REQUIRE(table.find("10.1.0.0", "M") != nullptr);
+    }
+}
+
+TEST_CASE("TransmissionTable statistics", "[TransmissionTable]") {
+    TransmissionTable table;
+    for (int i = 0; i < 300; ++i) {
+        table.insert(std::make_shared<MailPacket>("10.0.0.1", "10.4." + std::to_string(i / 256) + "." + std::to_string(i % 256), "Jon", "Hi"));
+    }
+    for (int i = 0; i < 300; ++i) {
+        REQUIRE(table.find("10.4." + std::to_string(i / 256) + "." + std::to_string(i % 256), "M") != nullptr);
+    }
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(table.erase("10.4." + std::to_string(i / 256) + "." + std::to_string(i % 256), "M"));
+    }
+
+    MapStats stats = table.tableStats();
+    REQUIRE(MapStats::count(stats.insert_probes) == 300);
+    REQUIRE(MapStats::count(stats.find_probes) == 400);
+    REQUIRE(MapStats::mean(stats.find_probes) >= 1);
+    REQUIRE(stats.rehashes > 0);
+    REQUIRE(stats.size == 200);
+    REQUIRE(stats.effective_load >= stats.load);
+    REQUIRE(stats.bytes_allocated > 0);
+}
+
+TEST_CASE("TransmissionTable memory follows the packet count", "[TransmissionTable]") {
+    TransmissionTable table;
+    table.enableReceiverFilter();
+    auto ipOf = [](int i) {
+        return "10.5." + std::to_string(i / 256) + "." + std::to_string(i % 256);
+    };
+    for (int i = 0; i < 5000; ++i) {
+        table.insert(std::make_shared<MailPacket>("10.0.0.1", ipOf(i), "Jon", "Hi"));
+    }
+    std::size_t peakBytes = table.tableStats().bytes_allocated;
+    std::size_t peakFilterBytes = table.receiverFilterStats().memory_bytes;
+
+    SECTION("Draining a burst shrinks the table and the filter") {
+        for (int i = 0; i < 4900; ++i) {
+            REQUIRE(table.erase(ipOf(i), "M"));
+        }
+        REQUIRE(table.tableStats().bytes_allocated < peakBytes / 8);
+        REQUIRE(table.receiverFilterStats().memory_bytes < peakFilterBytes / 8);
+        for (int i = 4900; i < 5000; ++i) {
+            REQUIRE(table.find(ipOf(i), "M") != nullptr);
+        }
+        REQUIRE(table.find(ipOf(0), "M") == nullptr);
+    }
+
+    SECTION("shrinkToFit releases the rest") {
+        for (int i = 0; i < 4000; ++i) {
+            REQUIRE(table.extract(ipOf(i), "M"));
+        }
+        std::size_t bytes = table.tableStats().bytes_allocated;
+        table.shrinkToFit();
+        REQUIRE(table.tableStats().bytes_allocated < bytes);
+        REQUIRE(table.receiverFilterStats().keys == 1000);
+        for (int i = 4000; i < 5000; ++i) {
+            REQUIRE(table.contains(ipOf(i), "M"));
+        }
+    }
+}
+
+TEST_CASE("TransmissionTable shrinks when drained during a growth", "[TransmissionTable]") {
+    TransmissionTable table;
+    auto ipOf = [](int i) {
+        return "10.8." + std::to_string(i / 256) + "." + std::to_string(i % 256);
+    };
+    int count = 0;
+    for (; count < 100; ++count) {
+        table.insert(std::make_shared<MailPacket>("10.0.0.1", ipOf(count), "Jon", "Hi"));
+    }
+    // Stop right after the next growth, while the old slots are still being migrated.
+    std::size_t rehashes = table.tableStats().rehashes;
+    while (table.tableStats().rehashes == rehashes) {
+        table.insert(std::make_shared<MailPacket>("10.0.0.1", ipOf(count++), "Jon", "Hi"));
+    }
+    std::size_t peakCapacity = table.tableStats().capacity;
+
+    // Some of the packets kept are still in the old slots.
+    auto kept = [](int i) {
+        return i < 100 && i % 10 == 0;
+    };
+
+    SECTION("Draining through eraseFirst") {
+        for (int i = 0; i < count; ++i) {
+            if (!kept(i)) {
+                REQUIRE(table.eraseFirst(ipOf(i), {"HT", "F", "M"}));
+            }
+        }
+    }
+
+    SECTION("Draining through erase") {
+        for (int i = 0; i < count; ++i) {
+            if (!kept(i)) {
+                REQUIRE(table.erase(ipOf(i), "M"));
+            }
+        }
+    }
+
+    MapStats stats = table.tableStats();
+    REQUIRE(stats.size == 10);
+    REQUIRE(stats.capacity < peakCapacity / 4);
+    for (int i = 0; i < 100; i += 10) {
+        REQUIRE(table.find(ipOf(i), "M") != nullptr);
+    }
+}
+
+TEST_CASE("TransmissionTable snapshots", "[TransmissionTable]") {
+    TransmissionTable table;
+    auto ipOf = [](int i) {
+        return "10.6." + std::to_string(i / 256) + "." + std::to_string(i % 256);
+    };
+    for (int i = 0; i < 2000; ++i) {
+        table.insert(std::make_shared<MailPacket>("10.0.0.1", ipOf(i), "Jon", "Hi"));
+    }
+    TransmissionTable::Snapshot snapshot = table.snapshot();
+
+    std::size_t counted = 0;
+    std::thread reader([&] {
+        snapshot.for_each([&counted](const auto& entry) {
+            counted += entry.second->getReceiverAddress().rfind("10.6.", 0) == 0;
+        });
+    });
+    for (int i = 0; i < 2000; ++i) {
+        REQUIRE(table.erase(ipOf(i), "M"));
+        table.insert(std::make_shared<MailPacket>("10.0.0.2", "10.7." + std::to_string(i / 256) + "." + std::to_string(i % 256), "Jon", "Hi"));
+    }
+    reader.join();
+
+    REQUIRE(counted == 2000);
+    REQUIRE(snapshot.size() == 2000);
+    REQUIRE(table.size() == 2000);
+    REQUIRE(table.find(ipOf(0), "M") == nullptr);
+}
+
+TEST_CASE("TransmissionTable key functors", "[TransmissionTable]") {
+    PacketKeyHash hash;
+    PacketKeyEqual equal;
+    std::string stored = "192.168.1.4HT";
+
+    SECTION("Composite keys hash like concatenated keys") {
+        REQUIRE(hash(PacketKey{"192.168.1.4", "HT"}) == hash(stored));
+        std::string longIp(100, '1');
+        REQUIRE(hash(PacketKey{longIp, "M"}) == hash(longIp + "M"));
+        REQUIRE(hash(PacketKey{"192.168.1.", "4HT"}) == hash(stored));
+        REQUIRE(hash(PacketKey{"host", "HT"}) == hash(std::string_view("hostHT")));
+    }
+
+    SECTION("Key hashes derive from the IP address hash") {
+        std::size_t ipHash = hash.hashIp("192.168.1.4");
+        REQUIRE(hash.combine(ipHash, "HT") == hash(stored));
+        REQUIRE(hash.combine(ipHash, "F") == hash(std::string_view("192.168.1.4F")));
+        REQUIRE(hash.combine(ipHash, "F") != hash.combine(ipHash, "M"));
+        REQUIRE(hash.combine(ipHash, "LONGTYPE") == hash(std::string_view("192.168.1.4LONGTYPE")));
+    }
+
+    SECTION("Every hash instance is seeded differently") {
+        PacketKeyHash other;
+        REQUIRE(other.hash.seed() != hash.hash.seed());
+        REQUIRE(other(stored) != hash(stored));
+        PacketKeyHash copy = hash;
+        REQUIRE(copy(PacketKey{"192.168.1.4", "HT"}) == hash(stored));
+    }
+
+    SECTION("Composite keys compare by their parts") {
+        REQUIRE(equal(stored, PacketKey{"192.168.1.4", "HT"}));
+        REQUIRE(equal(PacketKey{"192.168.1.4", "HT"}, stored));
+        REQUIRE_FALSE(equal(stored, PacketKey{"192.168.1.4", "F"}));
+        REQUIRE(equal(stored, PacketKey{"192.168.1.", "4HT"}));
+        REQUIRE_FALSE(equal(stored, PacketKey{"192.168.1.40", "HT"}));
+    }
+}
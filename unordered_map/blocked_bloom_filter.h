@@ -0,0 +1,242 @@
+#ifndef BLOCKED_BLOOM_FILTER_H
+#define BLOCKED_BLOOM_FILTER_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief A counting Bloom filter whose counters for a key all lie in one cache line.
+ *
+ * Every 64-byte block holds 128 four-bit counters. A key selects one block with the high bits
+ * of its hash and hash_count counters inside it with the rest, so answering a query touches a
+ * single cache line. Counters support removal; a counter that reaches 15 saturates and is never
+ * decremented again, which keeps the filter free of false negatives.
+ *
+ * The filter is sized for a number of keys; a caller adding more than capacity() keys should
+ * rebuild it larger with reset(), as the false-positive rate climbs quickly past that point.
+ *
+ * The filter also counts the queries it answers, so their share of definite negatives and of
+ * positives that turned out false can be reported; the counters may be updated by concurrent
+ * const queries.
+ */
+class BlockedBloomFilter {
+public:
+    typedef std::size_t size_type; /**< Type representing sizes and counts. */
+
+    static constexpr size_type hash_count = 6; /**< Number of counters set per key. */
+    static constexpr size_type counters_per_key = 16; /**< Number of counters provisioned per key of the capacity. */
+
+    /**
+     * @brief Memory use, fill and query statistics of a filter.
+     */
+    struct Stats {
+        size_type memory_bytes = 0; /**< Bytes of counter blocks. */
+        size_type keys = 0; /**< Number of keys added and not removed. */
+        size_type capacity = 0; /**< Number of keys the filter is sized for. */
+        double estimated_false_positive_rate = 0; /**< Chance that a query of an absent key passes, from the counter fill. */
+        size_type queries = 0; /**< Number of queries answered. */
+        size_type negatives = 0; /**< Number of queries answered with a definite no. */
+        size_type false_positives = 0; /**< Number of positive answers reported as false by the caller. */
+
+        /**
+         * @brief Returns the measured false-positive rate.
+         *
+         * @return Share of queries of absent keys that passed the filter, 0 if there were none.
+         */
+        double measured_false_positive_rate() const {
+            size_type absent = negatives + false_positives;
+            return absent == 0 ? 0.0 : static_cast<double>(false_positives) / static_cast<double>(absent);
+        }
+    };
+
+    /**
+     * @brief Constructs an empty filter.
+     *
+     * @param capacity Number of keys to size the filter for.
+     */
+    explicit BlockedBloomFilter(size_type capacity = 1024) {
+        reset(capacity);
+    }
+
+    /**
+     * @brief Adds a key.
+     *
+     * @param hash The hash of the key, all 64 bits of it well mixed.
+     */
+    void add(std::uint64_t hash) {
+        Block& block = block_of(hash);
+        std::uint64_t bits = counter_bits(hash);
+        for (size_type i = 0; i < hash_count; ++i, bits >>= 7) {
+            size_type counter = bits & 127;
+            std::uint64_t& word = block.words[counter / 16];
+            unsigned shift = (counter % 16) * 4;
+            if (((word >> shift) & 0xF) != 0xF) {
+                word += std::uint64_t{1} << shift;
+            }
+        }
+        ++keys;
+    }
+
+    /**
+     * @brief Removes a key added before.
+     *
+     * Removing a key that was never added may introduce false negatives.
+     *
+     * @param hash The hash of the key.
+     */
+    void remove(std::uint64_t hash) {
+        Block& block = block_of(hash);
+        std::uint64_t bits = counter_bits(hash);
+        for (size_type i = 0; i < hash_count; ++i, bits >>= 7) {
+            size_type counter = bits & 127;
+            std::uint64_t& word = block.words[counter / 16];
+            unsigned shift = (counter % 16) * 4;
+            std::uint64_t value = (word >> shift) & 0xF;
+            if (value != 0xF && value != 0) {
+                word -= std::uint64_t{1} << shift;
+            }
+        }
+        keys -= keys != 0;
+    }
+
+    /**
+     * @brief Checks if a key may have been added.
+     *
+     * @param hash The hash of the key.
+     * @return False if the key is definitely absent, true if it may be present.
+     */
+    bool might_contain(std::uint64_t hash) const {
+        const Block& block = block_of(hash);
+        std::uint64_t bits = counter_bits(hash);
+        bool present = true;
+        for (size_type i = 0; i < hash_count; ++i, bits >>= 7) {
+            size_type counter = bits & 127;
+            present &= ((block.words[counter / 16] >> ((counter % 16) * 4)) & 0xF) != 0;
+        }
+        queries.fetch_add(1, std::memory_order_relaxed);
+        if (!present) {
+            negatives.fetch_add(1, std::memory_order_relaxed);
+        }
+        return present;
+    }
+
+    /**
+     * @brief Records that a positive answer of might_contain() was false.
+     */
+    void report_false_positive() const {
+        false_positives.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Removes all keys and resizes the filter, keeping the query statistics.
+     *
+     * @param capacity Number of keys to size the filter for.
+     */
+    void reset(size_type capacity) {
+        size_type count = std::bit_ceil(std::max<size_type>(1, (capacity * counters_per_key + counters_per_block - 1) / counters_per_block));
+        blocks.assign(count, Block{});
+        block_shift = 64 - std::countr_zero(count);
+        keys = 0;
+    }
+
+    /**
+     * @brief Returns the number of keys added and not removed.
+     *
+     * @return Number of keys.
+     */
+    size_type size() const {
+        return keys;
+    }
+
+    /**
+     * @brief Returns the number of keys the filter is sized for.
+     *
+     * @return Number of keys.
+     */
+    size_type capacity() const {
+        return blocks.size() * counters_per_block / counters_per_key;
+    }
+
+    /**
+     * @brief Collects the statistics of the filter. Scans every block.
+     *
+     * @return The statistics.
+     */
+    Stats stats() const {
+        Stats result;
+        result.memory_bytes = blocks.size() * sizeof(Block);
+        result.keys = keys;
+        result.capacity = capacity();
+        size_type used = 0;
+        for (const Block& block : blocks) {
+            for (std::uint64_t word : block.words) {
+                std::uint64_t nonzero = (word | word >> 1 | word >> 2 | word >> 3) & 0x1111111111111111ull;
+                used += std::popcount(nonzero);
+            }
+        }
+        double fill = static_cast<double>(used) / static_cast<double>(blocks.size() * counters_per_block);
+        result.estimated_false_positive_rate = 1;
+        for (size_type i = 0; i < hash_count; ++i) {
+            result.estimated_false_positive_rate *= fill;
+        }
+        result.queries = queries.load(std::memory_order_relaxed);
+        result.negatives = negatives.load(std::memory_order_relaxed);
+        result.false_positives = false_positives.load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    static constexpr size_type counters_per_block = 128; /**< Number of four-bit counters in a block. */
+
+    /**
+     * @brief A cache line of 128 four-bit counters.
+     */
+    struct alignas(64) Block {
+        std::uint64_t words[8] = {}; /**< The counters, 16 per word. */
+    };
+
+    /**
+     * @brief A query counter that copies its current value along with the filter.
+     */
+    struct Counter : std::atomic<size_type> {
+        Counter() : std::atomic<size_type>(0) {}
+        Counter(const Counter& other) : std::atomic<size_type>(other.load(std::memory_order_relaxed)) {}
+        Counter& operator=(const Counter& other) {
+            store(other.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+    };
+
+    std::vector<Block> blocks; /**< The counter blocks, a power of two of them. */
+    unsigned block_shift = 64; /**< Shift selecting the block from the high bits of a hash. */
+    size_type keys = 0; /**< Number of keys added and not removed. */
+    mutable Counter queries; /**< Number of queries answered. */
+    mutable Counter negatives; /**< Number of queries answered with a definite no. */
+    mutable Counter false_positives; /**< Number of positive answers reported as false. */
+
+    /**
+     * @brief Returns the block of a key.
+     */
+    Block& block_of(std::uint64_t hash) {
+        return blocks[block_shift == 64 ? 0 : hash >> block_shift];
+    }
+
+    /**
+     * @brief Returns the block of a key (const version).
+     */
+    const Block& block_of(std::uint64_t hash) const {
+        return blocks[block_shift == 64 ? 0 : hash >> block_shift];
+    }
+
+    /**
+     * @brief Derives the counter indices of a key, 7 bits each, independent of its block.
+     */
+    static std::uint64_t counter_bits(std::uint64_t hash) {
+        return hash * 0x9E3779B97F4A7C15ull;
+    }
+};
+
+#endif //BLOCKED_BLOOM_FILTER_H
@@ -0,0 +1,362 @@
+#ifndef CONCURRENT_UNORDERED_MAP_H
+#define CONCURRENT_UNORDERED_MAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include "unordered_map.h"
+
+/**
+ * @brief A thread-safe unordered map made of independently locked Unordered_map shards.
+ *
+ * Every key belongs to exactly one shard, chosen by the high bits of its mixed hash, so threads
+ * working on different shards never contend. Lookups take the shard lock shared, modifications
+ * take it exclusively. Each shard keeps its element count in an atomic next to its lock, so size()
+ * needs no lock at all.
+ *
+ * Elements are never exposed by reference outside a lock: lookups return copies of the mapped
+ * values, and visit() and for_each() run a callback while the shard is locked.
+ *
+ * @tparam Key Type of the keys stored in the map.
+ * @tparam T Type of the values stored in the map.
+ * @tparam Hash Hash function for computing hash values of keys.
+ * @tparam KeyEqual Function object for comparing keys for equality.
+ * @tparam Policy Compile-time options of the shards, see DefaultMapPolicy.
+ * @tparam Allocator Allocator of the shards.
+ */
+template<class Key, class T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>, class Policy = DefaultMapPolicy,
+         class Allocator = std::allocator<std::pair<Key, T>>>
+class ConcurrentUnordered_map {
+public:
+    typedef Unordered_map<Key, T, Hash, KeyEqual, Policy, Allocator> map_type; /**< Type of a shard. */
+    typedef Key key_type; /**< Type of the keys stored in the map. */
+    typedef T mapped_type; /**< Type of the values stored in the map. */
+    typedef std::pair<Key, T> value_type; /**< Type representing key-value pairs stored in the map. */
+    typedef Hash hasher; /**< Type of the hash function. */
+    typedef KeyEqual key_equal; /**< Type of the function object for comparing keys for equality. */
+    typedef std::size_t size_type; /**< Type representing sizes and indices. */
+    typedef Allocator allocator_type; /**< Type of the allocator. */
+
+    /**
+     * @brief Returns the default number of shards, four per hardware thread.
+     *
+     * @return Number of shards.
+     */
+    static size_type default_shard_count() {
+        return std::max(1u, std::thread::hardware_concurrency()) * 4;
+    }
+
+    /**
+     * @brief Constructs an empty map.
+     *
+     * @param shard_count Number of shards, at least 1.
+     * @param alloc The allocator of all shards.
+     */
+    explicit ConcurrentUnordered_map(size_type shard_count = default_shard_count(), const Allocator& alloc = Allocator())
+        : ConcurrentUnordered_map(shard_count, Hash(), alloc) {}
+
+    /**
+     * @brief Constructs an empty map using a given hash function.
+     *
+     * @param shard_count Number of shards, at least 1.
+     * @param hash The hash function, used both to choose shards and within every shard.
+     * @param alloc The allocator of all shards.
+     */
+    ConcurrentUnordered_map(size_type shard_count, const Hash& hash, const Allocator& alloc = Allocator()) : hash_(hash) {
+        shards.reserve(std::max<size_type>(shard_count, 1));
+        for (size_type i = 0; i < std::max<size_type>(shard_count, 1); ++i) {
+            shards.push_back(std::make_unique<Shard>(hash_, alloc));
+        }
+    }
+
+    ConcurrentUnordered_map(const ConcurrentUnordered_map&) = delete;
+    ConcurrentUnordered_map& operator=(const ConcurrentUnordered_map&) = delete;
+
+    /**
+     * @brief Inserts an element if its key is not present yet.
+     *
+     * @param value The key-value pair to insert.
+     * @return True if the insertion took place, false if the key already existed.
+     */
+    bool insert(const value_type& value) {
+        return update(shard_for(value.first), [&](map_type& map) { return map.insert(value).second; });
+    }
+
+    /**
+     * @brief Inserts an element if its key is not present yet (move version).
+     *
+     * @param value The key-value pair to insert.
+     * @return True if the insertion took place, false if the key already existed.
+     */
+    bool insert(value_type&& value) {
+        Shard& shard = shard_for(value.first);
+        return update(shard, [&](map_type& map) { return map.insert(std::move(value)).second; });
+    }
+
+    /**
+     * @brief Inserts a new element constructed from a key and arguments for the value constructor.
+     *
+     * @tparam Args Types of the arguments for the value constructor.
+     * @param key The key of the new element.
+     * @param args Arguments for the value constructor.
+     * @return True if the insertion took place, false if the key already existed.
+     */
+    template<typename... Args>
+    bool emplace(const key_type& key, Args&&... args) {
+        return update(shard_for(key), [&](map_type& map) { return map.emplace(key, std::forward<Args>(args)...).second; });
+    }
+
+    /**
+     * @brief Erases the element with a specific key.
+     *
+     * @param key The key of the element to erase.
+     * @return Number of elements erased (0 or 1).
+     */
+    size_type erase(const key_type& key) {
+        return erase_key(key);
+    }
+
+    /**
+     * @brief Erases the element with a key equivalent to a key-like value.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value equivalent to the key of the element to erase.
+     * @return Number of elements erased (0 or 1).
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    size_type erase(const K& key) {
+        return erase_key(key);
+    }
+
+    /**
+     * @brief Returns a copy of the value mapped to a specific key.
+     *
+     * @param key The key of the element to search for.
+     * @return The mapped value if the key is present, std::nullopt otherwise.
+     */
+    std::optional<mapped_type> find(const key_type& key) const {
+        return find_key(key);
+    }
+
+    /**
+     * @brief Returns a copy of the value mapped to a key equivalent to a key-like value.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value to search for.
+     * @return The mapped value if an equivalent key is present, std::nullopt otherwise.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    std::optional<mapped_type> find(const K& key) const {
+        return find_key(key);
+    }
+
+    /**
+     * @brief Checks if the map contains an element with the given key.
+     *
+     * @param key The key to search for.
+     * @return True if the key is present, false otherwise.
+     */
+    bool contains(const key_type& key) const {
+        return contains_key(key);
+    }
+
+    /**
+     * @brief Checks if the map contains an element with a key equivalent to a key-like value.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value to search for.
+     * @return True if an equivalent key is present, false otherwise.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    bool contains(const K& key) const {
+        return contains_key(key);
+    }
+
+    /**
+     * @brief Calls a function on the value mapped to a key while its shard is locked exclusively.
+     *
+     * @tparam F Type of the function, callable with mapped_type&.
+     * @param key The key of the element to visit.
+     * @param f The function to call.
+     * @return True if the key was present and the function was called, false otherwise.
+     */
+    template<class F>
+    bool visit(const key_type& key, F&& f) {
+        Shard& shard = shard_for(key);
+        std::unique_lock lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            return false;
+        }
+        f(it->second);
+        return true;
+    }
+
+    /**
+     * @brief Calls a function on every element, one shard at a time under a shared lock.
+     *
+     * The elements of each shard are seen consistently; elements of different shards may be seen
+     * before or after concurrent modifications.
+     *
+     * @tparam F Type of the function, callable with const value_type&.
+     * @param f The function to call.
+     */
+    template<class F>
+    void for_each(F&& f) const {
+        for (const auto& shard : shards) {
+            std::shared_lock lock(shard->mutex);
+            for (const auto& entry : shard->map) {
+                f(entry);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the number of elements, without locking.
+     *
+     * @return Sum of the shard sizes at the time they were read.
+     */
+    size_type size() const {
+        size_type total = 0;
+        for (const auto& shard : shards) {
+            total += shard->size.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    /**
+     * @brief Checks if the map is empty, without locking.
+     *
+     * @return True if no shard holds an element.
+     */
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Removes all elements, one shard at a time.
+     */
+    void clear() {
+        for (auto& shard : shards) {
+            std::unique_lock lock(shard->mutex);
+            shard->map.clear();
+            shard->size.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Returns the number of shards.
+     *
+     * @return Number of shards.
+     */
+    size_type shard_count() const {
+        return shards.size();
+    }
+
+private:
+    /**
+     * @brief A shard with its lock and element count, aligned to its own cache lines.
+     */
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex; /**< Lock of the shard, shared for lookups. */
+        std::atomic<size_type> size{0}; /**< Number of elements in the shard. */
+        map_type map; /**< Elements of the shard. */
+
+        /**
+         * @brief Constructs an empty shard.
+         *
+         * @param hash The hash function of the shard.
+         * @param alloc The allocator of the shard.
+         */
+        Shard(const Hash& hash, const Allocator& alloc) : map(hash, alloc) {}
+    };
+
+    [[no_unique_address]] Hash hash_; /**< Hash function choosing the shard of a key. */
+    std::vector<std::unique_ptr<Shard>> shards; /**< The shards, each allocated separately. */
+
+    /**
+     * @brief Returns the shard owning a key.
+     *
+     * The shard is chosen by the high half of the finalized hash, which neither capacity policy of
+     * the shards uses for slot selection, so the keys of a shard still spread over all its slots.
+     *
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key.
+     * @return Reference to the shard.
+     */
+    template<class K>
+    Shard& shard_for(const K& key) const {
+        std::uint64_t mixed = PowerOfTwoCapacity::mix(hash_(key));
+        return *shards[(mixed >> 32) % shards.size()];
+    }
+
+    /**
+     * @brief Runs a modification of a shard under its exclusive lock and publishes its new size.
+     *
+     * @tparam F Type of the modification, returning its result.
+     * @param shard The shard to modify.
+     * @param f The modification.
+     * @return The result of the modification.
+     */
+    template<class F>
+    auto update(Shard& shard, F&& f) {
+        std::unique_lock lock(shard.mutex);
+        auto result = f(shard.map);
+        shard.size.store(shard.map.size(), std::memory_order_relaxed);
+        return result;
+    }
+
+    /**
+     * @brief Erases a key from its shard.
+     *
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key of the element to erase.
+     * @return Number of elements erased (0 or 1).
+     */
+    template<class K>
+    size_type erase_key(const K& key) {
+        return update(shard_for(key), [&](map_type& map) { return map.erase(key); });
+    }
+
+    /**
+     * @brief Copies the value mapped to a key out of its shard.
+     *
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key to search for.
+     * @return The mapped value if the key is present, std::nullopt otherwise.
+     */
+    template<class K>
+    std::optional<mapped_type> find_key(const K& key) const {
+        const Shard& shard = shard_for(key);
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    /**
+     * @brief Checks if the shard of a key contains it.
+     *
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key to search for.
+     * @return True if the key is present, false otherwise.
+     */
+    template<class K>
+    bool contains_key(const K& key) const {
+        const Shard& shard = shard_for(key);
+        std::shared_lock lock(shard.mutex);
+        return shard.map.contains(key);
+    }
+};
+
+#endif //CONCURRENT_UNORDERED_MAP_H
@@ -0,0 +1,202 @@
+#ifndef FAST_HASH_H
+#define FAST_HASH_H
+
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string_view>
+
+/**
+ * @brief A fast seeded hash function for strings and integers, in the wyhash family.
+ *
+ * Strings are consumed 8 or 16 bytes at a time and folded with 64x64->128 bit multiplications,
+ * which is several times faster than std::hash on the short IP+type keys of the transmission
+ * table. Every default-constructed instance draws its own random seed, so a sender who knows the
+ * algorithm still cannot compute a set of keys that collide in a particular table: flooding one
+ * table with crafted keys does not cluster its probe sequences.
+ *
+ * Copies share the seed of the original, which keeps copied and moved maps consistent with the
+ * hashes already placed in their control bytes.
+ */
+struct FastHash {
+    using is_transparent = void; /**< Hashes std::string, std::string_view and string literals alike. */
+
+    /**
+     * @brief Constructs a hash function with a fresh random seed.
+     */
+    FastHash() : seed_(next_seed()) {}
+
+    /**
+     * @brief Constructs a hash function with a given seed, for reproducible hashes.
+     *
+     * @param seed The seed.
+     */
+    explicit FastHash(std::uint64_t seed) : seed_(seed) {}
+
+    /**
+     * @brief Hashes a string.
+     *
+     * @param key The string to hash.
+     * @return The hash of the string under this instance's seed.
+     */
+    std::size_t operator()(std::string_view key) const {
+        return hash_bytes(reinterpret_cast<const unsigned char*>(key.data()), key.size(), seed_);
+    }
+
+    /**
+     * @brief Hashes an integer.
+     *
+     * @tparam I Type of the integer.
+     * @param key The integer to hash.
+     * @return The hash of the integer under this instance's seed.
+     */
+    template<std::integral I>
+    std::size_t operator()(I key) const {
+        return mix(static_cast<std::uint64_t>(key) ^ secret[0], seed_ ^ secret[1]);
+    }
+
+    /**
+     * @brief Returns the seed of the hash function.
+     *
+     * @return The seed.
+     */
+    std::uint64_t seed() const {
+        return seed_;
+    }
+
+    /**
+     * @brief Compares two hash functions.
+     *
+     * @return True if both hash every key to the same value.
+     */
+    friend bool operator==(const FastHash& lhs, const FastHash& rhs) {
+        return lhs.seed_ == rhs.seed_;
+    }
+
+private:
+    static constexpr std::uint64_t secret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+                                                0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull}; /**< Odd constants with balanced bits. */
+
+    std::uint64_t seed_; /**< Seed folded into every hash. */
+
+    /**
+     * @brief Returns a new seed for every call.
+     *
+     * The random device is read once per process; later seeds mix it with a counter, which is as
+     * unpredictable to a remote sender and keeps constructing maps cheap.
+     *
+     * @return The seed.
+     */
+    static std::uint64_t next_seed() {
+        static const std::uint64_t base = (static_cast<std::uint64_t>(std::random_device{}()) << 32) ^ std::random_device{}();
+        static std::atomic<std::uint64_t> counter{0};
+        return mix(base ^ secret[2], counter.fetch_add(1, std::memory_order_relaxed) ^ secret[3]);
+    }
+
+    /**
+     * @brief Multiplies two 64-bit values into a 128-bit product.
+     *
+     * @param a The first factor, replaced by the low half of the product.
+     * @param b The second factor, replaced by the high half of the product.
+     */
+    static void multiply(std::uint64_t& a, std::uint64_t& b) {
+#ifdef __SIZEOF_INT128__
+        __uint128_t product = static_cast<__uint128_t>(a) * b;
+        a = static_cast<std::uint64_t>(product);
+        b = static_cast<std::uint64_t>(product >> 64);
+#else
+        std::uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<std::uint32_t>(a), lb = static_cast<std::uint32_t>(b);
+        std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+        std::uint64_t t = rl + (rm0 << 32);
+        std::uint64_t carry = t < rl;
+        std::uint64_t lo = t + (rm1 << 32);
+        carry += lo < t;
+        a = lo;
+        b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+    }
+
+    /**
+     * @brief Multiplies two 64-bit values and folds the 128-bit product.
+     *
+     * @return The exclusive or of the low and high halves of the product.
+     */
+    static std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+        multiply(a, b);
+        return a ^ b;
+    }
+
+    /**
+     * @brief Reads 8 unaligned bytes.
+     */
+    static std::uint64_t read8(const unsigned char* p) {
+        std::uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Reads 4 unaligned bytes.
+     */
+    static std::uint64_t read4(const unsigned char* p) {
+        std::uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Hashes a byte string.
+     *
+     * Keys of up to 16 bytes, which covers every IPv4 key, are read as at most four overlapping
+     * words without a loop.
+     *
+     * @param p The bytes.
+     * @param length Number of bytes.
+     * @param seed The seed.
+     * @return The hash.
+     */
+    static std::uint64_t hash_bytes(const unsigned char* p, std::size_t length, std::uint64_t seed) {
+        seed ^= mix(seed ^ secret[0], secret[1]);
+        std::uint64_t a, b;
+        if (length <= 16) {
+            if (length >= 4) {
+                std::size_t shift = (length >> 3) << 2;
+                a = (read4(p) << 32) | read4(p + shift);
+                b = (read4(p + length - 4) << 32) | read4(p + length - 4 - shift);
+            } else if (length > 0) {
+                a = (static_cast<std::uint64_t>(p[0]) << 16) | (static_cast<std::uint64_t>(p[length >> 1]) << 8) | p[length - 1];
+                b = 0;
+            } else {
+                a = b = 0;
+            }
+        } else {
+            std::size_t i = length;
+            if (i > 48) {
+                std::uint64_t seed1 = seed, seed2 = seed;
+                do {
+                    seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+                    seed1 = mix(read8(p + 16) ^ secret[2], read8(p + 24) ^ seed1);
+                    seed2 = mix(read8(p + 32) ^ secret[3], read8(p + 40) ^ seed2);
+                    p += 48;
+                    i -= 48;
+                } while (i > 48);
+                seed ^= seed1 ^ seed2;
+            }
+            while (i > 16) {
+                seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+                p += 16;
+                i -= 16;
+            }
+            a = read8(p + i - 16);
+            b = read8(p + i - 8);
+        }
+        a ^= secret[1];
+        b ^= seed;
+        multiply(a, b);
+        return mix(a ^ secret[0] ^ length, b ^ secret[1]);
+    }
+};
+
+#endif //FAST_HASH_H
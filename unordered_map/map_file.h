@@ -0,0 +1,243 @@
+#ifndef MAP_FILE_H
+#define MAP_FILE_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAP_FILE_MMAP 1
+#else
+#include <fstream>
+#include <vector>
+#endif
+
+/**
+ * @brief A file mapped into memory copy-on-write.
+ *
+ * The pages are readable and writable, but writes stay private to the process and never reach
+ * the file, so a table whose storage lies in the mapping can be modified like any other. Pages
+ * are read from the file when first touched. Without mmap the file is read into memory instead.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Maps a whole file.
+     *
+     * @param path Path of the file.
+     * @throw std::system_error if the file cannot be opened or mapped.
+     */
+    explicit MappedFile(const std::string& path) {
+#ifdef MAP_FILE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "Cannot stat " + path);
+        }
+        size_ = static_cast<std::size_t>(info.st_size);
+        if (size_ != 0) {
+            void* data = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "Cannot map " + path);
+            }
+            data_ = static_cast<char*>(data);
+        }
+        ::close(fd);
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory), "Cannot open " + path);
+        }
+        size_ = static_cast<std::size_t>(in.tellg());
+        // 64-byte words keep every section of the file as aligned as in a mapping.
+        buffer_.resize((size_ + sizeof(Line) - 1) / sizeof(Line));
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(size_));
+        data_ = reinterpret_cast<char*>(buffer_.data());
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~MappedFile() {
+#ifdef MAP_FILE_MMAP
+        if (data_ != nullptr) {
+            ::munmap(data_, size_);
+        }
+#endif
+    }
+
+    /**
+     * @brief Returns the first byte of the file.
+     *
+     * @return Pointer to the mapping, page-aligned.
+     */
+    char* data() const {
+        return data_;
+    }
+
+    /**
+     * @brief Returns the size of the file.
+     *
+     * @return Number of bytes.
+     */
+    std::size_t size() const {
+        return size_;
+    }
+
+private:
+    char* data_ = nullptr; /**< First byte of the mapping. */
+    std::size_t size_ = 0; /**< Size of the file in bytes. */
+#ifndef MAP_FILE_MMAP
+    struct alignas(64) Line {
+        char bytes[64];
+    };
+    std::vector<Line> buffer_; /**< Contents of the file. */
+#endif
+};
+
+/**
+ * @brief Fixed-size header at the start of a saved Unordered_map.
+ *
+ * Every section is located by its offset from the start of the file, so the file can be
+ * mapped at any address. Sections start on 64-byte boundaries.
+ */
+struct MapFileHeader {
+    static constexpr std::uint64_t magic_value = 0x454c494650414d55ull; /**< "UMAPFILE" read as a little-endian integer. */
+    static constexpr std::uint32_t version_value = 2; /**< Version of the format. */
+    static constexpr std::uint32_t byte_order_value = 0x01020304; /**< Reads differently on a machine of the other byte order. */
+    static constexpr std::uint32_t raw_entries = 1; /**< Flag: the entry section is a copy of the slot array. */
+
+    std::uint64_t magic = magic_value; /**< Identifies the format. */
+    std::uint32_t version = version_value; /**< Version of the format. */
+    std::uint32_t byte_order = byte_order_value; /**< Byte order mark. */
+    std::uint64_t layout = 0; /**< Hash of the map type and its entry size, which must match on loading. */
+    std::uint32_t flags = 0; /**< Combination of the flags above. */
+    float max_load = 0; /**< Maximum load factor. */
+    float min_load = 0; /**< Minimum load factor. */
+    std::uint32_t hash_bytes = 0; /**< Size of the hash function state. */
+    std::uint64_t size = 0; /**< Number of elements. */
+    std::uint64_t capacity = 0; /**< Number of slots. */
+    std::uint64_t tombstones = 0; /**< Number of deleted slots. */
+    std::uint64_t hash_offset = 0; /**< Offset of the hash function state. */
+    std::uint64_t ctrl_offset = 0; /**< Offset of the control bytes, clones included. */
+    std::uint64_t dist_offset = 0; /**< Offset of the Robin Hood distances, 0 without them. */
+    std::uint64_t entries_offset = 0; /**< Offset of the entry section. */
+    std::uint64_t entries_bytes = 0; /**< Size of the entry section. */
+    std::uint64_t file_size = 0; /**< Size of the whole file. */
+
+    /**
+     * @brief Rounds an offset up to the start of the next section.
+     *
+     * @param offset The offset.
+     * @return The offset rounded up to a multiple of 64.
+     */
+    static constexpr std::uint64_t align(std::uint64_t offset) noexcept {
+        return (offset + 63) & ~std::uint64_t{63};
+    }
+};
+
+/**
+ * @brief Encodes keys and values of a saved Unordered_map whose elements are not copied byte for byte.
+ *
+ * The primary template handles trivially copyable types; other types, such as the elements of a
+ * table of packets, need a specialization with the same two functions.
+ *
+ * @tparam T Type of the keys or values.
+ */
+template<class T>
+struct MapCodec {
+    static_assert(std::is_trivially_copyable_v<T>, "MapCodec needs a specialization for this type");
+
+    /**
+     * @brief Appends a value to a stream.
+     *
+     * @param out The stream.
+     * @param value The value.
+     */
+    static void write(std::ostream& out, const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /**
+     * @brief Decodes a value and advances past it.
+     *
+     * @param pos The read position.
+     * @param end End of the readable bytes.
+     * @return The value.
+     * @throw std::runtime_error if the bytes end first.
+     */
+    static T read(const char*& pos, const char* end) {
+        if (static_cast<std::size_t>(end - pos) < sizeof(T)) {
+            throw std::runtime_error("Unordered_map file is truncated");
+        }
+        T value;
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+};
+
+/**
+ * @brief Encodes strings as their length followed by their characters.
+ *
+ * @tparam CharT Type of the characters.
+ * @tparam Traits Traits of the characters.
+ * @tparam Alloc Allocator of the string.
+ */
+template<class CharT, class Traits, class Alloc>
+struct MapCodec<std::basic_string<CharT, Traits, Alloc>> {
+    typedef std::basic_string<CharT, Traits, Alloc> string_type; /**< Type of the strings. */
+
+    /**
+     * @brief Appends a string to a stream.
+     *
+     * @param out The stream.
+     * @param value The string.
+     */
+    static void write(std::ostream& out, const string_type& value) {
+        MapCodec<std::uint64_t>::write(out, value.size());
+        out.write(reinterpret_cast<const char*>(value.data()), static_cast<std::streamsize>(value.size() * sizeof(CharT)));
+    }
+
+    /**
+     * @brief Decodes a string and advances past it.
+     *
+     * @param pos The read position.
+     * @param end End of the readable bytes.
+     * @return The string.
+     * @throw std::runtime_error if the bytes end first.
+     */
+    static string_type read(const char*& pos, const char* end) {
+        std::uint64_t length = MapCodec<std::uint64_t>::read(pos, end);
+        if (static_cast<std::size_t>(end - pos) / sizeof(CharT) < length) {
+            throw std::runtime_error("Unordered_map file is truncated");
+        }
+        string_type value(length, CharT());
+        std::memcpy(value.data(), pos, length * sizeof(CharT));
+        pos += length * sizeof(CharT);
+        return value;
+    }
+};
+
+#endif //MAP_FILE_H
@@ -0,0 +1,627 @@
+#ifndef READ_MOSTLY_UNORDERED_MAP_H
+#define READ_MOSTLY_UNORDERED_MAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "unordered_map.h"
+
+/**
+ * @brief Process-wide epoch-based reclamation domain.
+ *
+ * Readers pin the current epoch while they hold pointers into shared structures. Writers retire
+ * unlinked memory tagged with the epoch of its removal and free it once every pinned reader has
+ * moved past that epoch. Pinning writes only to a per-thread record on its own cache line, so
+ * readers never write memory shared with other threads.
+ */
+class EpochDomain {
+private:
+    /**
+     * @brief Pinning state of one thread, reused by later threads after it exits.
+     */
+    struct alignas(64) Record {
+        std::atomic<std::uint64_t> epoch{0}; /**< Pinned epoch, 0 when the thread holds no guard. */
+        std::atomic<bool> in_use{true}; /**< Whether a live thread owns the record. */
+        unsigned depth = 0; /**< Number of nested guards, touched only by the owning thread. */
+        Record* next = nullptr; /**< Next record of the domain. */
+    };
+
+public:
+    /**
+     * @brief Returns the domain. It is never destroyed, so threads may exit at any time.
+     *
+     * @return Reference to the domain.
+     */
+    static EpochDomain& instance() {
+        static EpochDomain* domain = new EpochDomain();
+        return *domain;
+    }
+
+    /**
+     * @brief Pins the current epoch for the lifetime of the guard. Guards may be nested.
+     */
+    class Guard {
+    public:
+        /**
+         * @brief Pins the current epoch of the calling thread.
+         */
+        Guard() : record(EpochDomain::instance().local()) {
+            if (record->depth++ == 0) {
+                record->epoch.store(EpochDomain::instance().current(), std::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+
+        /**
+         * @brief Unpins the epoch once the outermost guard of the thread is destroyed.
+         */
+        ~Guard() {
+            if (--record->depth == 0) {
+                record->epoch.store(0, std::memory_order_release);
+            }
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        Record* record; /**< Record of the calling thread. */
+    };
+
+    /**
+     * @brief Returns the current epoch.
+     *
+     * @return The current epoch, never 0.
+     */
+    std::uint64_t current() const {
+        return epoch.load(std::memory_order_seq_cst);
+    }
+
+    /**
+     * @brief Advances the epoch and returns the oldest epoch still pinned by a reader.
+     *
+     * Memory retired in an epoch below the returned one can no longer be reached by any reader.
+     *
+     * @return The oldest pinned epoch, or the maximum value if no reader is pinned.
+     */
+    std::uint64_t advance() {
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+        for (Record* record = records.load(std::memory_order_acquire); record != nullptr; record = record->next) {
+            std::uint64_t pinned = record->epoch.load(std::memory_order_seq_cst);
+            if (pinned != 0) {
+                oldest = std::min(oldest, pinned);
+            }
+        }
+        return oldest;
+    }
+
+private:
+    /**
+     * @brief Releases the record of a thread when the thread exits.
+     */
+    struct LocalRecord {
+        Record* record; /**< The record owned by the thread. */
+        ~LocalRecord() {
+            record->in_use.store(false, std::memory_order_release);
+        }
+    };
+
+    std::atomic<std::uint64_t> epoch{1}; /**< The global epoch. */
+    std::atomic<Record*> records{nullptr}; /**< All records ever created, never freed. */
+
+    EpochDomain() = default;
+
+    /**
+     * @brief Returns the record of the calling thread, claiming a free one or creating one on first use.
+     *
+     * @return Pointer to the record.
+     */
+    Record* local() {
+        thread_local LocalRecord local{acquire()};
+        return local.record;
+    }
+
+    /**
+     * @brief Claims a record released by an exited thread, or publishes a new one.
+     *
+     * @return Pointer to the claimed record.
+     */
+    Record* acquire() {
+        for (Record* record = records.load(std::memory_order_acquire); record != nullptr; record = record->next) {
+            bool expected = false;
+            if (!record->in_use.load(std::memory_order_relaxed) &&
+                record->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return record;
+            }
+        }
+        Record* record = new Record();
+        Record* head = records.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+        return record;
+    }
+};
+
+/**
+ * @brief A hash map for read-mostly workloads whose lookups take no locks.
+ *
+ * Slots hold atomic pointers to immutable nodes. Readers pin an epoch, load the published slot
+ * array and probe it without writing any shared memory. Writers are serialized by a mutex: they
+ * publish new nodes and new slot arrays with release stores, mark erased slots with a tombstone
+ * and retire unlinked nodes and arrays to the EpochDomain, which frees them once no reader can
+ * still see them. Assigning to an existing key replaces its node, so readers always observe
+ * either the old or the new value, never a torn one.
+ *
+ * Lookups return copies of the mapped values; visit() and for_each() run a callback on the
+ * elements while the epoch is pinned.
+ *
+ * @tparam Key Type of the keys stored in the map.
+ * @tparam T Type of the values stored in the map.
+ * @tparam Hash Hash function for computing hash values of keys.
+ * @tparam KeyEqual Function object for comparing keys for equality.
+ */
+template<class Key, class T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>>
+class ReadMostlyUnordered_map {
+public:
+    typedef Key key_type; /**< Type of the keys stored in the map. */
+    typedef T mapped_type; /**< Type of the values stored in the map. */
+    typedef std::pair<Key, T> value_type; /**< Type representing key-value pairs stored in the map. */
+    typedef Hash hasher; /**< Type of the hash function. */
+    typedef KeyEqual key_equal; /**< Type of the function object for comparing keys for equality. */
+    typedef std::size_t size_type; /**< Type representing sizes and indices. */
+
+    /**
+     * @brief Constructs an empty map.
+     *
+     * @param capacity Initial number of slots, rounded up to a power of two.
+     * @param hash The hash function of the keys.
+     */
+    explicit ReadMostlyUnordered_map(size_type capacity = 16, const Hash& hash = Hash())
+        : table(new Table(std::bit_ceil(std::max<size_type>(capacity, 2)))), hash_(hash) {}
+
+    ReadMostlyUnordered_map(const ReadMostlyUnordered_map&) = delete;
+    ReadMostlyUnordered_map& operator=(const ReadMostlyUnordered_map&) = delete;
+
+    /**
+     * @brief Destructor. No other thread may access the map any more.
+     */
+    ~ReadMostlyUnordered_map() {
+        Table* current = table.load(std::memory_order_relaxed);
+        delete_nodes(current);
+        delete current;
+        for (auto& item : retired) {
+            item.deleter(item.ptr);
+        }
+    }
+
+    /**
+     * @brief Returns a copy of the value mapped to a specific key.
+     *
+     * @param key The key of the element to search for.
+     * @return The mapped value if the key is present, std::nullopt otherwise.
+     */
+    std::optional<mapped_type> find(const key_type& key) const {
+        return find_key(key);
+    }
+
+    /**
+     * @brief Returns a copy of the value mapped to a key equivalent to a key-like value.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value to search for.
+     * @return The mapped value if an equivalent key is present, std::nullopt otherwise.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    std::optional<mapped_type> find(const K& key) const {
+        return find_key(key);
+    }
+
+    /**
+     * @brief Checks if the map contains an element with the given key.
+     *
+     * @param key The key to search for.
+     * @return True if the key is present, false otherwise.
+     */
+    bool contains(const key_type& key) const {
+        return visit(key, [](const mapped_type&) {});
+    }
+
+    /**
+     * @brief Checks if the map contains an element with a key equivalent to a key-like value.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value to search for.
+     * @return True if an equivalent key is present, false otherwise.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    bool contains(const K& key) const {
+        return visit(key, [](const mapped_type&) {});
+    }
+
+    /**
+     * @brief Calls a function on the value mapped to a key while the epoch is pinned.
+     *
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @tparam F Type of the function, callable with const mapped_type&.
+     * @param key The key of the element to visit.
+     * @param f The function to call.
+     * @return True if the key was present and the function was called, false otherwise.
+     */
+    template<class K, class F>
+    bool visit(const K& key, F&& f) const {
+        EpochDomain::Guard guard;
+        const Node* node = find_node(table.load(std::memory_order_acquire), key, hash_of(key));
+        if (node == nullptr) {
+            return false;
+        }
+        f(node->value.second);
+        return true;
+    }
+
+    /**
+     * @brief Calls a function on every element of the slot array published at the time of the call.
+     *
+     * Concurrent modifications may or may not be observed.
+     *
+     * @tparam F Type of the function, callable with const value_type&.
+     * @param f The function to call.
+     */
+    template<class F>
+    void for_each(F&& f) const {
+        EpochDomain::Guard guard;
+        const Table* current = table.load(std::memory_order_acquire);
+        for (size_type i = 0; i < current->capacity; ++i) {
+            const Node* node = current->slots[i].load(std::memory_order_acquire);
+            if (node != nullptr && node != tombstone()) {
+                f(node->value);
+            }
+        }
+    }
+
+    /**
+     * @brief Inserts an element if its key is not present yet.
+     *
+     * @param value The key-value pair to insert.
+     * @return True if the insertion took place, false if the key already existed.
+     */
+    bool insert(const value_type& value) {
+        return insert(value_type(value));
+    }
+
+    /**
+     * @brief Inserts an element if its key is not present yet (move version).
+     *
+     * @param value The key-value pair to insert.
+     * @return True if the insertion took place, false if the key already existed.
+     */
+    bool insert(value_type&& value) {
+        std::lock_guard lock(write_mutex);
+        std::size_t hash = hash_of(value.first);
+        auto [slot, found] = probe(value.first, hash);
+        if (found) {
+            return false;
+        }
+        publish_new(slot, new Node{std::move(value), hash});
+        return true;
+    }
+
+    /**
+     * @brief Inserts an element or replaces the value of an existing one.
+     *
+     * @tparam M Type of the value.
+     * @param key The key of the element.
+     * @param obj The value to insert or assign.
+     * @return True if the element was inserted, false if its value was replaced.
+     */
+    template<class M>
+    bool insert_or_assign(const key_type& key, M&& obj) {
+        std::lock_guard lock(write_mutex);
+        std::size_t hash = hash_of(key);
+        auto [slot, found] = probe(key, hash);
+        Node* node = new Node{value_type(key, std::forward<M>(obj)), hash};
+        if (!found) {
+            publish_new(slot, node);
+            return true;
+        }
+        Table* current = table.load(std::memory_order_relaxed);
+        Node* old = current->slots[slot].exchange(node, std::memory_order_acq_rel);
+        retire(old);
+        return false;
+    }
+
+    /**
+     * @brief Erases the element with a specific key.
+     *
+     * @param key The key of the element to erase.
+     * @return Number of elements erased (0 or 1).
+     */
+    size_type erase(const key_type& key) {
+        std::lock_guard lock(write_mutex);
+        auto [slot, found] = probe(key, hash_of(key));
+        if (!found) {
+            return 0;
+        }
+        Table* current = table.load(std::memory_order_relaxed);
+        Node* old = current->slots[slot].exchange(tombstone(), std::memory_order_acq_rel);
+        count.store(count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        retire(old);
+        return 1;
+    }
+
+    /**
+     * @brief Removes all elements.
+     */
+    void clear() {
+        std::lock_guard lock(write_mutex);
+        Table* old = table.load(std::memory_order_relaxed);
+        table.store(new Table(old->capacity), std::memory_order_release);
+        for (size_type i = 0; i < old->capacity; ++i) {
+            Node* node = old->slots[i].load(std::memory_order_relaxed);
+            if (node != nullptr && node != tombstone()) {
+                retire(node);
+            }
+        }
+        retire(old);
+        count.store(0, std::memory_order_relaxed);
+        used = 0;
+    }
+
+    /**
+     * @brief Returns the number of elements.
+     *
+     * @return Number of elements.
+     */
+    size_type size() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Checks if the map is empty.
+     *
+     * @return True if the map holds no element.
+     */
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Returns the number of slots of the published slot array.
+     *
+     * @return Capacity of the map.
+     */
+    size_type capacity() const {
+        EpochDomain::Guard guard;
+        return table.load(std::memory_order_acquire)->capacity;
+    }
+
+private:
+    /**
+     * @brief An element, immutable once published.
+     */
+    struct Node {
+        value_type value; /**< The key-value pair. */
+        std::size_t hash; /**< The mixed hash of the key. */
+    };
+
+    /**
+     * @brief A slot array, replaced as a whole when the map grows.
+     */
+    struct Table {
+        size_type capacity; /**< Number of slots, a power of two. */
+        std::unique_ptr<std::atomic<Node*>[]> slots; /**< The slots, null if never used. */
+
+        /**
+         * @brief Allocates an array of empty slots.
+         *
+         * @param capacity Number of slots.
+         */
+        explicit Table(size_type capacity) : capacity(capacity), slots(new std::atomic<Node*>[capacity]) {
+            for (size_type i = 0; i < capacity; ++i) {
+                slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    /**
+     * @brief Memory waiting until no reader can reach it.
+     */
+    struct Retired {
+        void* ptr; /**< The unlinked object. */
+        void (*deleter)(void*); /**< Frees the object. */
+        std::uint64_t epoch; /**< Epoch in which the object was unlinked. */
+    };
+
+    static constexpr size_type reclaim_threshold = 64; /**< Number of retired objects that triggers a reclamation pass. */
+
+    std::atomic<Table*> table; /**< The published slot array. */
+    std::atomic<size_type> count{0}; /**< Number of elements. */
+    size_type used = 0; /**< Number of slots holding an element or a tombstone, guarded by write_mutex. */
+    std::mutex write_mutex; /**< Serializes writers. */
+    std::vector<Retired> retired; /**< Retired objects, guarded by write_mutex. */
+    [[no_unique_address]] Hash hash_; /**< Hash function of the keys, never modified. */
+
+    /**
+     * @brief Returns the marker stored in the slots of erased elements.
+     *
+     * @return A pointer that is never dereferenced.
+     */
+    static Node* tombstone() {
+        static char marker;
+        return reinterpret_cast<Node*>(&marker);
+    }
+
+    /**
+     * @brief Computes the mixed hash of a key.
+     *
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key to hash.
+     * @return The finalized hash.
+     */
+    template<class K>
+    std::size_t hash_of(const K& key) const {
+        return PowerOfTwoCapacity::mix(hash_(key));
+    }
+
+    /**
+     * @brief Probes a slot array for a key. Safe to call concurrently with writers.
+     *
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param current The slot array.
+     * @param key The key to search for.
+     * @param hash The mixed hash of the key.
+     * @return Pointer to the node of the key, or null if not found.
+     */
+    template<class K>
+    static const Node* find_node(const Table* current, const K& key, std::size_t hash) {
+        size_type pos = PowerOfTwoCapacity::index(hash, current->capacity);
+        for (size_type probed = 0; probed < current->capacity; ++probed) {
+            const Node* node = current->slots[pos].load(std::memory_order_acquire);
+            if (node == nullptr) {
+                return nullptr;
+            }
+            if (node != tombstone() && node->hash == hash && key_equal{}(node->value.first, key)) {
+                return node;
+            }
+            pos = PowerOfTwoCapacity::wrap(pos + 1, current->capacity);
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Copies the value mapped to a key while the epoch is pinned.
+     *
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key to search for.
+     * @return The mapped value if the key is present, std::nullopt otherwise.
+     */
+    template<class K>
+    std::optional<mapped_type> find_key(const K& key) const {
+        EpochDomain::Guard guard;
+        const Node* node = find_node(table.load(std::memory_order_acquire), key, hash_of(key));
+        if (node == nullptr) {
+            return std::nullopt;
+        }
+        return node->value.second;
+    }
+
+    /**
+     * @brief Finds the slot of a key, or the slot to insert it into. Writers only.
+     *
+     * @param key The key to search for.
+     * @param hash The mixed hash of the key.
+     * @return Pair with the slot index and a bool indicating whether the key was found there.
+     */
+    std::pair<size_type, bool> probe(const key_type& key, std::size_t hash) {
+        Table* current = table.load(std::memory_order_relaxed);
+        size_type pos = PowerOfTwoCapacity::index(hash, current->capacity);
+        size_type free = current->capacity;
+        for (size_type probed = 0; probed < current->capacity; ++probed) {
+            Node* node = current->slots[pos].load(std::memory_order_relaxed);
+            if (node == nullptr) {
+                return {free != current->capacity ? free : pos, false};
+            }
+            if (node == tombstone()) {
+                if (free == current->capacity) {
+                    free = pos;
+                }
+            } else if (node->hash == hash && key_equal{}(node->value.first, key)) {
+                return {pos, true};
+            }
+            pos = PowerOfTwoCapacity::wrap(pos + 1, current->capacity);
+        }
+        return {free, false};
+    }
+
+    /**
+     * @brief Publishes a node for a new key in a slot returned by probe, growing the map first if needed.
+     *
+     * @param slot The slot returned by probe.
+     * @param node The new node.
+     */
+    void publish_new(size_type slot, Node* node) {
+        Table* current = table.load(std::memory_order_relaxed);
+        if (current->slots[slot].load(std::memory_order_relaxed) == nullptr) {
+            if ((used + 1) * 2 > current->capacity) {
+                current = grow();
+                slot = probe(node->value.first, node->hash).first;
+            }
+            ++used;
+        }
+        current->slots[slot].store(node, std::memory_order_release);
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Publishes a slot array holding the current elements without tombstones.
+     *
+     * The nodes are shared with the old array, which is retired.
+     *
+     * @return The new slot array.
+     */
+    Table* grow() {
+        Table* old = table.load(std::memory_order_relaxed);
+        auto* fresh = new Table(std::max<size_type>(old->capacity, std::bit_ceil((size() + 1) * 4)));
+        for (size_type i = 0; i < old->capacity; ++i) {
+            Node* node = old->slots[i].load(std::memory_order_relaxed);
+            if (node != nullptr && node != tombstone()) {
+                size_type pos = PowerOfTwoCapacity::index(node->hash, fresh->capacity);
+                while (fresh->slots[pos].load(std::memory_order_relaxed) != nullptr) {
+                    pos = PowerOfTwoCapacity::wrap(pos + 1, fresh->capacity);
+                }
+                fresh->slots[pos].store(node, std::memory_order_relaxed);
+            }
+        }
+        table.store(fresh, std::memory_order_release);
+        used = size();
+        retire(old);
+        return fresh;
+    }
+
+    /**
+     * @brief Hands an unlinked node or slot array over to the epoch domain.
+     *
+     * @tparam U Type of the object.
+     * @param ptr The object, no longer reachable from the published slot array.
+     */
+    template<class U>
+    void retire(U* ptr) {
+        retired.push_back({ptr, [](void* p) { delete static_cast<U*>(p); }, EpochDomain::instance().current()});
+        if (retired.size() >= reclaim_threshold) {
+            std::uint64_t oldest = EpochDomain::instance().advance();
+            std::erase_if(retired, [oldest](const Retired& item) {
+                if (item.epoch < oldest) {
+                    item.deleter(item.ptr);
+                    return true;
+                }
+                return false;
+            });
+        }
+    }
+
+    /**
+     * @brief Deletes the nodes of a slot array.
+     *
+     * @param current The slot array.
+     */
+    static void delete_nodes(Table* current) {
+        for (size_type i = 0; i < current->capacity; ++i) {
+            Node* node = current->slots[i].load(std::memory_order_relaxed);
+            if (node != nullptr && node != tombstone()) {
+                delete node;
+            }
+        }
+    }
+};
+
+#endif //READ_MOSTLY_UNORDERED_MAP_H
@@ -0,0 +1,255 @@
+#ifndef STATIC_MAP_H
+#define STATIC_MAP_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+/**
+ * @brief An immutable map from a fixed set of string keys, hashed perfectly at compile time.
+ *
+ * The constructor is consteval: it searches for a hash seed and one displacement per bucket
+ * (hash and displace) under which every key lands in a slot of its own, so a map declared
+ * constexpr costs nothing at run time. A lookup hashes the key once, reads the displacement of
+ * its bucket and compares the key stored in the one slot it selects; a slot without a key of its
+ * own refers to the first key, which hashes elsewhere and so never compares equal.
+ *
+ * Keys keep the order in which they were given, and index_of() returns that position, so a map
+ * also serves as a dense numbering of the keys, for instance to index an array of counters.
+ *
+ * @tparam T Type of the mapped values, a default-constructible literal type.
+ * @tparam N Number of keys, at least 1.
+ */
+template<class T, std::size_t N>
+class StaticMap {
+public:
+    typedef std::string_view key_type; /**< Type of the keys. */
+    typedef T mapped_type; /**< Type of the mapped values. */
+    typedef std::pair<std::string_view, T> value_type; /**< Type of the key-value pairs the map is built from. */
+    typedef std::size_t size_type; /**< Type representing sizes and indices. */
+
+    static_assert(N > 0, "StaticMap needs at least one key");
+
+    static constexpr size_type slot_count = std::bit_ceil(N); /**< Number of slots, also the number of buckets. */
+
+    /**
+     * @brief Builds the map at compile time.
+     *
+     * @param entries The keys and their values.
+     * @throw std::logic_error if two keys are equal or no perfect hash was found, either of which fails the compilation.
+     */
+    consteval explicit StaticMap(const value_type (&entries)[N]) {
+        for (size_type i = 0; i < N; ++i) {
+            keys_[i] = entries[i].first;
+            values_[i] = entries[i].second;
+            for (size_type j = 0; j < i; ++j) {
+                if (keys_[j] == keys_[i]) {
+                    throw std::logic_error("StaticMap keys must be distinct");
+                }
+            }
+        }
+        for (std::uint64_t seed = 0; seed < max_seeds; ++seed) {
+            if (build(seed)) {
+                return;
+            }
+        }
+        throw std::logic_error("StaticMap found no perfect hash");
+    }
+
+    /**
+     * @brief Finds the position of a key.
+     *
+     * @param key The key to look up.
+     * @return Position of the key in the list the map was built from, N if it is not a key.
+     */
+    constexpr size_type index_of(std::string_view key) const noexcept {
+        size_type index = slots_[slot_of(hash(key, seed_))];
+        return keys_[index] == key ? index : N;
+    }
+
+    /**
+     * @brief Finds the value of a key.
+     *
+     * @param key The key to look up.
+     * @return Pointer to the value, or nullptr if it is not a key.
+     */
+    constexpr const T* find(std::string_view key) const noexcept {
+        size_type index = index_of(key);
+        return index == N ? nullptr : &values_[index];
+    }
+
+    /**
+     * @brief Checks if a string is one of the keys.
+     *
+     * @param key The string to look up.
+     * @return True if it is a key, false otherwise.
+     */
+    constexpr bool contains(std::string_view key) const noexcept {
+        return index_of(key) != N;
+    }
+
+    /**
+     * @brief Returns the value of a key.
+     *
+     * @param key The key to look up.
+     * @return Reference to the value.
+     * @throw std::out_of_range if it is not a key.
+     */
+    constexpr const T& at(std::string_view key) const {
+        size_type index = index_of(key);
+        if (index == N) {
+            throw std::out_of_range("Key not found");
+        }
+        return values_[index];
+    }
+
+    /**
+     * @brief Returns the key at a position.
+     *
+     * @param index Position in the list the map was built from, below N.
+     * @return The key.
+     */
+    constexpr std::string_view key(size_type index) const noexcept {
+        return keys_[index];
+    }
+
+    /**
+     * @brief Returns the value at a position.
+     *
+     * @param index Position in the list the map was built from, below N.
+     * @return Reference to the value.
+     */
+    constexpr const T& value(size_type index) const noexcept {
+        return values_[index];
+    }
+
+    /**
+     * @brief Returns all keys in the order the map was built from.
+     *
+     * @return The keys.
+     */
+    constexpr std::span<const std::string_view, N> keys() const noexcept {
+        return keys_;
+    }
+
+    /**
+     * @brief Returns the number of keys.
+     *
+     * @return N.
+     */
+    static constexpr size_type size() noexcept {
+        return N;
+    }
+
+private:
+    static constexpr std::uint64_t max_seeds = 64; /**< Number of seeds tried before giving up. */
+    static constexpr std::uint32_t max_displacement = 1u << 12; /**< Number of displacements tried per bucket under one seed. */
+
+    std::array<std::string_view, N> keys_{}; /**< The keys, in the order given. */
+    std::array<T, N> values_{}; /**< The values, in the order of their keys. */
+    std::array<std::uint32_t, slot_count> displacement_{}; /**< Displacement of every bucket. */
+    std::array<size_type, slot_count> slots_{}; /**< Position of the key of every slot, 0 for slots without a key. */
+    std::uint64_t seed_ = 0; /**< Seed of the hash function. */
+
+    /**
+     * @brief Hashes a key: FNV-1a over its bytes followed by a multiplicative finalizer.
+     *
+     * @param key The key.
+     * @param seed The seed.
+     * @return The hash.
+     */
+    static constexpr std::uint64_t hash(std::string_view key, std::uint64_t seed) noexcept {
+        std::uint64_t h = 0xcbf29ce484222325ull ^ (seed * 0x9E3779B97F4A7C15ull);
+        for (char c : key) {
+            h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        }
+        h ^= h >> 32;
+        h *= 0xd6e8feb86659fd93ull;
+        return h ^ (h >> 32);
+    }
+
+    /**
+     * @brief Returns the bucket of a hash.
+     */
+    static constexpr size_type bucket_of(std::uint64_t hash) noexcept {
+        return static_cast<size_type>(hash >> 40) & (slot_count - 1);
+    }
+
+    /**
+     * @brief Returns the slot of a hash under a displacement.
+     */
+    static constexpr size_type slot_of(std::uint64_t hash, std::uint32_t displacement) noexcept {
+        return static_cast<size_type>(hash + displacement * ((hash >> 16) | 1)) & (slot_count - 1);
+    }
+
+    /**
+     * @brief Returns the slot of a hash under the displacement of its bucket.
+     */
+    constexpr size_type slot_of(std::uint64_t hash) const noexcept {
+        return slot_of(hash, displacement_[bucket_of(hash)]);
+    }
+
+    /**
+     * @brief Tries to place every key in a slot of its own under a seed.
+     *
+     * Buckets are placed from the largest down, each at the first displacement that sends all
+     * its keys to distinct free slots.
+     *
+     * @param seed The seed to try.
+     * @return True if every key was placed, false if a bucket could not be.
+     */
+    constexpr bool build(std::uint64_t seed) {
+        std::array<std::uint64_t, N> hashes{};
+        std::array<size_type, slot_count> bucket_sizes{};
+        for (size_type i = 0; i < N; ++i) {
+            hashes[i] = hash(keys_[i], seed);
+            ++bucket_sizes[bucket_of(hashes[i])];
+        }
+        std::array<bool, slot_count> taken{};
+        std::array<size_type, N> placed{};
+        for (size_type size = N; size > 0; --size) {
+            for (size_type bucket = 0; bucket < slot_count; ++bucket) {
+                if (bucket_sizes[bucket] != size) {
+                    continue;
+                }
+                bool found = false;
+                for (std::uint32_t displacement = 0; displacement < max_displacement && !found; ++displacement) {
+                    size_type count = 0;
+                    found = true;
+                    for (size_type i = 0; i < N && found; ++i) {
+                        if (bucket_of(hashes[i]) != bucket) {
+                            continue;
+                        }
+                        size_type slot = slot_of(hashes[i], displacement);
+                        found = !taken[slot];
+                        for (size_type j = 0; j < count && found; ++j) {
+                            found = slot_of(hashes[placed[j]], displacement) != slot;
+                        }
+                        placed[count++] = i;
+                    }
+                    if (found) {
+                        displacement_[bucket] = displacement;
+                        for (size_type j = 0; j < count; ++j) {
+                            size_type slot = slot_of(hashes[placed[j]], displacement);
+                            taken[slot] = true;
+                            slots_[slot] = placed[j];
+                        }
+                    }
+                }
+                if (!found) {
+                    displacement_ = {};
+                    slots_ = {};
+                    return false;
+                }
+            }
+        }
+        seed_ = seed;
+        return true;
+    }
+};
+
+#endif //STATIC_MAP_H
@@ -5,820 +5,4417 @@
 #include <functional>
 #include <concepts>
 #include <limits>
+#include <cstdint>
+#include <cstring>
+#include <bit>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+#include "fast_hash.h"
+#include "map_file.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 /**
  * @brief A structure representing an entry in the hash table.
  *
+ * The value is raw storage: it is constructed in place when the slot is filled and destroyed when it
+ * is emptied, so empty slots cost no constructor or destructor calls. The occupancy of the entry is
+ * kept separately in the control bytes of the table.
+ *
  * @tparam T The type of value stored in the hash table.
+ * @tparam StoreHash Boolean indicating if the entry caches the full hash of its key.
  */
-template<std::default_initializable T>
+template<class T, bool StoreHash = false>
 struct HashEntry{
-    T value = T{}; /**< The value stored in the entry. */
-    int busy = 0; /**< Indicates if the entry is occupied. */
-    ~HashEntry() = default; /**< Destructor */
+    union {
+        T value; /**< The value stored in the entry, alive only while the slot is occupied. */
+    };
+    HashEntry() noexcept {} /**< Constructor, leaves the value unconstructed */
+    ~HashEntry() {} /**< Destructor, leaves the value to the owning table */
 };
 
 /**
- * @brief An iterator class for the Unordered_map class.
+ * @brief A hash table entry caching the full hash of its key next to the value.
  *
- * @tparam T The type of value stored in the iterator.
- * @tparam IsConst Boolean indicating if the iterator is const or not.
+ * @tparam T The type of value stored in the hash table.
  */
-template<std::default_initializable T, bool IsConst>
-class MapIterator{
-private:
-    using EntryPointer = std::conditional_t<IsConst, const HashEntry<T>*, HashEntry<T>*>; /**< Pointer to a hash table entry. */
-    using EntryReference = std::conditional_t<IsConst, const HashEntry<T>&, HashEntry<T>&>; /**< Reference to a hash table entry. */
-
-    friend MapIterator<T, !IsConst>;
-
-    EntryPointer ptr; /**< Pointer to the current hash table entry. */
-    std::size_t index; /**< Index of the current hash table entry. */
-    std::size_t capacity; /**< Capacity of the hash table. */
-
-
-public:
-    using iterator_category = std::forward_iterator_tag; /**< Iterator category. */
-    using value_type = T; /**< Value type of the iterator. */
-    using difference_type = std::ptrdiff_t; /**< Difference type for the iterator. */
-    using pointer = std::conditional_t<IsConst, const value_type*, value_type*>; /**< Pointer type of the iterator. */
-    using reference = std::conditional_t<IsConst, const value_type&, value_type&>; /**< Reference type of the iterator. */
+template<class T>
+struct HashEntry<T, true>{
+    union {
+        T value; /**< The value stored in the entry, alive only while the slot is occupied. */
+    };
+    std::size_t hash; /**< The hash of the key of the value. */
+    HashEntry() noexcept {} /**< Constructor, leaves the value unconstructed */
+    ~HashEntry() {} /**< Destructor, leaves the value to the owning table */
+};
 
-    /**
-     * @brief Default constructor.
-     */
-    MapIterator() : ptr(nullptr), index(0), capacity(0) {}
+/**
+ * @brief Control byte values describing the state of a hash table slot.
+ *
+ * A full slot stores a 7-bit fragment of its hash (H2) as a non-negative control byte,
+ * so most non-matching slots are rejected without loading the entry itself. The fragment is
+ * taken from the hash after its own finalizer, so it is spread even when the hash function and
+ * the capacity policy both leave small keys as they are.
+ */
+struct Ctrl {
+    static constexpr std::int8_t empty = -128; /**< The slot has not been used since the last rehash. */
+    static constexpr std::int8_t deleted = -2; /**< The slot held an element that has been erased. */
 
     /**
-     * @brief Constructor with parameters.
+     * @brief Checks if a control byte marks an occupied slot.
      *
-     * @param ptr Pointer to the hash table entry.
-     * @param index Index of the hash table entry.
-     * @param capacity Capacity of the hash table.
+     * @param c The control byte.
+     * @return True if the slot is occupied, false otherwise.
      */
-    MapIterator(EntryPointer ptr, std::size_t index, std::size_t capacity) : ptr(ptr), index(index), capacity(capacity) {}
+    static constexpr bool is_full(std::int8_t c) noexcept {
+        return c >= 0;
+    }
 
     /**
-     * @brief Move constructor.
-     *
-     * Constructs the iterator from rvalue reference to another iterator.
+     * @brief Extracts the hash fragment stored in the control byte of a full slot.
      *
-     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
-     * @param other Rvalue reference to another iterator.
+     * @param hash The full hash of the key.
+     * @return The top 7 bits of the hash multiplied by an odd constant, which depend on every bit of the hash.
      */
-    template<bool OtherConst>
-    requires(IsConst >= OtherConst)
-    explicit MapIterator(MapIterator<T, OtherConst>&& other) noexcept : ptr(other.ptr), index(other.index), capacity(other.capacity) {
-        other.ptr = nullptr;
-        other.index = 0;
-        other.capacity = 0;
+    static constexpr std::int8_t h2(std::size_t hash) noexcept {
+        std::uint64_t folded = static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+        return static_cast<std::int8_t>(folded >> 57);
     }
+};
+
+/**
+ * @brief A bit mask of the slots of a control group that matched a query.
+ *
+ * Iterating over the mask yields the offsets of the matching slots in increasing order.
+ *
+ * @tparam Width Number of slots in the group.
+ */
+template<std::size_t Width>
+class GroupMask{
+private:
+    std::uint32_t mask; /**< One bit per slot of the group. */
 
+public:
     /**
-     * @brief Copy constructor.
-     *
-     * Constructs the iterator from const reference to another iterator.
+     * @brief Constructor with parameters.
      *
-     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
-     * @param other Const reference to another iterator.
+     * @param mask One bit per slot of the group.
      */
-    template<bool OtherConst>
-    requires(IsConst >= OtherConst)
-    explicit MapIterator(const MapIterator<T, OtherConst>& other) : ptr(other.ptr), index(other.index), capacity(other.capacity) {}
+    explicit GroupMask(std::uint32_t mask) : mask(mask) {}
 
     /**
-     * @brief Destructor.
+     * @brief Checks if any slot matched.
      *
-     * Destroys the iterator object.
+     * @return True if the mask is not empty.
      */
-    ~MapIterator() = default;
+    explicit operator bool() const noexcept {
+        return mask != 0;
+    }
 
     /**
-     * @brief Move assignment operator.
-     *
-     * Assigns the iterator from rvalue reference to another iterator.
+     * @brief Returns the offset of the first matching slot.
      *
-     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
-     * @param other Rvalue reference to another iterator.
-     * @return Reference to the current iterator.
+     * @return Offset of the lowest set bit.
      */
-    template<bool OtherConst>
-    requires(IsConst >= OtherConst)
-    MapIterator& operator=(MapIterator<T, OtherConst>&& other) noexcept {
-        if (this != &other) {
-            ptr = other.ptr;
-            index = other.index;
-            capacity = other.capacity;
-            other.ptr = nullptr;
-            other.index = 0;
-            other.capacity = 0;
-        }
-        return *this;
+    unsigned lowest() const noexcept {
+        return std::countr_zero(mask);
     }
 
     /**
-     * @brief Copy assignment operator.
+     * @brief Counts the non-matching slots before the first match.
      *
-     * Assigns the iterator from const reference to another iterator.
-     *
-     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
-     * @param other Const reference to another iterator.
-     * @return Reference to the current iterator.
+     * @return Number of trailing zero bits, or Width if the mask is empty.
      */
-    template<bool OtherConst>
-    requires(IsConst >= OtherConst)
-    MapIterator& operator=(const MapIterator<T, OtherConst>& other) {
-        if (this != &other) {
-            ptr = other.ptr;
-            index = other.index;
-            capacity = other.capacity;
-        }
-        return *this;
+    unsigned trailing_zeros() const noexcept {
+        return mask == 0 ? Width : std::countr_zero(mask);
     }
 
     /**
-     * @brief Dereference operator.
+     * @brief Counts the non-matching slots after the last match.
      *
-     * @return Reference to the value stored in the current hash table entry.
+     * @return Number of leading zero bits within the group, or Width if the mask is empty.
      */
-    reference operator*() const {
-        return ptr[index].value;
+    unsigned leading_zeros() const noexcept {
+        return std::countl_zero(mask) - (32 - Width);
     }
 
     /**
-     * @brief Arrow operator.
+     * @brief Returns the offset of the current matching slot.
      *
-     * @return Pointer to the value stored in the current hash table entry.
+     * @return Offset of the lowest set bit.
      */
-    pointer operator->() const {
-        return &ptr[index].value;
+    unsigned operator*() const noexcept {
+        return lowest();
     }
 
     /**
-     * @brief Prefix increment operator.
-     *
-     * Increments the iterator to point to the next valid entry in the hash table.
+     * @brief Drops the current matching slot.
      *
-     * @return Reference to the incremented iterator.
+     * @return Reference to the mask.
      */
-    MapIterator& operator++() {
-        do {
-            ++index;
-        } while (index < capacity && ptr[index].busy != 1);
+    GroupMask& operator++() noexcept {
+        mask &= mask - 1;
         return *this;
     }
 
     /**
-     * @brief Postfix increment operator.
-     *
-     * Increments the iterator to point to the next valid entry in the hash table.
-     *
-     * @return Copy of the iterator before incrementing.
+     * @brief Returns the mask itself as the beginning of the range of matching offsets.
      */
-    MapIterator operator++(int) {
-        MapIterator temp = *this;
-        ++(*this);
-        return temp;
+    GroupMask begin() const noexcept {
+        return *this;
     }
 
     /**
-     * @brief Equality operator.
-     *
-     * Checks if two iterators are equal.
-     *
-     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
-     * @param other Iterator to compare with.
-     * @return True if the iterators are equal, false otherwise.
+     * @brief Returns an empty mask as the end of the range of matching offsets.
      */
-    template<bool OtherConst>
-    bool operator==(const MapIterator<T, OtherConst>& other) const noexcept
-    {
-        return index == other.index;
+    GroupMask end() const noexcept {
+        return GroupMask(0);
     }
 
     /**
      * @brief Inequality operator.
      *
-     * Checks if two iterators are not equal.
-     *
-     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
-     * @param other Iterator to compare with.
-     * @return True if the iterators are not equal, false otherwise.
+     * @param other Mask to compare with.
+     * @return True if the masks differ.
      */
-    template<bool OtherConst>
-    bool operator!=(const MapIterator<T, OtherConst>& other) const noexcept
-    {
-        return index != other.index;
+    bool operator!=(const GroupMask& other) const noexcept {
+        return mask != other.mask;
     }
 };
 
 /**
- * @brief An unordered map implementation.
+ * @brief A group of consecutive control bytes probed with a single vector comparison.
  *
- * @tparam Key Type of the keys stored in the map.
- * @tparam T Type of the values stored in the map.
- * @tparam Hash Hash function for computing hash values of keys.
- * @tparam KeyEqual Function object for comparing keys for equality.
+ * Uses AVX2 (32 slots) or SSE2 (16 slots) when available, and a portable loop over 8 slots otherwise.
  */
-template<std::default_initializable Key, std::default_initializable T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>>
-class Unordered_map{
-public:
-    typedef Key key_type; /**< Type of the keys stored in the map. */
-    typedef T mapped_type; /**< Type of the values stored in the map. */
-    typedef std::pair<Key, T> value_type; /**< Type representing key-value pairs stored in the map. */
-    typedef Hash hasher; /**< Type of the hash function. */
-    typedef KeyEqual key_equal; /**< Type of the function object for comparing keys for equality. */
-    typedef std::pair<Key, T> reference; /**< Reference type for the key-value pairs stored in the map. */
-    typedef const std::pair<Key, T> const_reference; /**< Const reference type for the key-value pairs stored in the map. */
-    typedef MapIterator<value_type, false> iterator; /**< Iterator type for non-const access to elements. */
-    typedef MapIterator<value_type, true> const_iterator; /**< Iterator type for const access to elements. */
-    typedef value_type* pointer; /**< Pointer type for the key-value pairs stored in the map. */
-    typedef const value_type* const_pointer; /**< Const pointer type for the key-value pairs stored in the map. */
-    typedef ptrdiff_t difference_type; /**< Type representing the difference between two iterators. */
-    typedef std::size_t size_type; /**< Type representing sizes and indices. */
-    typedef HashEntry<value_type> entry_type; /**< Type of the hash table entry. */
+struct ControlGroup{
+#if defined(__AVX2__)
+    static constexpr std::size_t width = 32; /**< Number of slots in a group. */
+    using mask_type = GroupMask<width>; /**< Type of the match masks. */
+
+    __m256i ctrl; /**< The control bytes of the group. */
 
     /**
-     * @brief Default constructor.
+     * @brief Loads a group of control bytes.
      *
-     * Constructs an empty unordered map.
+     * @param pos Pointer to the first control byte of the group.
      */
-    Unordered_map() = default;
+    explicit ControlGroup(const std::int8_t* pos) : ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos))) {}
 
     /**
-     * @brief Copy constructor.
-     *
-     * Constructs the unordered map with a copy of the contents of another unordered map.
-     *
-     * @param other Another unordered map to be copied.
+     * @brief Finds the slots whose hash fragment equals h2.
      */
-    Unordered_map(const Unordered_map& other) : size_(other.size_), capacity_(other.capacity_), step(other.step), max_load(other.max_load), array(new entry_type[other.capacity_]) {
-        std::copy(other.array, other.array + other.capacity_, array);
+    mask_type match(std::int8_t h2) const noexcept {
+        return mask_type(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_set1_epi8(h2), ctrl))));
     }
 
     /**
-     * @brief Move constructor.
-     *
-     * Constructs the unordered map with the contents of another unordered map using move semantics.
-     *
-     * @param other Another unordered map to be moved.
+     * @brief Finds the empty slots.
      */
-    Unordered_map(Unordered_map&& other) noexcept : size_(other.size_), capacity_(other.capacity_), step(other.step), max_load(other.max_load), array(other.array) {
-        other.size_ = 0;
-        other.capacity_ = 0;
-        other.step = 1;
-        other.max_load = 0.8f;
-        other.array = nullptr;
+    mask_type match_empty() const noexcept {
+        return match(Ctrl::empty);
     }
 
     /**
-     * @brief Destructor.
-     *
-     * Destroys the unordered map object.
+     * @brief Finds the slots that are free for insertion (empty or deleted).
      */
-    ~Unordered_map() {
-        delete[] array;
+    mask_type match_empty_or_deleted() const noexcept {
+        return mask_type(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-1), ctrl))));
     }
 
     /**
-     * @brief Copy assignment operator.
+     * @brief Finds the occupied slots.
+     */
+    mask_type match_full() const noexcept {
+        return mask_type(~static_cast<std::uint32_t>(_mm256_movemask_epi8(ctrl)));
+    }
+#elif defined(__SSE2__)
+    static constexpr std::size_t width = 16; /**< Number of slots in a group. */
+    using mask_type = GroupMask<width>; /**< Type of the match masks. */
+
+    __m128i ctrl; /**< The control bytes of the group. */
+
+    /**
+     * @brief Loads a group of control bytes.
      *
-     * Replaces the contents with a copy of the contents of another unordered map.
+     * @param pos Pointer to the first control byte of the group.
+     */
+    explicit ControlGroup(const std::int8_t* pos) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+    /**
+     * @brief Finds the slots whose hash fragment equals h2.
+     */
+    mask_type match(std::int8_t h2) const noexcept {
+        return mask_type(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl))));
+    }
+
+    /**
+     * @brief Finds the empty slots.
+     */
+    mask_type match_empty() const noexcept {
+        return match(Ctrl::empty);
+    }
+
+    /**
+     * @brief Finds the slots that are free for insertion (empty or deleted).
+     */
+    mask_type match_empty_or_deleted() const noexcept {
+        return mask_type(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl))));
+    }
+
+    /**
+     * @brief Finds the occupied slots.
+     */
+    mask_type match_full() const noexcept {
+        return mask_type(static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl)) ^ 0xFFFFu);
+    }
+#else
+    static constexpr std::size_t width = 8; /**< Number of slots in a group. */
+    using mask_type = GroupMask<width>; /**< Type of the match masks. */
+
+    std::int8_t ctrl[width]; /**< The control bytes of the group. */
+
+    /**
+     * @brief Loads a group of control bytes.
      *
-     * @param other Another unordered map to use as a source.
-     * @return Reference to the current unordered map.
+     * @param pos Pointer to the first control byte of the group.
      */
-    Unordered_map& operator=(const Unordered_map& other) {
-        if (this != &other) {
-            delete[] array;
-            size_ = other.size_;
-            capacity_ = other.capacity_;
-            step = other.step;
-            max_load = other.max_load;
-            array = new entry_type[other.capacity_];
-            std::copy(other.array, other.array + other.capacity_, array);
+    explicit ControlGroup(const std::int8_t* pos) {
+        std::memcpy(ctrl, pos, width);
+    }
+
+    /**
+     * @brief Finds the slots whose hash fragment equals h2.
+     */
+    mask_type match(std::int8_t h2) const noexcept {
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < width; ++i) {
+            mask |= static_cast<std::uint32_t>(ctrl[i] == h2) << i;
         }
-        return *this;
+        return mask_type(mask);
     }
 
     /**
-     * @brief Move assignment operator.
-     *
-     * Replaces the contents with those of another unordered map using move semantics.
-     *
-     * @param other Another unordered map to be moved.
-     * @return Reference to the current unordered map.
+     * @brief Finds the empty slots.
      */
-    Unordered_map& operator=(Unordered_map&& other) noexcept {
-        if (this != &other) {
-            delete[] array;
-            size_ = other.size_;
-            capacity_ = other.capacity_;
-            step = other.step;
-            max_load = other.max_load;
-            array = other.array;
-            other.size_ = 0;
-            other.capacity_ = 0;
-            other.step = 1;
-            other.max_load = 0.8f;
-            other.array = nullptr;
+    mask_type match_empty() const noexcept {
+        return match(Ctrl::empty);
+    }
+
+    /**
+     * @brief Finds the slots that are free for insertion (empty or deleted).
+     */
+    mask_type match_empty_or_deleted() const noexcept {
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < width; ++i) {
+            mask |= static_cast<std::uint32_t>(ctrl[i] < -1) << i;
         }
-        return *this;
+        return mask_type(mask);
     }
 
     /**
-     * @brief Returns an iterator to the beginning of the unordered map.
-     *
-     * @return Iterator to the beginning.
+     * @brief Finds the occupied slots.
      */
-    iterator begin() {
-        size_t index = 0;
-        while (index < capacity_ && array[index].busy != 1) {
-            ++index;
+    mask_type match_full() const noexcept {
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < width; ++i) {
+            mask |= static_cast<std::uint32_t>(ctrl[i] >= 0) << i;
         }
-        return iterator(array, index, capacity_);
+        return mask_type(mask);
     }
+#endif
+};
 
 /**
- * @brief Returns a const iterator to the beginning of the unordered map.
+ * @brief Capacity policy keeping capacities as requested and reducing hashes modulo the capacity.
  *
- * @return Const iterator to the beginning.
+ * Only the home slot of a key costs a division; probe steps wrap with a comparison.
  */
-    const_iterator begin() const {
-        size_t index = 0;
-        while (index < capacity_ && array[index].busy != 1) {
-            ++index;
+struct ModuloCapacity {
+    /**
+     * @brief Adjusts a requested capacity to one supported by the policy.
+     *
+     * @param capacity The requested capacity.
+     * @return The capacity itself.
+     */
+    static constexpr std::size_t round(std::size_t capacity) noexcept {
+        return capacity;
+    }
+
+    /**
+     * @brief Post-processes the hash of a key before it is reduced to a slot.
+     *
+     * @param hash The hash of the key.
+     * @return The hash itself.
+     */
+    static constexpr std::size_t mix(std::size_t hash) noexcept {
+        return hash;
+    }
+
+    /**
+     * @brief Maps a hash to its home slot.
+     *
+     * @param hash The mixed hash of the key.
+     * @param capacity The capacity of the hash table.
+     * @return Index of the home slot.
+     */
+    static constexpr std::size_t index(std::size_t hash, std::size_t capacity) noexcept {
+        return hash % capacity;
+    }
+
+    /**
+     * @brief Wraps a slot index that ran past the end of the table.
+     *
+     * @param index A slot index, usually below twice the capacity.
+     * @param capacity The capacity of the hash table.
+     * @return The index reduced modulo the capacity.
+     */
+    static constexpr std::size_t wrap(std::size_t index, std::size_t capacity) noexcept {
+        if (index < capacity) {
+            return index;
         }
-        return const_iterator(array, index, capacity_);
+        index -= capacity;
+        return index < capacity ? index : index % capacity;
     }
+};
 
+/**
+ * @brief Capacity policy rounding capacities up to powers of two and wrapping with a mask.
+ *
+ * Hashes go through the 64-bit splitmix finalizer first, so weak hashes such as the identity
+ * std::hash of integers still spread over the low bits used by the mask.
+ */
+struct PowerOfTwoCapacity {
     /**
-     * @brief Returns an iterator to the end of the unordered map.
+     * @brief Adjusts a requested capacity to one supported by the policy.
      *
-     * @return Iterator to the end.
+     * @param capacity The requested capacity.
+     * @return The smallest power of two not less than the capacity.
      */
-    iterator end() {
-        return iterator(array, capacity_, capacity_);
+    static constexpr std::size_t round(std::size_t capacity) noexcept {
+        return std::bit_ceil(capacity);
+    }
+
+    /**
+     * @brief Post-processes the hash of a key before it is reduced to a slot.
+     *
+     * @param hash The hash of the key.
+     * @return The finalized hash.
+     */
+    static constexpr std::size_t mix(std::size_t hash) noexcept {
+        std::uint64_t x = hash;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return static_cast<std::size_t>(x ^ (x >> 31));
+    }
+
+    /**
+     * @brief Maps a hash to its home slot.
+     *
+     * @param hash The mixed hash of the key.
+     * @param capacity The capacity of the hash table.
+     * @return Index of the home slot.
+     */
+    static constexpr std::size_t index(std::size_t hash, std::size_t capacity) noexcept {
+        return hash & (capacity - 1);
+    }
+
+    /**
+     * @brief Wraps a slot index that ran past the end of the table.
+     *
+     * @param index A slot index.
+     * @param capacity The capacity of the hash table.
+     * @return The index reduced modulo the capacity.
+     */
+    static constexpr std::size_t wrap(std::size_t index, std::size_t capacity) noexcept {
+        return index & (capacity - 1);
+    }
+};
+
+/**
+ * @brief Probing policy visiting the control groups following the home group one after the other.
+ *
+ * Works with every capacity policy.
+ */
+struct LinearProbing {
+    static constexpr bool needs_power_of_two = false; /**< Whether the sequence covers the table only for power-of-two capacities. */
+
+    /**
+     * @brief Returns the number of probes after which every group has been visited.
+     *
+     * @param groups Number of control groups in the table.
+     * @return Maximum number of probes.
+     */
+    static constexpr std::size_t probe_limit(std::size_t groups) noexcept {
+        return groups;
+    }
+
+    /**
+     * @brief Returns the distance in groups from the current probe to the next one.
+     *
+     * @param probe Number of the current probe, starting at 0 for the home group.
+     * @param hash The mixed hash of the key.
+     * @param groups Number of control groups in the table.
+     * @return Number of groups to advance.
+     */
+    static constexpr std::size_t step(std::size_t, std::size_t, std::size_t) noexcept {
+        return 1;
+    }
+};
+
+/**
+ * @brief Probing policy visiting the groups at quadratic offsets 0, 1, 4, 9, ... from the home group.
+ *
+ * The quadratic offsets reach only part of a power-of-two table, so once as many probes as there
+ * are groups have been made the sequence continues linearly and covers the rest.
+ */
+struct QuadraticProbing {
+    static constexpr bool needs_power_of_two = true; /**< Whether the sequence covers the table only for power-of-two capacities. */
+
+    /**
+     * @brief Returns the number of probes after which every group has been visited.
+     *
+     * @param groups Number of control groups in the table.
+     * @return Maximum number of probes.
+     */
+    static constexpr std::size_t probe_limit(std::size_t groups) noexcept {
+        return 2 * groups;
+    }
+
+    /**
+     * @brief Returns the distance in groups from the current probe to the next one.
+     *
+     * @param probe Number of the current probe, starting at 0 for the home group.
+     * @param hash The mixed hash of the key.
+     * @param groups Number of control groups in the table.
+     * @return Number of groups to advance.
+     */
+    static constexpr std::size_t step(std::size_t probe, std::size_t, std::size_t groups) noexcept {
+        return probe < groups ? 2 * probe + 1 : 1;
+    }
+};
+
+/**
+ * @brief Probing policy visiting the groups at triangular offsets 0, 1, 3, 6, ... from the home group.
+ *
+ * For a power-of-two number of groups the first that many triangular numbers are all distinct
+ * modulo it, so the sequence visits every group exactly once.
+ */
+struct TriangularProbing {
+    static constexpr bool needs_power_of_two = true; /**< Whether the sequence covers the table only for power-of-two capacities. */
+
+    /**
+     * @brief Returns the number of probes after which every group has been visited.
+     *
+     * @param groups Number of control groups in the table.
+     * @return Maximum number of probes.
+     */
+    static constexpr std::size_t probe_limit(std::size_t groups) noexcept {
+        return groups;
+    }
+
+    /**
+     * @brief Returns the distance in groups from the current probe to the next one.
+     *
+     * @param probe Number of the current probe, starting at 0 for the home group.
+     * @param hash The mixed hash of the key.
+     * @param groups Number of control groups in the table.
+     * @return Number of groups to advance.
+     */
+    static constexpr std::size_t step(std::size_t probe, std::size_t, std::size_t) noexcept {
+        return probe + 1;
+    }
+};
+
+/**
+ * @brief Probing policy advancing by a per-key number of groups taken from the upper hash bits.
+ *
+ * The step is odd, hence coprime with a power-of-two number of groups, so the sequence visits every
+ * group exactly once, and keys sharing a home group follow different sequences.
+ */
+struct DoubleHashProbing {
+    static constexpr bool needs_power_of_two = true; /**< Whether the sequence covers the table only for power-of-two capacities. */
+
+    /**
+     * @brief Returns the number of probes after which every group has been visited.
+     *
+     * @param groups Number of control groups in the table.
+     * @return Maximum number of probes.
+     */
+    static constexpr std::size_t probe_limit(std::size_t groups) noexcept {
+        return groups;
+    }
+
+    /**
+     * @brief Returns the distance in groups from the current probe to the next one.
+     *
+     * @param probe Number of the current probe, starting at 0 for the home group.
+     * @param hash The mixed hash of the key.
+     * @param groups Number of control groups in the table.
+     * @return Number of groups to advance.
+     */
+    static constexpr std::size_t step(std::size_t, std::size_t hash, std::size_t) noexcept {
+        return static_cast<std::size_t>(static_cast<std::uint64_t>(hash) >> 32) | 1;
+    }
+};
+
+/**
+ * @brief Default compile-time options of the Unordered_map class.
+ *
+ * Custom policies derive from it and override only the options they change.
+ */
+struct DefaultMapPolicy {
+    using capacity_policy = ModuloCapacity; /**< Mapping of hashes to slots, see ModuloCapacity and PowerOfTwoCapacity. */
+    static constexpr bool robin_hood = false; /**< Use Robin Hood insertion with backward-shift deletion instead of tombstones. */
+    static constexpr bool store_hash = false; /**< Cache the full hash in every entry, so resizing never rehashes keys. */
+    static constexpr std::size_t resize_step = 0; /**< Old slots migrated per insertion or erasure while growing, 0 to grow in one step. */
+    using probing = LinearProbing; /**< Order in which control groups are probed, see LinearProbing; ignored by Robin Hood and cuckoo. */
+    static constexpr bool cuckoo = false; /**< Use bucketized cuckoo hashing, so lookups probe at most two buckets. */
+    static constexpr bool collect_stats = false; /**< Count probe lengths and rehashes for Unordered_map::stats(). */
+    static constexpr bool snapshots = false; /**< Support copy-on-write snapshots, see Unordered_map::snapshot(). */
+};
+
+/**
+ * @brief Policy selecting Robin Hood insertion with backward-shift deletion.
+ *
+ * Elements are probed one slot at a time and kept ordered by their distance from the home slot,
+ * so erasing never leaves tombstones and probe lengths stay short under insert/erase churn.
+ */
+struct RobinHoodMapPolicy : DefaultMapPolicy {
+    static constexpr bool robin_hood = true;
+};
+
+/**
+ * @brief Policy selecting power-of-two capacities with mixed hashes and mask-based wrapping.
+ */
+struct PowerOfTwoMapPolicy : DefaultMapPolicy {
+    using capacity_policy = PowerOfTwoCapacity;
+};
+
+/**
+ * @brief Policy caching the full hash of every key next to its entry.
+ *
+ * Resizing moves entries without calling the hash function, and probing compares the cached hashes
+ * before comparing keys. Worth its extra word per slot for keys that are expensive to hash or compare.
+ */
+struct StoredHashMapPolicy : DefaultMapPolicy {
+    static constexpr bool store_hash = true;
+};
+
+/**
+ * @brief Policy spreading the migration of a growing table over the following operations.
+ *
+ * The old table is kept next to the new one and drained a few slots per insertion or erasure,
+ * so no single insertion pays for moving every element. Lookups probe both tables meanwhile.
+ */
+struct IncrementalResizeMapPolicy : DefaultMapPolicy {
+    static constexpr std::size_t resize_step = 64;
+};
+
+/**
+ * @brief Policy selecting bucketized cuckoo hashing.
+ *
+ * Every key may live in one of the four slots of two buckets, chosen by the low bits and by the
+ * high half of its hash. A lookup examines these eight control bytes and nothing else, so its
+ * cost is bounded at any load; an insertion into two full buckets moves elements to their other
+ * bucket along the shortest path found by a breadth-first search. Hashes are cached, so moving an
+ * element never calls the hash function.
+ */
+struct CuckooMapPolicy : PowerOfTwoMapPolicy {
+    static constexpr bool cuckoo = true;
+    static constexpr bool store_hash = true;
+};
+
+/**
+ * @brief Policy collecting probe length histograms and rehash timings, see Unordered_map::stats().
+ *
+ * Every lookup, insertion and erasure then updates a counter, and every rehash reads the clock twice.
+ */
+struct StatsMapPolicy : DefaultMapPolicy {
+    static constexpr bool collect_stats = true;
+};
+
+/**
+ * @brief Policy supporting copy-on-write snapshots, see Unordered_map::snapshot().
+ *
+ * Every modification of a slot then checks for live snapshots first.
+ */
+struct SnapshotMapPolicy : DefaultMapPolicy {
+    static constexpr bool snapshots = true;
+};
+
+/**
+ * @brief Snapshot of the probing, occupancy and resizing statistics of an Unordered_map.
+ *
+ * The occupancy figures are computed from the table when the snapshot is taken. The operation
+ * counters are collected only by maps whose policy sets collect_stats and are zero otherwise.
+ * Probe lengths are counted in the units of Unordered_map::probe_length().
+ */
+struct MapStats {
+    static constexpr std::size_t histogram_size = 16; /**< Number of buckets of a probe length histogram. */
+
+    /**
+     * @brief Number of operations by probe length: bucket i counts the operations that made i
+     * probes, the last bucket also those that made more.
+     */
+    typedef std::array<std::size_t, histogram_size> Histogram;
+
+    Histogram find_probes{}; /**< Probe lengths of lookups. */
+    Histogram insert_probes{}; /**< Probe lengths of insertions, including those that found the key present. */
+    Histogram erase_probes{}; /**< Probe lengths of erasures and extractions by key, including those that found nothing. */
+    std::size_t size = 0; /**< Number of elements. */
+    std::size_t capacity = 0; /**< Number of slots, including those of the old table while growing. */
+    std::size_t tombstones = 0; /**< Number of slots marked deleted, which lengthen probe sequences until they are cleaned up. */
+    double load = 0; /**< Share of slots holding elements. */
+    double effective_load = 0; /**< Share of slots holding elements or tombstones, which is what probing sees. */
+    std::size_t rehashes = 0; /**< Number of rehashes, growths and reservations alike. */
+    std::chrono::nanoseconds rehash_time{0}; /**< Total time spent rehashing. */
+    std::chrono::nanoseconds longest_rehash{0}; /**< Time spent in the longest rehash. */
+    std::size_t bytes_allocated = 0; /**< Bytes of control bytes, entries and distances, not counting memory owned by the elements. */
+
+    /**
+     * @brief Counts the operations of a histogram.
+     *
+     * @param histogram The histogram.
+     * @return Number of operations.
+     */
+    static std::size_t count(const Histogram& histogram) {
+        std::size_t total = 0;
+        for (std::size_t n : histogram) {
+            total += n;
+        }
+        return total;
+    }
+
+    /**
+     * @brief Computes the mean probe length of a histogram, counting the last bucket at its lower bound.
+     *
+     * @param histogram The histogram.
+     * @return Mean number of probes, 0 if there were no operations.
+     */
+    static double mean(const Histogram& histogram) {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < histogram_size; ++i) {
+            total += i * histogram[i];
+        }
+        std::size_t operations = count(histogram);
+        return operations == 0 ? 0.0 : static_cast<double>(total) / static_cast<double>(operations);
+    }
+
+    /**
+     * @brief Finds the probe length that a share of the operations of a histogram did not exceed.
+     *
+     * @param histogram The histogram.
+     * @param share The share of operations, between 0 and 1.
+     * @return Smallest probe length covering the share, histogram_size - 1 if only the last bucket does.
+     */
+    static std::size_t percentile(const Histogram& histogram, double share) {
+        std::size_t operations = count(histogram);
+        std::size_t seen = 0;
+        for (std::size_t i = 0; i < histogram_size; ++i) {
+            seen += histogram[i];
+            if (static_cast<double>(seen) >= share * static_cast<double>(operations)) {
+                return i;
+            }
+        }
+        return histogram_size - 1;
+    }
+};
+
+/**
+ * @brief Operation counters of an Unordered_map whose policy collects statistics.
+ *
+ * Lookups are const and may run concurrently under a shared lock, so the histograms are relaxed
+ * atomics. They are incremented with a separate load and store rather than a locked
+ * read-modify-write, which keeps the cost of a lookup unchanged at the price of occasionally
+ * losing a count under concurrent lookups.
+ *
+ * @tparam Enabled False selects an empty specialization whose members do nothing.
+ */
+template<bool Enabled>
+class MapStatsCounters {
+public:
+    /**
+     * @brief Records the probe length of a lookup.
+     *
+     * @param probes Number of probes made.
+     */
+    void record_find(std::size_t probes) const {
+        increment(find_probes, probes);
+    }
+
+    /**
+     * @brief Records the probe length of an insertion.
+     *
+     * @param probes Number of probes made.
+     */
+    void record_insert(std::size_t probes) const {
+        increment(insert_probes, probes);
+    }
+
+    /**
+     * @brief Records the probe length of an erasure.
+     *
+     * @param probes Number of probes made.
+     */
+    void record_erase(std::size_t probes) const {
+        increment(erase_probes, probes);
+    }
+
+    /**
+     * @brief Times a rehash until the returned timer is destroyed.
+     *
+     * @return The timer.
+     */
+    auto time_rehash() {
+        struct Timer {
+            MapStatsCounters* counters; /**< Counters to record the rehash in. */
+            std::chrono::steady_clock::time_point start; /**< When the rehash started. */
+
+            ~Timer() {
+                auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                ++counters->rehashes;
+                counters->rehash_time += elapsed;
+                counters->longest_rehash = std::max(counters->longest_rehash, elapsed);
+            }
+        };
+        return Timer{this, std::chrono::steady_clock::now()};
+    }
+
+    /**
+     * @brief Copies the counters into a snapshot.
+     *
+     * @param stats The snapshot.
+     */
+    void collect(MapStats& stats) const {
+        for (std::size_t i = 0; i < MapStats::histogram_size; ++i) {
+            stats.find_probes[i] = find_probes[i].load(std::memory_order_relaxed);
+            stats.insert_probes[i] = insert_probes[i].load(std::memory_order_relaxed);
+            stats.erase_probes[i] = erase_probes[i].load(std::memory_order_relaxed);
+        }
+        stats.rehashes = rehashes;
+        stats.rehash_time = rehash_time;
+        stats.longest_rehash = longest_rehash;
+    }
+
+private:
+    typedef std::array<std::atomic<std::size_t>, MapStats::histogram_size> Histogram; /**< Histogram updated by const operations. */
+
+    mutable Histogram find_probes{}; /**< Probe lengths of lookups. */
+    mutable Histogram insert_probes{}; /**< Probe lengths of insertions. */
+    mutable Histogram erase_probes{}; /**< Probe lengths of erasures. */
+    std::size_t rehashes = 0; /**< Number of rehashes. */
+    std::chrono::nanoseconds rehash_time{0}; /**< Total time spent rehashing. */
+    std::chrono::nanoseconds longest_rehash{0}; /**< Time spent in the longest rehash. */
+
+    /**
+     * @brief Counts an operation in the bucket of its probe length.
+     */
+    static void increment(Histogram& histogram, std::size_t probes) {
+        std::atomic<std::size_t>& bucket = histogram[std::min(probes, MapStats::histogram_size - 1)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Counters of a map that does not collect statistics; every member compiles to nothing.
+ */
+template<>
+class MapStatsCounters<false> {
+public:
+    void record_find(std::size_t) const {} /**< Ignores a lookup. */
+    void record_insert(std::size_t) const {} /**< Ignores an insertion. */
+    void record_erase(std::size_t) const {} /**< Ignores an erasure. */
+
+    /**
+     * @brief Returns a timer that measures nothing.
+     */
+    auto time_rehash() {
+        struct Timer {};
+        return Timer{};
+    }
+
+    void collect(MapStats&) const {} /**< Leaves the operation counters of a snapshot zero. */
+};
+
+/**
+ * @brief The pages of a table shared by a snapshot, copied one by one before the table changes them.
+ *
+ * The slots are cut into pages of page_slots slots. A page starts out shared with the table and
+ * is copied into the snapshot, elements only, the first time the table is about to modify it or
+ * the snapshot is read. The state of a page goes from shared through copying to copied exactly
+ * once, so the table and any number of reader threads may race to copy it: one of them copies,
+ * the others wait for the copy, and the table never writes to a page before it is copied.
+ *
+ * @tparam Value Type of the elements.
+ */
+template<class Value>
+class SnapshotPages {
+public:
+    static constexpr std::size_t page_slots = 512; /**< Number of slots of a page. */
+
+    /**
+     * @brief Shares the slots of a table.
+     *
+     * @param ctrl Control bytes of the table.
+     * @param values Element of the first slot of the table, the following ones stride bytes apart.
+     * @param stride Size of a slot.
+     * @param capacity Number of slots.
+     * @param size Number of elements.
+     * @param heir Empty table that takes the slots over if the map frees them while the snapshot is live.
+     */
+    SnapshotPages(const std::int8_t* ctrl, const void* values, std::size_t stride, std::size_t capacity, std::size_t size,
+                  std::shared_ptr<void> heir)
+        : ctrl_(ctrl), values_(static_cast<const char*>(values)), stride_(stride), capacity_(capacity), size_(size),
+          page_count_((capacity + page_slots - 1) / page_slots), pages_(std::make_unique<Page[]>(page_count_)), heir_(std::move(heir)) {}
+
+    /**
+     * @brief Copies the page of a slot unless it is copied already. Called before the table modifies the slot.
+     *
+     * @param index Index of the slot.
+     */
+    void preserve(std::size_t index) {
+        Page& page = pages_[index / page_slots];
+        if (page.state.load(std::memory_order_acquire) != copied) {
+            copy(index / page_slots);
+        }
+    }
+
+    /**
+     * @brief Copies every page not copied yet, after which the table may free or reorganize its slots.
+     */
+    void preserve_all() {
+        for (std::size_t i = 0; i < page_count_; ++i) {
+            if (pages_[i].state.load(std::memory_order_acquire) != copied) {
+                copy(i);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the number of elements the table held when the snapshot was taken.
+     *
+     * @return Number of elements.
+     */
+    std::size_t size() const {
+        return size_;
+    }
+
+    /**
+     * @brief Calls a function on every element, copying the pages still shared with the table.
+     *
+     * @tparam F Type of the function, callable with const Value&.
+     * @param f The function to call.
+     */
+    template<class F>
+    void for_each(F& f) {
+        for (std::size_t i = 0; i < page_count_; ++i) {
+            if (pages_[i].state.load(std::memory_order_acquire) != copied) {
+                copy(i);
+            }
+            for (const Value& value : pages_[i].elements) {
+                f(value);
+            }
+        }
+    }
+
+private:
+    static constexpr std::uint8_t shared = 0; /**< The page lies in the table only. */
+    static constexpr std::uint8_t copying = 1; /**< A thread is copying the page. */
+    static constexpr std::uint8_t copied = 2; /**< The elements of the page are in the snapshot. */
+
+    /**
+     * @brief A page of slots: its state and, once copied, its elements in slot order.
+     */
+    struct Page {
+        std::atomic<std::uint8_t> state{shared}; /**< Shared, copying or copied. */
+        std::vector<Value> elements; /**< The elements, filled while copying. */
+    };
+
+    const std::int8_t* ctrl_; /**< Control bytes of the table, read only while a page is shared. */
+    const char* values_; /**< Element of the first slot of the table. */
+    std::size_t stride_; /**< Distance between the elements of consecutive slots. */
+    std::size_t capacity_; /**< Number of slots of the table. */
+    std::size_t size_; /**< Number of elements of the table. */
+    std::size_t page_count_; /**< Number of pages. */
+    std::unique_ptr<Page[]> pages_; /**< The pages. */
+    std::shared_ptr<void> heir_; /**< Table owning the slots once the map has let go of them, kept alive while the pages may still be read. */
+
+    /**
+     * @brief Copies a page, or waits until the thread copying it has finished.
+     *
+     * If the copy throws, the page is shared again and a waiting thread takes over.
+     *
+     * @param index Index of the page.
+     */
+    void copy(std::size_t index) {
+        Page& page = pages_[index];
+        std::uint8_t state = page.state.load(std::memory_order_acquire);
+        while (state != copied) {
+            if (state == copying) {
+                page.state.wait(copying, std::memory_order_acquire);
+                state = page.state.load(std::memory_order_acquire);
+            } else if (page.state.compare_exchange_weak(state, copying, std::memory_order_acquire)) {
+                fill(page, index);
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Copies the elements of a page claimed for copying and publishes them.
+     *
+     * @param page The page.
+     * @param index Index of the page.
+     */
+    void fill(Page& page, std::size_t index) {
+        std::size_t end = std::min(capacity_, (index + 1) * page_slots);
+        try {
+            for (std::size_t i = index * page_slots; i < end; ++i) {
+                if (Ctrl::is_full(ctrl_[i])) {
+                    page.elements.push_back(*reinterpret_cast<const Value*>(values_ + i * stride_));
+                }
+            }
+        } catch (...) {
+            page.elements.clear();
+            page.state.store(shared, std::memory_order_release);
+            page.state.notify_all();
+            throw;
+        }
+        page.state.store(copied, std::memory_order_release);
+        page.state.notify_all();
+    }
+};
+
+/**
+ * @brief A consistent view of the elements of an Unordered_map at the time it was taken.
+ *
+ * Taking a snapshot copies nothing: the snapshot shares the slots of the map, and a page of slots
+ * is copied only when the map is about to modify it, or when the snapshot is read. Growing,
+ * shrinking, clearing or destroying the map first copies every page still shared. The map and
+ * its snapshots may be used from different threads; a snapshot is read-only and safe to read
+ * from several threads at once. A snapshot must not outlive the memory the allocator of its map
+ * draws from, see Unordered_map::snapshot.
+ *
+ * @tparam Value Type of the elements.
+ */
+template<class Value>
+class MapSnapshot {
+public:
+    typedef Value value_type; /**< Type of the elements. */
+    typedef std::size_t size_type; /**< Type representing sizes. */
+
+    /**
+     * @brief Constructs an empty snapshot.
+     */
+    MapSnapshot() = default;
+
+    /**
+     * @brief Wraps the pages of a snapshot.
+     *
+     * @param pages The pages, shared with the registry of the map.
+     */
+    explicit MapSnapshot(std::shared_ptr<SnapshotPages<Value>> pages) : pages_(std::move(pages)) {}
+
+    /**
+     * @brief Returns the number of elements.
+     *
+     * @return Number of elements when the snapshot was taken.
+     */
+    size_type size() const {
+        return pages_ ? pages_->size() : 0;
+    }
+
+    /**
+     * @brief Checks if the snapshot has no elements.
+     *
+     * @return True if it has none, false otherwise.
+     */
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Calls a function on every element, in slot order.
+     *
+     * Pages still shared with the map are copied on the way, so reading a snapshot costs the map
+     * at most a short wait for a page being copied.
+     *
+     * @tparam F Type of the function, callable with const value_type&.
+     * @param f The function to call.
+     */
+    template<class F>
+    void for_each(F&& f) const {
+        if (pages_) {
+            pages_->for_each(f);
+        }
+    }
+
+private:
+    std::shared_ptr<SnapshotPages<Value>> pages_; /**< The pages, null for an empty snapshot. */
+};
+
+/**
+ * @brief The live snapshots of a map, whose pages are copied before the map modifies them.
+ *
+ * Snapshots whose last handle is gone are dropped on the next modification.
+ *
+ * @tparam Value Type of the elements.
+ * @tparam Enabled Whether the map supports snapshots.
+ */
+template<class Value, bool Enabled>
+class MapSnapshots {
+public:
+    /**
+     * @brief Takes a snapshot of a table.
+     *
+     * @tparam MakeHeir Type of the function creating the heir.
+     * @param ctrl Control bytes of the table.
+     * @param values Element of the first slot, null without slots.
+     * @param stride Size of a slot.
+     * @param capacity Number of slots.
+     * @param size Number of elements.
+     * @param make_heir Creates the empty table that takes the slots over if the map frees them
+     *        while snapshots are live; called for the first snapshot of the slots only.
+     * @return The snapshot.
+     */
+    template<class MakeHeir>
+    MapSnapshot<Value> take(const std::int8_t* ctrl, const void* values, std::size_t stride, std::size_t capacity, std::size_t size,
+                            MakeHeir make_heir) {
+        if (capacity == 0) {
+            return MapSnapshot<Value>();
+        }
+        prune();
+        if (!heir_) {
+            heir_ = make_heir();
+        }
+        auto pages = std::make_shared<SnapshotPages<Value>>(ctrl, values, stride, capacity, size, heir_);
+        live_.push_back(pages);
+        return MapSnapshot<Value>(std::move(pages));
+    }
+
+    /**
+     * @brief Copies the page of a slot into every live snapshot before the slot is modified.
+     *
+     * Snapshots whose last handle is gone are dropped on the way.
+     *
+     * @param index Index of the slot.
+     */
+    void preserve(std::size_t index) const {
+        if (!live_.empty()) {
+            prune();
+            for (const auto& pages : live_) {
+                pages->preserve(index);
+            }
+        }
+    }
+
+    /**
+     * @brief Copies the page of a slot into every live snapshot, from any of several threads at once.
+     *
+     * Used by mutable iterators, which may be dereferenced concurrently by a parallel traversal,
+     * so the registry itself is left as it is.
+     *
+     * @param index Index of the slot.
+     */
+    void preserve_shared(std::size_t index) const {
+        for (const auto& pages : live_) {
+            pages->preserve(index);
+        }
+    }
+
+    /**
+     * @brief Copies all remaining pages into every live snapshot and forgets them, before the slots are reorganized.
+     */
+    void detach() const {
+        if (!live_.empty()) {
+            prune();
+            for (const auto& pages : live_) {
+                pages->preserve_all();
+            }
+            live_.clear();
+            heir_.reset();
+        }
+    }
+
+    /**
+     * @brief Forgets the live snapshots and returns the heir they share, which is to take over the slots.
+     *
+     * @return The heir, null if no snapshot is live.
+     */
+    std::shared_ptr<void> hand_over() noexcept {
+        live_.clear();
+        return std::move(heir_);
+    }
+
+    /**
+     * @brief Checks for live snapshots.
+     *
+     * @return True if a snapshot may still be read.
+     */
+    bool active() const {
+        return !live_.empty();
+    }
+
+    /**
+     * @brief Swaps the snapshots of two tables along with their storage.
+     *
+     * @param other Another registry.
+     */
+    void swap(MapSnapshots& other) noexcept {
+        live_.swap(other.live_);
+        heir_.swap(other.heir_);
+    }
+
+private:
+    mutable std::vector<std::shared_ptr<SnapshotPages<Value>>> live_; /**< Snapshots sharing pages of the table. */
+    mutable std::shared_ptr<void> heir_; /**< Empty table created with the first live snapshot, shared by all of them. */
+
+    /**
+     * @brief Drops the snapshots no longer referenced outside the registry, and the heir with the last of them.
+     */
+    void prune() const {
+        std::erase_if(live_, [](const std::shared_ptr<SnapshotPages<Value>>& pages) { return pages.use_count() == 1; });
+        if (live_.empty()) {
+            heir_.reset();
+        }
+    }
+};
+
+/**
+ * @brief Registry of a map that does not support snapshots; every member compiles to nothing.
+ *
+ * @tparam Value Type of the elements.
+ */
+template<class Value>
+class MapSnapshots<Value, false> {
+public:
+    void preserve(std::size_t) const {} /**< Ignores a modification. */
+    void preserve_shared(std::size_t) const {} /**< Ignores an access. */
+    void detach() const {} /**< Ignores a reorganization. */
+    std::shared_ptr<void> hand_over() noexcept { return nullptr; } /**< Has no snapshots to hand the slots over to. */
+    bool active() const { return false; } /**< Reports no live snapshots. */
+    void swap(MapSnapshots&) noexcept {} /**< Swaps nothing. */
+};
+
+/**
+ * @brief Satisfied when both the hash function and the key comparison accept any key-like type.
+ *
+ * Such functors declare a nested is_transparent type, as std::hash and std::equal_to do for
+ * heterogeneous lookup in the standard containers.
+ */
+template<class Hash, class KeyEqual>
+concept TransparentLookup = requires {
+    typename Hash::is_transparent;
+    typename KeyEqual::is_transparent;
+};
+
+template<class Key, class T, class Hash, class KeyEqual, class Policy, class Allocator>
+class Unordered_map;
+
+/**
+ * @brief The snapshot registry through which a mutable iterator preserves the page of an element before handing it out.
+ *
+ * @tparam T Type of the elements.
+ * @tparam Enabled Whether the iterator gives mutable access to a map that supports snapshots.
+ */
+template<class T, bool Enabled>
+struct IteratorSnapshots {
+    IteratorSnapshots() = default; /**< Constructs a hook that preserves nothing. */
+
+    /**
+     * @brief Drops the registry of an iterator converted to one that needs none.
+     */
+    template<bool OtherEnabled>
+    IteratorSnapshots(const IteratorSnapshots<T, OtherEnabled>&) noexcept {}
+
+    void preserve(std::size_t) const noexcept {} /**< Ignores an access. */
+};
+
+/**
+ * @brief The snapshot registry of a mutable iterator over a map that supports snapshots.
+ *
+ * @tparam T Type of the elements.
+ */
+template<class T>
+struct IteratorSnapshots<T, true> {
+    const MapSnapshots<T, true>* registry = nullptr; /**< Registry of the map, null for an iterator not made by a map. */
+
+    /**
+     * @brief Copies the page of a slot into the live snapshots before its element is handed out.
+     *
+     * @param index Index of the slot.
+     */
+    void preserve(std::size_t index) const {
+        if (registry != nullptr) {
+            registry->preserve_shared(index);
+        }
+    }
+};
+
+/**
+ * @brief An iterator class for the Unordered_map class.
+ *
+ * Under a map that supports snapshots, dereferencing a mutable iterator first copies the page of
+ * its element into the live snapshots, since the element may be modified through the reference.
+ *
+ * @tparam T The type of value stored in the iterator.
+ * @tparam IsConst Boolean indicating if the iterator is const or not.
+ * @tparam StoreHash Boolean indicating if the entries cache the hashes of their keys.
+ * @tparam Snapshots Boolean indicating if the map supports snapshots.
+ */
+template<class T, bool IsConst, bool StoreHash = false, bool Snapshots = false>
+class MapIterator{
+private:
+    using EntryPointer = std::conditional_t<IsConst, const HashEntry<T, StoreHash>*, HashEntry<T, StoreHash>*>; /**< Pointer to a hash table entry. */
+    using EntryReference = std::conditional_t<IsConst, const HashEntry<T, StoreHash>&, HashEntry<T, StoreHash>&>; /**< Reference to a hash table entry. */
+
+    friend MapIterator<T, !IsConst, StoreHash, Snapshots>;
+
+    template<class, class, class, class, class, class>
+    friend class Unordered_map;
+
+    const std::int8_t* ctrl; /**< Pointer to the control bytes of the hash table. */
+    EntryPointer ptr; /**< Pointer to the current hash table entry. */
+    std::size_t index; /**< Index of the current hash table entry. */
+    std::size_t capacity; /**< Capacity of the hash table. */
+    const std::int8_t* next_ctrl = nullptr; /**< Control bytes of the table iterated after this one, if any. */
+    EntryPointer next_ptr = nullptr; /**< Entries of the table iterated after this one, if any. */
+    std::size_t next_capacity = 0; /**< Capacity of the table iterated after this one. */
+    [[no_unique_address]] IteratorSnapshots<T, Snapshots && !IsConst> snapshots; /**< Registry of the snapshots to preserve pages for. */
+
+    /**
+     * @brief Advances the iterator to the first occupied slot at or after the current one.
+     *
+     * A free slot starts a scan of whole ControlGroups that jumps to the lowest occupied slot of
+     * each group mask, so runs of free slots cost one comparison per group rather than per slot.
+     * Matches in the cloned bytes past the capacity only end the scan. Continues into the next
+     * table when the current one is exhausted.
+     */
+    void skip_free() {
+        while (true) {
+            std::size_t pos = index;
+            while (pos < capacity && !Ctrl::is_full(ctrl[pos])) {
+                auto full = ControlGroup(ctrl + pos).match_full();
+                pos += full.trailing_zeros();
+                if (full) {
+                    break;
+                }
+            }
+            index = std::min(pos, capacity);
+            if (index < capacity || next_ptr == nullptr) {
+                return;
+            }
+            ctrl = next_ctrl;
+            ptr = next_ptr;
+            capacity = next_capacity;
+            index = 0;
+            next_ctrl = nullptr;
+            next_ptr = nullptr;
+            next_capacity = 0;
+        }
+    }
+
+public:
+    using iterator_category = std::forward_iterator_tag; /**< Iterator category. */
+    using value_type = T; /**< Value type of the iterator. */
+    using difference_type = std::ptrdiff_t; /**< Difference type for the iterator. */
+    using pointer = std::conditional_t<IsConst, const value_type*, value_type*>; /**< Pointer type of the iterator. */
+    using reference = std::conditional_t<IsConst, const value_type&, value_type&>; /**< Reference type of the iterator. */
+
+    /**
+     * @brief Default constructor.
+     */
+    MapIterator() : ctrl(nullptr), ptr(nullptr), index(0), capacity(0) {}
+
+    /**
+     * @brief Constructor with parameters.
+     *
+     * @param ctrl Pointer to the control bytes of the hash table.
+     * @param ptr Pointer to the hash table entry.
+     * @param index Index of the hash table entry.
+     * @param capacity Capacity of the hash table.
+     */
+    MapIterator(const std::int8_t* ctrl, EntryPointer ptr, std::size_t index, std::size_t capacity) : ctrl(ctrl), ptr(ptr), index(index), capacity(capacity) {}
+
+    /**
+     * @brief Constructor for an iterator that continues into a second table.
+     *
+     * Used while a growing map still holds elements in its old table.
+     *
+     * @param ctrl Pointer to the control bytes of the hash table.
+     * @param ptr Pointer to the hash table entry.
+     * @param index Index of the hash table entry.
+     * @param capacity Capacity of the hash table.
+     * @param next_ctrl Pointer to the control bytes of the table iterated next.
+     * @param next_ptr Pointer to the entries of the table iterated next.
+     * @param next_capacity Capacity of the table iterated next.
+     */
+    MapIterator(const std::int8_t* ctrl, EntryPointer ptr, std::size_t index, std::size_t capacity,
+                const std::int8_t* next_ctrl, EntryPointer next_ptr, std::size_t next_capacity)
+        : ctrl(ctrl), ptr(ptr), index(index), capacity(capacity), next_ctrl(next_ctrl), next_ptr(next_ptr), next_capacity(next_capacity) {}
+
+    /**
+     * @brief Move constructor.
+     *
+     * Constructs the iterator from rvalue reference to another iterator.
+     *
+     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
+     * @param other Rvalue reference to another iterator.
+     */
+    template<bool OtherConst>
+    requires(IsConst >= OtherConst)
+    explicit MapIterator(MapIterator<T, OtherConst, StoreHash, Snapshots>&& other) noexcept
+        : ctrl(other.ctrl), ptr(other.ptr), index(other.index), capacity(other.capacity),
+          next_ctrl(other.next_ctrl), next_ptr(other.next_ptr), next_capacity(other.next_capacity), snapshots(other.snapshots) {
+        other.ctrl = nullptr;
+        other.ptr = nullptr;
+        other.index = 0;
+        other.capacity = 0;
+        other.next_ctrl = nullptr;
+        other.next_ptr = nullptr;
+        other.next_capacity = 0;
+    }
+
+    /**
+     * @brief Copy constructor.
+     *
+     * Constructs the iterator from const reference to another iterator.
+     *
+     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
+     * @param other Const reference to another iterator.
+     */
+    template<bool OtherConst>
+    requires(IsConst >= OtherConst)
+    explicit MapIterator(const MapIterator<T, OtherConst, StoreHash, Snapshots>& other)
+        : ctrl(other.ctrl), ptr(other.ptr), index(other.index), capacity(other.capacity),
+          next_ctrl(other.next_ctrl), next_ptr(other.next_ptr), next_capacity(other.next_capacity), snapshots(other.snapshots) {}
+
+    /**
+     * @brief Destructor.
+     *
+     * Destroys the iterator object.
+     */
+    ~MapIterator() = default;
+
+    /**
+     * @brief Move assignment operator.
+     *
+     * Assigns the iterator from rvalue reference to another iterator.
+     *
+     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
+     * @param other Rvalue reference to another iterator.
+     * @return Reference to the current iterator.
+     */
+    template<bool OtherConst>
+    requires(IsConst >= OtherConst)
+    MapIterator& operator=(MapIterator<T, OtherConst, StoreHash, Snapshots>&& other) noexcept {
+        if (this != &other) {
+            ctrl = other.ctrl;
+            ptr = other.ptr;
+            index = other.index;
+            capacity = other.capacity;
+            next_ctrl = other.next_ctrl;
+            next_ptr = other.next_ptr;
+            next_capacity = other.next_capacity;
+            snapshots = other.snapshots;
+            other.ctrl = nullptr;
+            other.ptr = nullptr;
+            other.index = 0;
+            other.capacity = 0;
+            other.next_ctrl = nullptr;
+            other.next_ptr = nullptr;
+            other.next_capacity = 0;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Copy assignment operator.
+     *
+     * Assigns the iterator from const reference to another iterator.
+     *
+     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
+     * @param other Const reference to another iterator.
+     * @return Reference to the current iterator.
+     */
+    template<bool OtherConst>
+    requires(IsConst >= OtherConst)
+    MapIterator& operator=(const MapIterator<T, OtherConst, StoreHash, Snapshots>& other) {
+        if (this != &other) {
+            ctrl = other.ctrl;
+            ptr = other.ptr;
+            index = other.index;
+            capacity = other.capacity;
+            next_ctrl = other.next_ctrl;
+            next_ptr = other.next_ptr;
+            next_capacity = other.next_capacity;
+            snapshots = other.snapshots;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Dereference operator.
+     *
+     * @return Reference to the value stored in the current hash table entry.
+     */
+    reference operator*() const {
+        snapshots.preserve(index);
+        return ptr[index].value;
+    }
+
+    /**
+     * @brief Arrow operator.
+     *
+     * @return Pointer to the value stored in the current hash table entry.
+     */
+    pointer operator->() const {
+        snapshots.preserve(index);
+        return &ptr[index].value;
+    }
+
+    /**
+     * @brief Prefix increment operator.
+     *
+     * Increments the iterator to point to the next valid entry in the hash table.
+     *
+     * @return Reference to the incremented iterator.
+     */
+    MapIterator& operator++() {
+        ++index;
+        skip_free();
+        return *this;
+    }
+
+    /**
+     * @brief Postfix increment operator.
+     *
+     * Increments the iterator to point to the next valid entry in the hash table.
+     *
+     * @return Copy of the iterator before incrementing.
+     */
+    MapIterator operator++(int) {
+        MapIterator temp = *this;
+        ++(*this);
+        return temp;
+    }
+
+    /**
+     * @brief Equality operator.
+     *
+     * Checks if two iterators are equal.
+     *
+     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
+     * @param other Iterator to compare with.
+     * @return True if the iterators are equal, false otherwise.
+     */
+    template<bool OtherConst>
+    bool operator==(const MapIterator<T, OtherConst, StoreHash, Snapshots>& other) const noexcept
+    {
+        return ptr == other.ptr && index == other.index;
+    }
+
+    /**
+     * @brief Inequality operator.
+     *
+     * Checks if two iterators are not equal.
+     *
+     * @tparam OtherConst Boolean indicating if the other iterator is const or not.
+     * @param other Iterator to compare with.
+     * @return True if the iterators are not equal, false otherwise.
+     */
+    template<bool OtherConst>
+    bool operator!=(const MapIterator<T, OtherConst, StoreHash, Snapshots>& other) const noexcept
+    {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @brief A half-open range of map elements, usable in range-based for loops.
+ *
+ * @tparam Iterator Type of the iterators delimiting the range.
+ */
+template<class Iterator>
+struct MapRange {
+    Iterator first; /**< Iterator to the first element of the range. */
+    Iterator last; /**< Iterator past the last element of the range. */
+
+    /**
+     * @brief Returns an iterator to the first element of the range.
+     *
+     * @return Iterator to the first element.
+     */
+    Iterator begin() const {
+        return first;
+    }
+
+    /**
+     * @brief Returns an iterator past the last element of the range.
+     *
+     * @return Iterator past the last element.
+     */
+    Iterator end() const {
+        return last;
+    }
+};
+
+/**
+ * @brief A handle owning an element extracted from an Unordered_map.
+ *
+ * The element lives in storage of the handle, so it can be modified, kept or inserted into
+ * another map, and is moved rather than copied on the way.
+ *
+ * @tparam Key Type of the key of the element.
+ * @tparam T Type of the value of the element.
+ * @tparam Allocator Allocator the element was constructed with.
+ */
+template<class Key, class T, class Allocator>
+class MapNode {
+private:
+    template<class, class, class, class, class, class>
+    friend class Unordered_map;
+
+    using alloc_traits = std::allocator_traits<Allocator>; /**< Traits of the element allocator. */
+
+    union {
+        std::pair<Key, T> value; /**< The element, alive only while alloc holds an allocator. */
+    };
+    std::optional<Allocator> alloc; /**< Allocator of the element, empty for an empty handle. */
+
+    /**
+     * @brief Constructs a handle owning an element moved out of a map.
+     *
+     * @param allocator The allocator of the map.
+     * @param element The element to take over.
+     */
+    MapNode(const Allocator& allocator, std::pair<Key, T>&& element) : alloc(allocator) {
+        alloc_traits::construct(*alloc, &value, std::move(element));
+    }
+
+    /**
+     * @brief Destroys the element, if any, leaving the handle empty.
+     */
+    void reset() noexcept {
+        if (alloc) {
+            alloc_traits::destroy(*alloc, &value);
+            alloc.reset();
+        }
+    }
+
+public:
+    typedef Key key_type; /**< Type of the key of the element. */
+    typedef T mapped_type; /**< Type of the value of the element. */
+    typedef Allocator allocator_type; /**< Type of the allocator. */
+
+    /**
+     * @brief Constructs an empty handle.
+     */
+    MapNode() noexcept {}
+
+    /**
+     * @brief Move constructor, taking over the element of another handle.
+     *
+     * @param other The handle to move from, left empty.
+     */
+    MapNode(MapNode&& other) noexcept(std::is_nothrow_move_constructible_v<std::pair<Key, T>>) {
+        if (other.alloc) {
+            alloc.emplace(*other.alloc);
+            alloc_traits::construct(*alloc, &value, std::move(other.value));
+            other.reset();
+        }
+    }
+
+    /**
+     * @brief Move assignment operator, destroying the current element first.
+     *
+     * @param other The handle to move from, left empty.
+     * @return Reference to this handle.
+     */
+    MapNode& operator=(MapNode&& other) {
+        if (this != &other) {
+            reset();
+            if (other.alloc) {
+                alloc.emplace(*other.alloc);
+                alloc_traits::construct(*alloc, &value, std::move(other.value));
+                other.reset();
+            }
+        }
+        return *this;
+    }
+
+    MapNode(const MapNode&) = delete;
+    MapNode& operator=(const MapNode&) = delete;
+
+    /**
+     * @brief Destructor, destroying the element if the handle owns one.
+     */
+    ~MapNode() {
+        reset();
+    }
+
+    /**
+     * @brief Checks if the handle owns no element.
+     *
+     * @return True if the handle is empty.
+     */
+    bool empty() const noexcept {
+        return !alloc;
+    }
+
+    /**
+     * @brief Checks if the handle owns an element.
+     *
+     * @return True if the handle is not empty.
+     */
+    explicit operator bool() const noexcept {
+        return alloc.has_value();
+    }
+
+    /**
+     * @brief Returns the allocator of the element.
+     *
+     * @return The allocator; the handle must not be empty.
+     */
+    allocator_type get_allocator() const {
+        return *alloc;
+    }
+
+    /**
+     * @brief Accesses the key of the element, which may be changed before reinsertion.
+     *
+     * @return Reference to the key; the handle must not be empty.
+     */
+    key_type& key() {
+        return value.first;
+    }
+
+    /**
+     * @brief Accesses the key of the element (const version).
+     *
+     * @return Const reference to the key; the handle must not be empty.
+     */
+    const key_type& key() const {
+        return value.first;
+    }
+
+    /**
+     * @brief Accesses the value of the element.
+     *
+     * @return Reference to the value; the handle must not be empty.
+     */
+    mapped_type& mapped() {
+        return value.second;
+    }
+
+    /**
+     * @brief Accesses the value of the element (const version).
+     *
+     * @return Const reference to the value; the handle must not be empty.
+     */
+    const mapped_type& mapped() const {
+        return value.second;
+    }
+};
+
+/**
+ * @brief Result of inserting a MapNode into an Unordered_map.
+ *
+ * @tparam Iterator Type of the iterators of the map.
+ * @tparam Node Type of the node handles of the map.
+ */
+template<class Iterator, class Node>
+struct MapInsertReturn {
+    Iterator position; /**< The inserted element, or the element that prevented the insertion. */
+    bool inserted; /**< True if the node was inserted. */
+    Node node; /**< The node if it was not inserted, empty otherwise. */
+};
+
+/**
+ * @brief An unordered map implementation.
+ *
+ * Open addressing table in the Swiss table layout: a byte-per-slot control array holding a
+ * 7-bit hash fragment of every occupied slot is probed a whole ControlGroup at a time, and keys
+ * are compared only for slots whose fragment matches.
+ *
+ * @tparam Key Type of the keys stored in the map.
+ * @tparam T Type of the values stored in the map.
+ * @tparam Hash Hash function for computing hash values of keys.
+ * @tparam KeyEqual Function object for comparing keys for equality.
+ * @tparam Policy Compile-time options of the map, see DefaultMapPolicy.
+ * @tparam Allocator Allocator of the elements, rebound for the slot, control byte and distance arrays.
+ */
+template<class Key, class T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>, class Policy = DefaultMapPolicy,
+         class Allocator = std::allocator<std::pair<Key, T>>>
+class Unordered_map{
+public:
+    typedef Key key_type; /**< Type of the keys stored in the map. */
+    typedef T mapped_type; /**< Type of the values stored in the map. */
+    typedef std::pair<Key, T> value_type; /**< Type representing key-value pairs stored in the map. */
+    typedef Hash hasher; /**< Type of the hash function. */
+    typedef KeyEqual key_equal; /**< Type of the function object for comparing keys for equality. */
+    typedef std::pair<Key, T> reference; /**< Reference type for the key-value pairs stored in the map. */
+    typedef const std::pair<Key, T> const_reference; /**< Const reference type for the key-value pairs stored in the map. */
+    typedef MapIterator<value_type, false, Policy::store_hash, Policy::snapshots> iterator; /**< Iterator type for non-const access to elements. */
+    typedef MapIterator<value_type, true, Policy::store_hash, Policy::snapshots> const_iterator; /**< Iterator type for const access to elements. */
+    typedef MapRange<iterator> range; /**< Type of a range of elements for non-const access. */
+    typedef MapRange<const_iterator> const_range; /**< Type of a range of elements for const access. */
+    typedef MapNode<Key, T, Allocator> node_type; /**< Type of the handles of extracted elements. */
+    typedef MapInsertReturn<iterator, node_type> insert_return_type; /**< Type returned by inserting a node. */
+    typedef MapSnapshot<value_type> snapshot_type; /**< Type of the copy-on-write snapshots of the map. */
+    typedef value_type* pointer; /**< Pointer type for the key-value pairs stored in the map. */
+    typedef const value_type* const_pointer; /**< Const pointer type for the key-value pairs stored in the map. */
+    typedef ptrdiff_t difference_type; /**< Type representing the difference between two iterators. */
+    typedef std::size_t size_type; /**< Type representing sizes and indices. */
+    typedef HashEntry<value_type, Policy::store_hash> entry_type; /**< Type of the hash table entry. */
+    typedef Policy policy_type; /**< Type of the compile-time options of the map. */
+    typedef typename Policy::capacity_policy capacity_policy; /**< Type of the mapping of hashes to slots. */
+    typedef typename Policy::probing probing; /**< Type of the order in which control groups are probed. */
+    typedef Allocator allocator_type; /**< Type of the allocator. */
+
+    static_assert(std::is_same_v<typename std::allocator_traits<Allocator>::value_type, value_type>,
+                  "Unordered_map allocator must allocate value_type");
+    static_assert(!probing::needs_power_of_two || std::is_same_v<capacity_policy, PowerOfTwoCapacity>,
+                  "Unordered_map probing policy requires power-of-two capacities");
+    static_assert(!Policy::cuckoo || (std::is_same_v<capacity_policy, PowerOfTwoCapacity> && !Policy::robin_hood && Policy::resize_step == 0),
+                  "Unordered_map cuckoo policy requires power-of-two capacities and excludes Robin Hood and incremental resizing");
+
+    /**
+     * @brief Default constructor.
+     *
+     * Constructs an empty unordered map.
+     */
+    Unordered_map() = default;
+
+    /**
+     * @brief Constructs an empty unordered map using a given allocator.
+     *
+     * @param alloc The allocator for all memory of the map.
+     */
+    explicit Unordered_map(const Allocator& alloc) : alloc_(alloc) {}
+
+    /**
+     * @brief Constructs an empty unordered map using a given hash function.
+     *
+     * Stateful hash functions such as a seeded FastHash are kept per map and copied along with it.
+     *
+     * @param hash The hash function for all keys of the map.
+     * @param alloc The allocator for all memory of the map.
+     */
+    explicit Unordered_map(const Hash& hash, const Allocator& alloc = Allocator()) : alloc_(alloc), hash_(hash) {}
+
+    /**
+     * @brief Copy constructor.
+     *
+     * Constructs the unordered map with a copy of the contents of another unordered map.
+     *
+     * @param other Another unordered map to be copied.
+     */
+    Unordered_map(const Unordered_map& other)
+        : Unordered_map(other, alloc_traits::select_on_container_copy_construction(other.alloc_)) {}
+
+    /**
+     * @brief Copy constructor using a given allocator.
+     *
+     * @param other Another unordered map to be copied.
+     * @param alloc The allocator for all memory of the map.
+     */
+    Unordered_map(const Unordered_map& other, const Allocator& alloc) : max_load(other.max_load), min_load(other.min_load), alloc_(alloc), hash_(other.hash_) {
+        if (other.old_) {
+            old_ = std::make_unique<Unordered_map>(*other.old_, alloc_);
+            migrated_ = other.migrated_;
+        }
+        if (other.capacity_ != 0) {
+            allocate(other.capacity_);
+            std::copy(other.ctrl_, other.ctrl_ + ctrl_bytes(capacity_), ctrl_);
+            if constexpr (Policy::robin_hood) {
+                std::copy(other.dist_, other.dist_ + other.capacity_, dist_);
+            }
+            size_type i = 0;
+            try {
+                for (; i < capacity_; ++i) {
+                    if (Ctrl::is_full(ctrl_[i])) {
+                        alloc_traits::construct(alloc_, &array[i].value, other.array[i].value);
+                        if constexpr (Policy::store_hash) {
+                            array[i].hash = other.array[i].hash;
+                        }
+                    }
+                }
+            } catch (...) {
+                destroy_values(i);
+                release();
+                throw;
+            }
+            size_ = other.size_;
+            tombstones_ = other.tombstones_;
+        }
+    }
+
+    /**
+     * @brief Move constructor.
+     *
+     * Constructs the unordered map with the contents of another unordered map using move semantics.
+     *
+     * @param other Another unordered map to be moved.
+     */
+    Unordered_map(Unordered_map&& other) noexcept : size_(other.size_), capacity_(other.capacity_), tombstones_(other.tombstones_), max_load(other.max_load),
+                                                    min_load(other.min_load), ctrl_(other.ctrl_), array(other.array), dist_(other.dist_),
+                                                    mapping_(std::move(other.mapping_)), old_(std::move(other.old_)), migrated_(other.migrated_),
+                                                    alloc_(other.alloc_), hash_(other.hash_) {
+        snapshots_.swap(other.snapshots_);
+        other.migrated_ = 0;
+        other.size_ = 0;
+        other.capacity_ = 0;
+        other.tombstones_ = 0;
+        other.max_load = 0.8f;
+        other.min_load = 0.0f;
+        other.ctrl_ = nullptr;
+        other.array = nullptr;
+        other.dist_ = nullptr;
+    }
+
+    /**
+     * @brief Destructor.
+     *
+     * Destroys the unordered map object.
+     */
+    ~Unordered_map() {
+        deallocate();
+    }
+
+    /**
+     * @brief Copy assignment operator.
+     *
+     * Replaces the contents with a copy of the contents of another unordered map.
+     *
+     * @param other Another unordered map to use as a source.
+     * @return Reference to the current unordered map.
+     */
+    Unordered_map& operator=(const Unordered_map& other) {
+        if (this != &other) {
+            constexpr bool propagate = alloc_traits::propagate_on_container_copy_assignment::value;
+            Unordered_map copy(other, propagate ? other.alloc_ : alloc_);
+            swap_contents(copy);
+            if constexpr (propagate) {
+                std::swap(alloc_, copy.alloc_);
+            }
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment operator.
+     *
+     * Replaces the contents with those of another unordered map using move semantics. The storage
+     * is taken over if the allocators allow it, otherwise the elements are moved one by one.
+     *
+     * @param other Another unordered map to be moved.
+     * @return Reference to the current unordered map.
+     */
+    Unordered_map& operator=(Unordered_map&& other) noexcept(alloc_traits::propagate_on_container_move_assignment::value ||
+                                                             alloc_traits::is_always_equal::value) {
+        if (this == &other) {
+            return *this;
+        }
+        clear();
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+            alloc_ = other.alloc_;
+        } else if (!alloc_traits::is_always_equal::value && alloc_ != other.alloc_) {
+            max_load = other.max_load;
+            min_load = other.min_load;
+            hash_ = other.hash_;
+            reserve(other.capacity());
+            for (auto& entry : other) {
+                insert(std::move(entry));
+            }
+            other.clear();
+            return *this;
+        }
+        swap_contents(other);
+        return *this;
+    }
+
+    /**
+     * @brief Returns an iterator to the beginning of the unordered map.
+     *
+     * @return Iterator to the beginning.
+     */
+    iterator begin() {
+        iterator it = old_ ? iterator(old_->ctrl_, old_->array, 0, old_->capacity_, ctrl_, array, capacity_)
+                           : iterator(ctrl_, array, 0, capacity_);
+        it.skip_free();
+        return with_snapshots(it);
+    }
+
+/**
+ * @brief Returns a const iterator to the beginning of the unordered map.
+ *
+ * @return Const iterator to the beginning.
+ */
+    const_iterator begin() const {
+        const_iterator it = old_ ? const_iterator(old_->ctrl_, old_->array, 0, old_->capacity_, ctrl_, array, capacity_)
+                                 : const_iterator(ctrl_, array, 0, capacity_);
+        it.skip_free();
+        return it;
+    }
+
+    /**
+     * @brief Returns an iterator to the end of the unordered map.
+     *
+     * @return Iterator to the end.
+     */
+    iterator end() {
+        return iterator(ctrl_, array, capacity_, capacity_);
+    }
+
+    /**
+     * @brief Returns a const iterator to the end of the unordered map.
+     *
+     * @return Const iterator to the end.
+     */
+    const_iterator end() const {
+        return const_iterator(ctrl_, array, capacity_, capacity_);
+    }
+
+    /**
+     * @brief Splits the slots of the map into contiguous ranges for parallel traversal.
+     *
+     * The slot array is cut into count ranges of nearly equal length, so every range is built in
+     * constant time and no traversal is needed to find the split points. Every element belongs to
+     * exactly one range; while a resize is in progress the slots of the old table come first.
+     * The ranges are invalidated by any modification of the map. Dereferencing their iterators
+     * copies the page of the element into the live snapshots, from any number of threads at once.
+     *
+     * @param count Number of ranges, at least 1.
+     * @return The ranges, in iteration order.
+     */
+    std::vector<range> partitions(size_type count) {
+        return split_slots<iterator>(count);
+    }
+
+    /**
+     * @brief Splits the slots of the map into contiguous const ranges for parallel traversal.
+     *
+     * @param count Number of ranges, at least 1.
+     * @return The ranges, in iteration order.
+     */
+    std::vector<const_range> partitions(size_type count) const {
+        return split_slots<const_iterator>(count);
+    }
+
+    /**
+     * @brief Returns the number of elements in the unordered map.
+     *
+     * @return Number of elements in the unordered map.
+     */
+    size_type size() const {
+        return old_ ? size_ + old_->size_ : size_;
+    }
+
+    /**
+     * @brief Returns the number of elements that the unordered map can hold.
+     *
+     * @return Capacity of the unordered map.
+     */
+    size_type capacity() const {
+        return capacity_;
+    }
+
+    /**
+     * @brief Returns the maximum number of elements the unordered map can hold.
+     *
+     * @return Maximum size of the unordered map.
+     */
+    size_type max_size() const {
+        return std::numeric_limits<size_type>::max();
+    }
+
+    /**
+     * @brief Checks if the unordered map is empty.
+     *
+     * @return True if the unordered map is empty, false otherwise.
+     */
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Calculates the load factor of the unordered map.
+     *
+     * @return Load factor of the unordered map.
+     */
+    float load() const {
+        if (capacity_ == 0) {
+            return 0.0f;
+        }
+        return static_cast<float>(size()) / capacity_;
+    }
+
+    /**
+     * @brief Returns the maximum load factor of the unordered map.
+     *
+     * @return Maximum load factor of the unordered map.
+     */
+    float get_max_load() const {
+        return max_load;
+    }
+
+    /**
+     * @brief Returns the maximum load factor of the unordered map.
+     *
+     * @return Maximum share of slots holding elements or tombstones before the table grows or is cleaned.
+     */
+    float max_load_factor() const {
+        return max_load;
+    }
+
+    /**
+     * @brief Sets the maximum load factor, growing the table at once if it is already loaded beyond it.
+     *
+     * @param load The new maximum load factor, above 0 and at most 1.
+     * @throw std::invalid_argument if the load factor is out of range or not above the minimum load factor.
+     */
+    void max_load_factor(float load) {
+        if (!(load > 0.0f && load <= 1.0f) || load <= min_load) {
+            throw std::invalid_argument("Unordered_map maximum load factor out of range");
+        }
+        max_load = load;
+        if (size() + tombstones_ > max_load * capacity_) {
+            [[maybe_unused]] auto timer = counters_.time_rehash();
+            reallocate(std::max(fitting_capacity(size(), max_load), capacity_));
+        }
+    }
+
+    /**
+     * @brief Returns the low-water mark of the load factor.
+     *
+     * @return Load factor below which erasing by key shrinks the table, 0 if it never shrinks.
+     */
+    float min_load_factor() const {
+        return min_load;
+    }
+
+    /**
+     * @brief Sets the low-water mark of the load factor, enabling automatic shrinking.
+     *
+     * Once erasing by key leaves fewer elements than this share of the slots, the table shrinks
+     * to the capacity at which it is about half as loaded as the maximum load factor allows, so
+     * the next few insertions or erasures do not resize it again.
+     *
+     * @param load The new minimum load factor, at least 0 and below the maximum load factor; 0 disables shrinking.
+     * @throw std::invalid_argument if the load factor is out of range.
+     */
+    void min_load_factor(float load) {
+        if (!(load >= 0.0f && load < max_load)) {
+            throw std::invalid_argument("Unordered_map minimum load factor out of range");
+        }
+        min_load = load;
+    }
+
+    /**
+     * @brief Shrinks the table to the smallest capacity that holds the elements under the maximum load factor.
+     *
+     * Tombstones are dropped even if the capacity stays the same, and an empty map releases its
+     * storage entirely. Invalidates all iterators.
+     */
+    void shrink_to_fit() {
+        finish_migration();
+        if (size_ == 0) {
+            deallocate();
+            return;
+        }
+        size_type fitting = fitting_capacity(size_, max_load);
+        if (fitting < capacity_) {
+            [[maybe_unused]] auto timer = counters_.time_rehash();
+            reallocate(fitting);
+        } else if (tombstones_ != 0) {
+            [[maybe_unused]] auto timer = counters_.time_rehash();
+            drop_tombstones();
+        }
+    }
+
+    /**
+     * @brief Shrinks the table if its load fell below the minimum load factor.
+     *
+     * Erasing by key calls it after every erasure. Erasing at an iterator does not, as that must
+     * keep the other iterators valid; callers done erasing at iterators may call it themselves.
+     * The load counts the elements of both tables while a resize is in progress, and a shrink
+     * finishes the migration first.
+     *
+     * @return True if the table shrank, invalidating all iterators.
+     */
+    bool shrink_if_underloaded() {
+        if (size() >= min_load * capacity_) {
+            return false;
+        }
+        size_type target = fitting_capacity(size(), max_load / 2);
+        if (target >= capacity_) {
+            return false;
+        }
+        [[maybe_unused]] auto timer = counters_.time_rehash();
+        reallocate(target);
+        return true;
+    }
+
+    /**
+     * @brief Clears the contents of the unordered map, releasing its storage and keeping its load factors.
+     */
+    void clear() {
+        deallocate();
+        old_.reset();
+        migrated_ = 0;
+        size_ = 0;
+    }
+
+    /**
+     * @brief Finds an element with a specific key in the unordered map.
+     *
+     * @param key The key of the element to search for.
+     * @return Iterator to the element with the specified key if found, end() otherwise.
+     */
+    iterator find(const Key& key) {
+        return locate<iterator>(key);
+    }
+
+    /**
+     * @brief Finds an element with a specific key in the unordered map (const version).
+     *
+     * @param key The key of the element to search for.
+     * @return Const iterator to the element with the specified key if found, end() otherwise.
+     */
+    const_iterator find(const Key& key) const {
+        return locate<const_iterator>(key);
+    }
+
+    /**
+     * @brief Finds an element with a key equivalent to a key-like value, without constructing a key_type.
+     *
+     * Available only when both Hash and KeyEqual are transparent.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value to search for.
+     * @return Iterator to the element with an equivalent key if found, end() otherwise.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    iterator find(const K& key) {
+        return locate<iterator>(key);
+    }
+
+    /**
+     * @brief Finds an element with a key equivalent to a key-like value (const version).
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value to search for.
+     * @return Const iterator to the element with an equivalent key if found, end() otherwise.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    const_iterator find(const K& key) const {
+        return locate<const_iterator>(key);
+    }
+
+    /**
+     * @brief Finds an element with a specific key whose hash the caller has already computed.
+     *
+     * Lets one hash computation serve several operations on a key, or the hashes of related keys
+     * be derived from a common part. The hash must be the value hash_function() returns for the
+     * key, otherwise the element is not found.
+     *
+     * @param key The key of the element to search for.
+     * @param hash The hash of the key.
+     * @return Iterator to the element with the specified key if found, end() otherwise.
+     */
+    iterator find(const Key& key, std::size_t hash) {
+        return locate<iterator>(key, capacity_policy::mix(hash));
+    }
+
+    /**
+     * @brief Finds an element with a specific key whose hash the caller has already computed (const version).
+     *
+     * @param key The key of the element to search for.
+     * @param hash The hash of the key, as returned by hash_function().
+     * @return Const iterator to the element with the specified key if found, end() otherwise.
+     */
+    const_iterator find(const Key& key, std::size_t hash) const {
+        return locate<const_iterator>(key, capacity_policy::mix(hash));
+    }
+
+    /**
+     * @brief Finds an element with a key equivalent to a key-like value whose hash the caller has already computed.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value to search for.
+     * @param hash The hash of the value, as returned by hash_function().
+     * @return Iterator to the element with an equivalent key if found, end() otherwise.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    iterator find(const K& key, std::size_t hash) {
+        return locate<iterator>(key, capacity_policy::mix(hash));
+    }
+
+    /**
+     * @brief Finds an element with a key equivalent to a key-like value whose hash the caller has already computed (const version).
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value to search for.
+     * @param hash The hash of the value, as returned by hash_function().
+     * @return Const iterator to the element with an equivalent key if found, end() otherwise.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    const_iterator find(const K& key, std::size_t hash) const {
+        return locate<const_iterator>(key, capacity_policy::mix(hash));
+    }
+
+    /**
+     * @brief Inserts an element or updates the element if the key already exists.
+     *
+     * @param value The key-value pair to insert or update.
+     * @return Pair with an iterator to the inserted or updated element and a bool indicating whether the insertion took place.
+     */
+    std::pair<iterator, bool> insert(const value_type& value) {
+        auto [index, inserted] = find_or_prepare_insert(value.first);
+        if (inserted) {
+            construct(index, value);
+        }
+        return {with_snapshots(iterator(ctrl_, array, index, capacity_)), inserted};
+    }
+
+    /**
+     * @brief Inserts an element or updates the element if the key already exists (move version).
+     *
+     * @param value The key-value pair to insert or update.
+     * @return Pair with an iterator to the inserted or updated element and a bool indicating whether the insertion took place.
+     */
+    std::pair<iterator, bool> insert(value_type&& value) {
+        auto [index, inserted] = find_or_prepare_insert(value.first);
+        if (inserted) {
+            construct(index, std::move(value));
+        }
+        return {with_snapshots(iterator(ctrl_, array, index, capacity_)), inserted};
+    }
+
+    /**
+     * @brief Inserts a new element into the unordered map using a key and arguments for the value constructor.
+     *
+     * @tparam Args Types of the arguments for the value constructor.
+     * @param key The key of the new element.
+     * @param args Arguments for the value constructor.
+     * @return Pair with an iterator to the inserted element and a bool indicating whether the insertion took place.
+     */
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(const key_type& key, Args&&... args) {
+        return try_emplace(key, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Inserts an element constructed in place if the key is not present yet.
+     *
+     * The key is probed for once; when it is absent the value is constructed directly in the
+     * prepared slot. When it is present the arguments are left untouched.
+     *
+     * @tparam Args Types of the arguments for the value constructor.
+     * @param key The key of the element.
+     * @param args Arguments for the value constructor.
+     * @return Pair with an iterator to the element with the key and a bool indicating whether the insertion took place.
+     */
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+        auto [index, inserted] = find_or_prepare_insert(key);
+        if (inserted) {
+            construct(index, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        return {with_snapshots(iterator(ctrl_, array, index, capacity_)), inserted};
+    }
+
+    /**
+     * @brief Inserts an element constructed in place if the key is not present yet (move version).
+     *
+     * The key is moved from only if the insertion takes place.
+     *
+     * @tparam Args Types of the arguments for the value constructor.
+     * @param key The key of the element.
+     * @param args Arguments for the value constructor.
+     * @return Pair with an iterator to the element with the key and a bool indicating whether the insertion took place.
+     */
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+        auto [index, inserted] = find_or_prepare_insert(key);
+        if (inserted) {
+            construct(index, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        return {with_snapshots(iterator(ctrl_, array, index, capacity_)), inserted};
+    }
+
+    /**
+     * @brief Inserts an element or assigns to the value of the element with the same key.
+     *
+     * @tparam M Type of the value, assignable to mapped_type.
+     * @param key The key of the element.
+     * @param value The value to insert or assign.
+     * @return Pair with an iterator to the element with the key and a bool indicating whether the insertion took place.
+     */
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& value) {
+        auto result = try_emplace(key, std::forward<M>(value));
+        if (!result.second) {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Inserts an element or assigns to the value of the element with the same key (move version).
+     *
+     * @tparam M Type of the value, assignable to mapped_type.
+     * @param key The key of the element, moved from only if the insertion takes place.
+     * @param value The value to insert or assign.
+     * @return Pair with an iterator to the element with the key and a bool indicating whether the insertion took place.
+     */
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& value) {
+        auto result = try_emplace(std::move(key), std::forward<M>(value));
+        if (!result.second) {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Inserts a range of elements, skipping those whose keys are already present.
+     *
+     * The table is grown once up front to hold the whole range, at least doubling as insert()
+     * would, so a stream of bursts still costs amortized constant time. Elements are then inserted in
+     * batches: the keys of a batch are hashed and their home slots prefetched before the first of
+     * them is probed, so the cache misses of a batch overlap instead of being paid one after the
+     * other. Input iterators that cannot be traversed twice are inserted one at a time.
+     *
+     * @tparam InputIt Type of the iterators, dereferencing to key-value pairs.
+     * @param first Iterator to the first element to insert.
+     * @param last Iterator past the last element to insert.
+     * @return Number of elements inserted.
+     */
+    template<class InputIt>
+    size_type insert_bulk(InputIt first, InputIt last) {
+        size_type inserted = 0;
+        if constexpr (std::forward_iterator<InputIt>) {
+            size_type total = size() + static_cast<size_type>(std::distance(first, last));
+            size_type needed = static_cast<size_type>(static_cast<double>(total) / max_load) + 1;
+            if (needed > capacity_) {
+                reserve(std::max(needed, capacity_ * 2));
+            }
+            std::size_t hashes[batch_size];
+            while (first != last) {
+                size_type count = 0;
+                for (InputIt it = first; it != last && count < batch_size; ++it, ++count) {
+                    hashes[count] = hash_of((*it).first);
+                    prefetch_home(hashes[count]);
+                }
+                for (size_type i = 0; i < count; ++i, ++first) {
+                    auto [index, prepared] = find_or_prepare_insert((*first).first, hashes[i]);
+                    if (prepared) {
+                        construct(index, *first);
+                        ++inserted;
+                    }
+                }
+            }
+        } else {
+            for (; first != last; ++first) {
+                inserted += insert(*first).second;
+            }
+        }
+        return inserted;
+    }
+
+    /**
+     * @brief Looks up a range of keys, prefetching the home slots of a batch of keys before probing them.
+     *
+     * @tparam KeyIt Type of the iterators over the keys, or over key-like values for transparent lookup.
+     * @tparam OutputIt Type of the output iterator receiving an iterator per key.
+     * @param first Iterator to the first key.
+     * @param last Iterator past the last key.
+     * @param out Output receiving, in order, an iterator to the element of every key or end() if it is absent.
+     * @return Output iterator past the last iterator written.
+     */
+    template<std::forward_iterator KeyIt, class OutputIt>
+    OutputIt find_many(KeyIt first, KeyIt last, OutputIt out) {
+        return locate_many<iterator>(first, last, out);
+    }
+
+    /**
+     * @brief Looks up a range of keys, prefetching the home slots of a batch of keys before probing them (const version).
+     *
+     * @tparam KeyIt Type of the iterators over the keys, or over key-like values for transparent lookup.
+     * @tparam OutputIt Type of the output iterator receiving a const iterator per key.
+     * @param first Iterator to the first key.
+     * @param last Iterator past the last key.
+     * @param out Output receiving, in order, an iterator to the element of every key or end() if it is absent.
+     * @return Output iterator past the last iterator written.
+     */
+    template<std::forward_iterator KeyIt, class OutputIt>
+    OutputIt find_many(KeyIt first, KeyIt last, OutputIt out) const {
+        return locate_many<const_iterator>(first, last, out);
+    }
+
+    /**
+     * @brief Accesses the mapped value associated with the given key.
+     *
+     * @param key The key of the element to access.
+     * @return Reference to the mapped value of the element with the specified key.
+     * @throw std::out_of_range if the key is not found.
+     */
+    mapped_type& at(const key_type& key) {
+        iterator it = find(key);
+        if (it != end()) {
+            return it->second;
+        } else {
+            throw std::out_of_range("Key not found");
+        }
+    }
+
+    /**
+     * @brief Accesses the mapped value associated with the given key (const version).
+     *
+     * @param key The key of the element to access.
+     * @return Const reference to the mapped value of the element with the specified key.
+     * @throw std::out_of_range if the key is not found.
+     */
+    const mapped_type& at(const key_type& key) const {
+        const_iterator it = find(key);
+        if (it != end()) {
+            return it->second;
+        } else {
+            throw std::out_of_range("Key not found");
+        }
+    }
+
+    /**
+     * @brief Accesses the mapped value associated with a key-like value.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value equivalent to the key of the element to access.
+     * @return Reference to the mapped value of the element with an equivalent key.
+     * @throw std::out_of_range if the key is not found.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    mapped_type& at(const K& key) {
+        iterator it = locate<iterator>(key);
+        if (it == end()) {
+            throw std::out_of_range("Key not found");
+        }
+        return it->second;
+    }
+
+    /**
+     * @brief Accesses the mapped value associated with a key-like value (const version).
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value equivalent to the key of the element to access.
+     * @return Const reference to the mapped value of the element with an equivalent key.
+     * @throw std::out_of_range if the key is not found.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    const mapped_type& at(const K& key) const {
+        const_iterator it = locate<const_iterator>(key);
+        if (it == end()) {
+            throw std::out_of_range("Key not found");
+        }
+        return it->second;
+    }
+
+    /**
+     * @brief Accesses or inserts an element with the given key.
+     *
+     * A missing element is inserted with a value-initialized value in the same probe.
+     *
+     * @param key The key of the element to access or insert.
+     * @return Reference to the mapped value of the accessed or inserted element.
+     */
+    mapped_type& operator[](const key_type& key) {
+        return try_emplace(key).first->second;
+    }
+
+    /**
+     * @brief Accesses or inserts an element with the given key (move version).
+     *
+     * @param key The key of the element to access or insert, moved from only if the insertion takes place.
+     * @return Reference to the mapped value of the accessed or inserted element.
+     */
+    mapped_type& operator[](key_type&& key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+
+    /**
+     * @brief Accesses or inserts an element with the given key (const version).
+     *
+     * @param key The key of the element to access or insert.
+     * @return Const reference to the mapped value of the accessed or inserted element.
+     * @throw std::out_of_range if the key is not found.
+     */
+    const mapped_type& operator[](const key_type& key) const {
+        const_iterator it = find(key);
+        if (it != end()) {
+            return it->second;
+        } else {
+            throw std::out_of_range("Key not found");
+        }
+    }
+
+    /**
+     * @brief Erases an element from the unordered map at a specified position.
+     *
+     * While a resize is in progress no elements are migrated, as that would move elements the
+     * caller has already iterated over into the part of the map still ahead of the returned
+     * iterator; the old table is released as soon as its last element is erased. For the same reason
+     * a Robin Hood cluster wrapping around the end of the table is not shifted back across it.
+     *
+     * @param pos Iterator pointing to the element to erase.
+     * @return Iterator following the removed element.
+     */
+    iterator erase(iterator pos) {
+        table_of(pos.ptr).erase_at(pos.index, false);
+        if (!Ctrl::is_full(pos.ctrl[pos.index])) {
+            ++pos;
+        }
+        release_drained_table();
+        return pos;
+    }
+
+    /**
+     * @brief Erases an element from the unordered map at a specified position (const version).
+     *
+     * @param pos Const iterator pointing to the element to erase.
+     * @return Const iterator following the removed element.
+     */
+    const_iterator erase(const_iterator pos) {
+        table_of(pos.ptr).erase_at(pos.index, false);
+        if (!Ctrl::is_full(pos.ctrl[pos.index])) {
+            ++pos;
+        }
+        release_drained_table();
+        return pos;
+    }
+
+    /**
+     * @brief Erases an element from the unordered map with a specified key.
+     *
+     * @param key The key of the element to erase.
+     * @return Number of elements erased (0 or 1).
+     */
+    size_type erase(const key_type& key) {
+        return erase_key(key);
+    }
+
+    /**
+     * @brief Erases an element with a key equivalent to a key-like value.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value equivalent to the key of the element to erase.
+     * @return Number of elements erased (0 or 1).
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual> && (!std::is_convertible_v<K, iterator>) && (!std::is_convertible_v<K, const_iterator>)
+    size_type erase(const K& key) {
+        return erase_key(key);
+    }
+
+    /**
+     * @brief Erases the element with a specific key whose hash the caller has already computed.
+     *
+     * @param key The key of the element to erase.
+     * @param hash The hash of the key, as returned by hash_function().
+     * @return Number of elements erased (0 or 1).
+     */
+    size_type erase(const key_type& key, std::size_t hash) {
+        return erase_key(key, capacity_policy::mix(hash));
+    }
+
+    /**
+     * @brief Erases the element with a key equivalent to a key-like value whose hash the caller has already computed.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value equivalent to the key of the element to erase.
+     * @param hash The hash of the value, as returned by hash_function().
+     * @return Number of elements erased (0 or 1).
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    size_type erase(const K& key, std::size_t hash) {
+        return erase_key(key, capacity_policy::mix(hash));
+    }
+
+    /**
+     * @brief Reserves space for a specified number of elements.
+     *
+     * @param new_capacity The new capacity of the unordered map, rounded as required by the capacity policy.
+     */
+    void reserve(size_type new_capacity) {
+        if (new_capacity <= capacity_)
+            return;
+        [[maybe_unused]] auto timer = counters_.time_rehash();
+        reallocate(capacity_policy::round(new_capacity));
+    }
+
+    /**
+     * @brief Counts the number of elements with a specific key.
+     *
+     * @param key The key of the elements to count.
+     * @return Number of elements with the specified key (0 or 1).
+     */
+    size_type count(const key_type& key) const {
+        size_type count = 0;
+        if (locate<const_iterator>(key) != end()) {
+            count = 1;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Counts the number of elements with a key equivalent to a key-like value.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value equivalent to the key of the elements to count.
+     * @return Number of elements with an equivalent key (0 or 1).
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    size_type count(const K& key) const {
+        return locate<const_iterator>(key) != end() ? 1 : 0;
+    }
+
+    /**
+     * @brief Swaps the contents of two unordered maps.
+     *
+     * @param other Another unordered map to swap with.
+     */
+    void swap(Unordered_map& other) noexcept {
+        swap_contents(other);
+        if constexpr (alloc_traits::propagate_on_container_swap::value) {
+            std::swap(alloc_, other.alloc_);
+        }
+    }
+
+    /**
+     * @brief Returns the allocator of the unordered map.
+     *
+     * @return Copy of the allocator.
+     */
+    allocator_type get_allocator() const {
+        return alloc_;
+    }
+
+    /**
+     * @brief Returns the hash function of the unordered map.
+     *
+     * Its results can be passed to the lookups taking a precomputed hash.
+     *
+     * @return Copy of the hash function.
+     */
+    hasher hash_function() const {
+        return hash_;
+    }
+
+    /**
+     * @brief Checks if the unordered map contains an element with the given key.
+     *
+     * @param key The key to search for.
+     * @return True if the unordered map contains an element with the key, false otherwise.
+     */
+    bool contains(const key_type& key) const {
+        return locate<const_iterator>(key) != end();
+    }
+
+    /**
+     * @brief Checks if the unordered map contains an element with a key equivalent to a key-like value.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value to search for.
+     * @return True if the unordered map contains an element with an equivalent key, false otherwise.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    bool contains(const K& key) const {
+        return locate<const_iterator>(key) != end();
+    }
+
+    /**
+     * @brief Counts the probes a lookup of a key makes.
+     *
+     * Counts control groups, or slots under the Robin Hood policy, including the probes of the
+     * old table while growing. Meant for measuring probing policies and hash quality.
+     *
+     * @param key The key to look up.
+     * @return Number of probes made until the key was found or known to be absent.
+     */
+    size_type probe_length(const key_type& key) const {
+        return probe_length_of(key);
+    }
+
+    /**
+     * @brief Counts the probes a lookup of a key-like value makes.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value to look up.
+     * @return Number of probes made until an equivalent key was found or known to be absent.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    size_type probe_length(const K& key) const {
+        return probe_length_of(key);
+    }
+
+    /**
+     * @brief Takes a snapshot of the statistics of the unordered map.
+     *
+     * The occupancy figures cover the old table too while growing. The probe length histograms and rehash timings are collected only under
+     * a policy that sets collect_stats, and count the operations made through this object since
+     * it was constructed.
+     *
+     * @return The statistics.
+     */
+    MapStats stats() const {
+        MapStats result;
+        counters_.collect(result);
+        result.size = size();
+        add_occupancy(result);
+        if (result.capacity != 0) {
+            result.load = static_cast<double>(result.size) / static_cast<double>(result.capacity);
+            result.effective_load = static_cast<double>(result.size + result.tombstones) / static_cast<double>(result.capacity);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Takes a copy-on-write snapshot of the elements. Available under policies that set snapshots.
+     *
+     * The snapshot shares the slots of the map and copies nothing up front, except that an
+     * incremental resize in progress is finished first. Afterwards, the first modification of
+     * each page of SnapshotPages::page_slots slots copies the elements of that page into every
+     * live snapshot, as does dereferencing a mutable iterator to an element of the page, and
+     * growing, shrinking, clearing or destroying the map copies all pages still shared. If that
+     * copy runs out of memory while clearing or destroying, the slots are left to the snapshots
+     * instead and freed with the last of them, through a copy of the allocator of the map. The
+     * snapshot must therefore not outlive the memory resource, or any other memory, that the
+     * allocator draws from. Const access copies nothing. The snapshot may be read on another thread while this thread
+     * keeps modifying the map.
+     *
+     * @return The snapshot.
+     */
+    snapshot_type snapshot() requires Policy::snapshots {
+        finish_migration();
+        return snapshots_.take(ctrl_, capacity_ == 0 ? nullptr : &array[0].value, sizeof(entry_type), capacity_, size_,
+                               [this] { return std::make_shared<Unordered_map>(hash_, alloc_); });
+    }
+
+    /**
+     * @brief Moves the elements of another unordered map whose keys are not present here into this one.
+     *
+     * Every element is moved straight from its slot in the other map into a slot prepared here,
+     * reusing its cached or recomputed hash unless the maps hash differently, as two maps with
+     * differently seeded hash functions do. Elements whose keys are already present stay in the
+     * other map.
+     *
+     * @param other Another unordered map to merge with.
+     */
+    void merge(Unordered_map& other) {
+        if (&other == this) {
+            return;
+        }
+        other.finish_migration();
+        bool same_hash = hashes_like(other);
+        for (size_type i = 0; i < other.capacity_ && other.size_ != 0;) {
+            if (!Ctrl::is_full(other.ctrl_[i])) {
+                ++i;
+                continue;
+            }
+            const key_type& key = other.array[i].value.first;
+            auto [index, inserted] = find_or_prepare_insert(key, same_hash ? other.stored_hash(i) : hash_of(key));
+            if (!inserted) {
+                ++i;
+                continue;
+            }
+            other.snapshots_.preserve(i);
+            construct(index, std::move(other.array[i].value));
+            // A Robin Hood backward shift may refill slot i, so it is visited again.
+            other.erase_at(i);
+        }
+    }
+
+    /**
+     * @brief Moves the elements of another unordered map whose keys are not present here into this one (rvalue version).
+     *
+     * @param other Another unordered map to merge with.
+     */
+    void merge(Unordered_map&& other) {
+        merge(other);
+    }
+
+    /**
+     * @brief Removes an element from the map and returns it in a node handle.
+     *
+     * @param pos Iterator to the element to extract.
+     * @return Node handle owning the element.
+     */
+    node_type extract(const_iterator pos) {
+        Unordered_map& table = table_of(pos.ptr);
+        table.snapshots_.preserve(pos.index);
+        node_type node(alloc_, std::move(table.array[pos.index].value));
+        table.erase_at(pos.index);
+        release_drained_table();
+        return node;
+    }
+
+    /**
+     * @brief Removes an element from the map and returns it in a node handle (non-const iterator version).
+     *
+     * @param pos Iterator to the element to extract.
+     * @return Node handle owning the element.
+     */
+    node_type extract(iterator pos) {
+        return extract(const_iterator(pos));
+    }
+
+    /**
+     * @brief Removes the element with a specific key from the map and returns it in a node handle.
+     *
+     * @param key The key of the element to extract.
+     * @return Node handle owning the element, or an empty handle if the key is not present.
+     */
+    node_type extract(const key_type& key) {
+        return extract_key(key);
+    }
+
+    /**
+     * @brief Removes the element with a key equivalent to a key-like value and returns it in a node handle.
+     *
+     * @tparam K Type of the key-like value.
+     * @param key The value equivalent to the key of the element to extract.
+     * @return Node handle owning the element, or an empty handle if no equivalent key is present.
+     */
+    template<class K>
+    requires TransparentLookup<Hash, KeyEqual>
+    node_type extract(const K& key) {
+        return extract_key(key);
+    }
+
+    /**
+     * @brief Inserts the element owned by a node handle if its key is not present yet.
+     *
+     * The element is moved from the handle into its slot, so neither key nor value is copied
+     * as long as the allocators of the handle and the map compare equal.
+     *
+     * @param node The node handle, left empty if the insertion takes place.
+     * @return The position of the element with the key, whether the insertion took place and,
+     *         if it did not, the node handle.
+     */
+    insert_return_type insert(node_type&& node) {
+        if (node.empty()) {
+            return {end(), false, node_type()};
+        }
+        auto [index, inserted] = find_or_prepare_insert(node.key());
+        iterator position = with_snapshots(iterator(ctrl_, array, index, capacity_));
+        if (!inserted) {
+            return {position, false, std::move(node)};
+        }
+        construct(index, std::move(node.value));
+        node.reset();
+        return {position, true, node_type()};
+    }
+
+    /**
+     * @brief Writes the hash table to a file that load() brings back without rehashing.
+     *
+     * The file holds the control bytes, the Robin Hood distances and the hash function state as
+     * they are in memory, so every element keeps its slot. If keys and values are trivially
+     * copyable, the slot array is written as it is too; otherwise every element is encoded with
+     * MapCodec, in slot order. A table in the middle of an incremental resize is saved as if the
+     * resize had finished. The file is only readable by a build with the same map type and
+     * control group width on a machine of the same byte order.
+     *
+     * @param path Path of the file, replaced if it exists.
+     * @throw std::system_error if the file cannot be written.
+     */
+    void save(const std::string& path) const {
+        static_assert(std::is_trivially_copyable_v<Hash>, "Unordered_map files store the hash function byte for byte");
+        if (old_) {
+            Unordered_map copy(*this);
+            copy.finish_migration();
+            copy.save(path);
+            return;
+        }
+        MapFileHeader header;
+        header.layout = layout_id();
+        header.flags = raw_entries ? MapFileHeader::raw_entries : 0;
+        header.max_load = max_load;
+        header.min_load = min_load;
+        header.hash_bytes = std::is_empty_v<Hash> ? 0 : sizeof(Hash);
+        header.size = size_;
+        header.capacity = capacity_;
+        header.tombstones = tombstones_;
+        header.hash_offset = MapFileHeader::align(sizeof(MapFileHeader));
+        header.ctrl_offset = MapFileHeader::align(header.hash_offset + header.hash_bytes);
+        header.entries_offset = MapFileHeader::align(header.ctrl_offset + (capacity_ == 0 ? 0 : ctrl_bytes(capacity_)));
+        if constexpr (Policy::robin_hood) {
+            header.dist_offset = header.entries_offset;
+            header.entries_offset = MapFileHeader::align(header.dist_offset + capacity_ * sizeof(std::uint16_t));
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        auto pad_to = [&out](std::uint64_t offset) {
+            static constexpr char zeros[64] = {};
+            out.write(zeros, static_cast<std::streamsize>(offset - static_cast<std::uint64_t>(out.tellp())));
+        };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pad_to(header.hash_offset);
+        out.write(reinterpret_cast<const char*>(&hash_), header.hash_bytes);
+        if (capacity_ != 0) {
+            pad_to(header.ctrl_offset);
+            out.write(reinterpret_cast<const char*>(ctrl_), static_cast<std::streamsize>(ctrl_bytes(capacity_)));
+            if constexpr (Policy::robin_hood) {
+                pad_to(header.dist_offset);
+                out.write(reinterpret_cast<const char*>(dist_), static_cast<std::streamsize>(capacity_ * sizeof(std::uint16_t)));
+            }
+            pad_to(header.entries_offset);
+            write_entries(out);
+        }
+        header.file_size = static_cast<std::uint64_t>(out.tellp());
+        header.entries_bytes = header.file_size - header.entries_offset;
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+        if (!out) {
+            throw std::system_error(std::make_error_code(std::errc::io_error), "Cannot write " + path);
+        }
+    }
+
+    /**
+     * @brief Loads a hash table written by save().
+     *
+     * The file is mapped into memory. If keys and values are trivially copyable, the table takes
+     * the mapping as its storage: loading costs a few system calls whatever the size, pages are
+     * read as lookups touch them, and modifications copy the pages they write, leaving the file
+     * untouched. Otherwise the control bytes are copied and every element is decoded straight
+     * into the slot it was saved in, without hashing any key.
+     *
+     * Beyond the header, the file is trusted to be one written by save().
+     *
+     * @param path Path of the file.
+     * @param alloc The allocator for all memory of the map.
+     * @return The loaded map.
+     * @throw std::system_error if the file cannot be mapped.
+     * @throw std::runtime_error if the file is not a map of this type.
+     */
+    static Unordered_map load(const std::string& path, const Allocator& alloc = Allocator()) {
+        static_assert(std::is_trivially_copyable_v<Hash>, "Unordered_map files store the hash function byte for byte");
+        auto file = std::make_unique<MappedFile>(path);
+        MapFileHeader header;
+        if (file->size() < sizeof(header)) {
+            throw std::runtime_error("Unordered_map file is truncated");
+        }
+        std::memcpy(&header, file->data(), sizeof(header));
+        check_header(header, file->size());
+
+        Unordered_map map(alloc);
+        std::memcpy(static_cast<void*>(&map.hash_), file->data() + header.hash_offset, header.hash_bytes);
+        map.max_load = header.max_load;
+        map.min_load = header.min_load;
+        if (header.capacity == 0) {
+            return map;
+        }
+        if constexpr (raw_entries) {
+            map.ctrl_ = reinterpret_cast<std::int8_t*>(file->data() + header.ctrl_offset);
+            map.array = reinterpret_cast<entry_type*>(file->data() + header.entries_offset);
+            if constexpr (Policy::robin_hood) {
+                map.dist_ = reinterpret_cast<std::uint16_t*>(file->data() + header.dist_offset);
+            }
+            map.mapping_ = std::move(file);
+            map.capacity_ = header.capacity;
+        } else {
+            const char* base = file->data();
+            map.allocate(header.capacity);
+            std::memcpy(map.ctrl_, base + header.ctrl_offset, ctrl_bytes(map.capacity_));
+            if constexpr (Policy::robin_hood) {
+                std::memcpy(map.dist_, base + header.dist_offset, map.capacity_ * sizeof(std::uint16_t));
+            }
+            map.read_entries(base + header.entries_offset, base + header.file_size, header.size);
+        }
+        map.size_ = header.size;
+        map.tombstones_ = header.tombstones;
+        return map;
+    }
+
+private:
+
+    std::size_t size_ = 0; /**< Number of elements in the unordered map. */
+    std::size_t capacity_ = 0; /**< Capacity of the hash table. */
+    std::size_t tombstones_ = 0; /**< Number of slots marked as deleted, which probing treats as occupied. */
+    float max_load = 0.8f; /**< Maximum load factor before rehashing. */
+    float min_load = 0.0f; /**< Load factor below which erasing by key shrinks the table, 0 to never shrink. */
+    std::int8_t* ctrl_ = nullptr; /**< Control bytes of the hash table, followed by a copy of the first ControlGroup::width - 1 bytes. */
+    entry_type* array = nullptr; /**< Array of hash table entries. */
+    std::uint16_t* dist_ = nullptr; /**< Distance of every occupied slot from its home slot (Robin Hood policy only). */
+    std::unique_ptr<MappedFile> mapping_; /**< File holding the storage of a table mapped by load(), null if the storage was allocated. */
+    std::unique_ptr<Unordered_map> old_; /**< Table being drained into this one while growing (incremental resize policy only). */
+    size_type migrated_ = 0; /**< Slot of the old table below which every element has been migrated. */
+    [[no_unique_address]] Allocator alloc_; /**< Allocator of the elements and, rebound, of the arrays. */
+    [[no_unique_address]] Hash hash_; /**< Hash function of the keys, shared with the old table while growing. */
+    [[no_unique_address]] MapStatsCounters<Policy::collect_stats> counters_; /**< Operation counters, empty unless the policy collects statistics. */
+    [[no_unique_address]] MapSnapshots<value_type, Policy::snapshots> snapshots_; /**< Snapshots sharing the slots, empty unless the policy supports them. */
+
+    using alloc_traits = std::allocator_traits<Allocator>; /**< Traits of the element allocator. */
+
+    static constexpr bool raw_entries = std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<T>; /**< Whether saved files hold the slot array byte for byte. */
+    static constexpr size_type batch_size = 16; /**< Number of keys hashed and prefetched ahead by the batch operations. */
+    static constexpr size_type cuckoo_bucket = 4; /**< Number of slots in a bucket of the cuckoo policy. */
+    static constexpr size_type cuckoo_search_limit = 256; /**< Number of buckets the cuckoo insertion search examines before the table grows. */
+    static constexpr size_type cuckoo_max_growths = 4; /**< Number of growths in a row after which a cuckoo insertion gives up. */
+
+    /**
+     * @brief Allocates an uninitialized array through the allocator rebound to its element type.
+     *
+     * @tparam U Type of the array elements.
+     * @param count Number of elements.
+     * @return Pointer to the array.
+     */
+    template<class U>
+    U* allocate_array(size_type count) {
+        typename alloc_traits::template rebind_alloc<U> alloc(alloc_);
+        return std::allocator_traits<decltype(alloc)>::allocate(alloc, count);
+    }
+
+    /**
+     * @brief Returns an array obtained from allocate_array.
+     *
+     * @tparam U Type of the array elements.
+     * @param p Pointer to the array, may be null.
+     * @param count Number of elements.
+     */
+    template<class U>
+    void deallocate_array(U* p, size_type count) {
+        if (p != nullptr) {
+            typename alloc_traits::template rebind_alloc<U> alloc(alloc_);
+            std::allocator_traits<decltype(alloc)>::deallocate(alloc, p, count);
+        }
+    }
+
+    /**
+     * @brief Computes the hash of a key as used for probing.
+     *
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key to hash.
+     * @return The hash of the key post-processed by the capacity policy.
+     */
+    template<class K>
+    std::size_t hash_of(const K& key) const {
+        return capacity_policy::mix(hash_(key));
+    }
+
+    /**
+     * @brief Checks if another map hashes every key to the same value as this one.
+     *
+     * @param other Another unordered map.
+     * @return True if the hash functions are stateless or compare equal, false otherwise.
+     */
+    bool hashes_like(const Unordered_map& other) const {
+        if constexpr (std::is_empty_v<Hash>) {
+            return true;
+        } else if constexpr (std::equality_comparable<Hash>) {
+            return hash_ == other.hash_;
+        } else {
+            return false;
+        }
+    }
+
+    /**
+     * @brief Returns the hash of the key stored in an occupied slot.
+     *
+     * @param index Index of the slot.
+     * @return The cached hash under the stored hash policy, the recomputed hash otherwise.
+     */
+    std::size_t stored_hash(size_type index) const {
+        if constexpr (Policy::store_hash) {
+            return array[index].hash;
+        } else {
+            return hash_of(array[index].value.first);
+        }
+    }
+
+    /**
+     * @brief Checks if the hash cached in an occupied slot can belong to a key.
+     *
+     * @param index Index of the slot.
+     * @param hash The hash of the key.
+     * @return False if the cached hash differs, true otherwise or if hashes are not cached.
+     */
+    bool hash_matches(size_type index, std::size_t hash) const {
+        if constexpr (Policy::store_hash) {
+            return array[index].hash == hash;
+        } else {
+            return true;
+        }
+    }
+
+    /**
+     * @brief Starts loading the home slot of a hash into the cache.
+     *
+     * Prefetches the control bytes, the entry and, under the Robin Hood policy, the distance of
+     * the slot, so probing for the key shortly afterwards does not stall on memory. Under the
+     * cuckoo policy both buckets of the hash are prefetched.
+     *
+     * @param hash The hash of a key as returned by hash_of.
+     */
+    void prefetch_home(std::size_t hash) const {
+        if (capacity_ == 0) {
+            return;
+        }
+        size_type pos = capacity_policy::index(hash, capacity_);
+#if defined(__GNUC__) || defined(__clang__)
+        if constexpr (Policy::cuckoo) {
+            auto [first, second] = cuckoo_buckets(hash);
+            __builtin_prefetch(ctrl_ + first);
+            __builtin_prefetch(array + first);
+            __builtin_prefetch(ctrl_ + second);
+            __builtin_prefetch(array + second);
+            return;
+        }
+        __builtin_prefetch(ctrl_ + pos);
+        __builtin_prefetch(array + pos);
+        if constexpr (Policy::robin_hood) {
+            __builtin_prefetch(dist_ + pos);
+        }
+#endif
+    }
+
+    /**
+     * @brief Adds the slots, tombstones and bytes of this table and of the old table to a snapshot.
+     *
+     * @param stats The snapshot.
+     */
+    void add_occupancy(MapStats& stats) const {
+        if (capacity_ != 0) {
+            stats.capacity += capacity_;
+            stats.tombstones += tombstones_;
+            stats.bytes_allocated += ctrl_bytes(capacity_) + capacity_ * sizeof(entry_type);
+            if constexpr (Policy::robin_hood) {
+                stats.bytes_allocated += capacity_ * sizeof(std::uint16_t);
+            }
+        }
+        if (old_) {
+            old_->add_occupancy(stats);
+        }
+    }
+
+    /**
+     * @brief Computes the smallest capacity supported by the capacity policy that holds a number of elements under a load factor.
+     *
+     * @param count Number of elements.
+     * @param load The load factor.
+     * @return The capacity, at least 1, and at least two buckets under the cuckoo policy as allocate() makes it.
+     */
+    static size_type fitting_capacity(size_type count, float load) {
+        size_type capacity = capacity_policy::round(static_cast<size_type>(static_cast<double>(count) / load) + 1);
+        if constexpr (Policy::cuckoo) {
+            capacity = std::max(capacity, 2 * cuckoo_bucket);
+        }
+        return capacity;
+    }
+
+    /**
+     * @brief Identifies the map type in saved files: its name, its entry size and the control group width.
+     *
+     * @return FNV-1a hash of the three.
+     */
+    static std::uint64_t layout_id() {
+        std::uint64_t id = 0xcbf29ce484222325ull;
+        for (const char* c = typeid(Unordered_map).name(); *c != '\0'; ++c) {
+            id = (id ^ static_cast<unsigned char>(*c)) * 0x100000001b3ull;
+        }
+        id = (id ^ sizeof(entry_type)) * 0x100000001b3ull;
+        return (id ^ ControlGroup::width) * 0x100000001b3ull;
+    }
+
+    /**
+     * @brief Checks that a file header describes a complete map of this type.
+     *
+     * @param header The header.
+     * @param file_size Size of the file.
+     * @throw std::runtime_error if it does not.
+     */
+    static void check_header(const MapFileHeader& header, std::size_t file_size) {
+        if (header.magic != MapFileHeader::magic_value || header.version != MapFileHeader::version_value ||
+            header.byte_order != MapFileHeader::byte_order_value) {
+            throw std::runtime_error("Not an Unordered_map file");
+        }
+        if (header.layout != layout_id() || header.flags != (raw_entries ? MapFileHeader::raw_entries : 0u) ||
+            header.hash_bytes != (std::is_empty_v<Hash> ? 0 : sizeof(Hash))) {
+            throw std::runtime_error("Unordered_map file holds a map of another type");
+        }
+        if (header.file_size != file_size) {
+            throw std::runtime_error("Unordered_map file is truncated");
+        }
+        if (header.capacity == 0) {
+            if (header.size != 0) {
+                throw std::runtime_error("Unordered_map file is corrupt");
+            }
+            return;
+        }
+        std::uint64_t slots_end = header.entries_offset + (raw_entries ? header.capacity * sizeof(entry_type) : 0);
+        bool fits = header.hash_offset + header.hash_bytes <= file_size &&
+                    header.ctrl_offset + ctrl_bytes(header.capacity) <= file_size &&
+                    (!Policy::robin_hood || header.dist_offset + header.capacity * sizeof(std::uint16_t) <= file_size) &&
+                    header.entries_offset <= file_size && slots_end <= file_size;
+        if (!fits || header.capacity != capacity_policy::round(header.capacity) || header.size > header.capacity ||
+            header.capacity > std::numeric_limits<size_type>::max() / sizeof(entry_type) ||
+            header.entries_offset % alignof(entry_type) != 0) {
+            throw std::runtime_error("Unordered_map file is corrupt");
+        }
+    }
+
+    /**
+     * @brief Writes the entry section of a saved table.
+     *
+     * Raw entries are written in chunks of the slot array, free slots zeroed; otherwise every
+     * element is encoded in slot order, preceded by its cached hash under the stored hash policy.
+     *
+     * @param out The stream, positioned at the start of the section.
+     */
+    void write_entries(std::ostream& out) const {
+        if constexpr (raw_entries) {
+            constexpr size_type chunk_slots = 4096;
+            std::vector<char> chunk(chunk_slots * sizeof(entry_type));
+            for (size_type first = 0; first < capacity_; first += chunk_slots) {
+                size_type count = std::min(chunk_slots, capacity_ - first);
+                for (size_type i = 0; i < count; ++i) {
+                    char* slot = chunk.data() + i * sizeof(entry_type);
+                    if (Ctrl::is_full(ctrl_[first + i])) {
+                        std::memcpy(slot, static_cast<const void*>(&array[first + i]), sizeof(entry_type));
+                    } else {
+                        std::memset(slot, 0, sizeof(entry_type));
+                    }
+                }
+                out.write(chunk.data(), static_cast<std::streamsize>(count * sizeof(entry_type)));
+            }
+        } else {
+            for (size_type i = 0; i < capacity_; ++i) {
+                if (Ctrl::is_full(ctrl_[i])) {
+                    if constexpr (Policy::store_hash) {
+                        MapCodec<std::uint64_t>::write(out, array[i].hash);
+                    }
+                    MapCodec<Key>::write(out, array[i].value.first);
+                    MapCodec<T>::write(out, array[i].value.second);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Decodes the elements of a saved table into the slots its control bytes mark as full.
+     *
+     * @param pos Start of the entry section.
+     * @param end End of the file.
+     * @param count Number of elements the file holds.
+     * @throw std::runtime_error if the section does not hold that many; the storage is released then.
+     */
+    void read_entries(const char* pos, const char* end, size_type count) {
+        size_type i = 0;
+        size_type decoded = 0;
+        try {
+            for (; i < capacity_; ++i) {
+                if (Ctrl::is_full(ctrl_[i])) {
+                    if constexpr (Policy::store_hash) {
+                        array[i].hash = MapCodec<std::uint64_t>::read(pos, end);
+                    }
+                    Key key = MapCodec<Key>::read(pos, end);
+                    alloc_traits::construct(alloc_, &array[i].value, std::move(key), MapCodec<T>::read(pos, end));
+                    ++decoded;
+                }
+            }
+            if (decoded != count) {
+                throw std::runtime_error("Unordered_map file is corrupt");
+            }
+        } catch (...) {
+            destroy_values(i);
+            release();
+            throw;
+        }
+    }
+
+    /**
+     * @brief Computes the length of the control byte array for a given capacity.
+     *
+     * The trailing cloned bytes let a group be loaded at any slot without wrapping.
+     *
+     * @param capacity The capacity of the hash table.
+     * @return Number of control bytes.
+     */
+    static size_type ctrl_bytes(size_type capacity) {
+        return capacity + ControlGroup::width - 1;
+    }
+
+    /**
+     * @brief Allocates empty storage for the hash table.
+     *
+     * @param capacity The capacity of the hash table, raised to two buckets under the cuckoo policy.
+     */
+    void allocate(size_type capacity) {
+        if constexpr (Policy::cuckoo) {
+            capacity = std::max(capacity, 2 * cuckoo_bucket);
+        }
+        ctrl_ = allocate_array<std::int8_t>(ctrl_bytes(capacity));
+        std::fill(ctrl_, ctrl_ + ctrl_bytes(capacity), Ctrl::empty);
+        array = allocate_array<entry_type>(capacity);
+        std::uninitialized_default_construct_n(array, capacity);
+        if constexpr (Policy::robin_hood) {
+            dist_ = allocate_array<std::uint16_t>(capacity);
+            std::fill(dist_, dist_ + capacity, 0);
+        }
+        capacity_ = capacity;
+        tombstones_ = 0;
+    }
+
+    /**
+     * @brief Destroys the elements of the hash table, then releases its storage.
+     *
+     * Live snapshots copy their remaining pages first. Should a copy throw, the storage, elements
+     * included, is handed over to the empty table the snapshots share instead, which frees it
+     * once the last of them is gone, so this never throws.
+     */
+    void deallocate() noexcept {
+        if (snapshots_.active()) {
+            try {
+                snapshots_.detach();
+            } catch (...) {
+                std::shared_ptr<Unordered_map> heir = std::static_pointer_cast<Unordered_map>(snapshots_.hand_over());
+                swap_storage(*heir);
+                return;
+            }
+        }
+        if (size_ != 0) {
+            destroy_values(capacity_);
+        }
+        release();
+    }
+
+    /**
+     * @brief Releases the storage of the hash table without destroying any element.
+     *
+     * Storage mapped by load() is unmapped rather than returned to the allocator.
+     */
+    void release() noexcept {
+        if (mapping_) {
+            mapping_.reset();
+        } else {
+            if (array != nullptr) {
+                std::destroy_n(array, capacity_);
+            }
+            deallocate_array(ctrl_, ctrl_bytes(capacity_));
+            deallocate_array(array, capacity_);
+            deallocate_array(dist_, capacity_);
+        }
+        ctrl_ = nullptr;
+        array = nullptr;
+        dist_ = nullptr;
+        capacity_ = 0;
+        tombstones_ = 0;
+    }
+
+    /**
+     * @brief Destroys the elements stored in the slots below a given index.
+     *
+     * @param end Index of the first slot left alone.
+     */
+    void destroy_values(size_type end) {
+        if constexpr (!std::is_trivially_destructible_v<value_type>) {
+            for (size_type i = 0; i < end; ++i) {
+                if (Ctrl::is_full(ctrl_[i])) {
+                    alloc_traits::destroy(alloc_, &array[i].value);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Copies the page of an entry into the live snapshots if the entry is one of the slots of this table.
+     *
+     * @param entry The entry about to be modified.
+     */
+    void preserve_entry(const entry_type& entry) const {
+        std::less<const entry_type*> less;
+        if (!less(&entry, array) && less(&entry, array + capacity_)) {
+            snapshots_.preserve(static_cast<size_type>(&entry - array));
+        }
+    }
+
+    /**
+     * @brief Moves an element into an unconstructed entry and destroys the source.
+     *
+     * @param to The entry to construct.
+     * @param from The entry to move from and destroy.
+     */
+    void relocate(entry_type& to, entry_type& from) {
+        if (snapshots_.active()) {
+            preserve_entry(to);
+            preserve_entry(from);
+        }
+        alloc_traits::construct(alloc_, &to.value, std::move(from.value));
+        alloc_traits::destroy(alloc_, &from.value);
+        if constexpr (Policy::store_hash) {
+            to.hash = from.hash;
+        }
+    }
+
+    /**
+     * @brief Constructs the element of a slot prepared by find_or_prepare_insert.
+     *
+     * If the constructor throws, the slot is released again.
+     *
+     * @tparam Args Types of the constructor arguments.
+     * @param index Index of the prepared slot.
+     * @param args Arguments for the constructor of value_type.
+     */
+    template<typename... Args>
+    void construct(size_type index, Args&&... args) {
+        snapshots_.preserve(index);
+        try {
+            alloc_traits::construct(alloc_, &array[index].value, std::forward<Args>(args)...);
+        } catch (...) {
+            vacate(index);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Swaps everything but the allocators of two unordered maps, hash functions included.
+     *
+     * @param other Another unordered map to swap with.
+     */
+    void swap_contents(Unordered_map& other) noexcept {
+        swap_storage(other);
+        std::swap(max_load, other.max_load);
+        std::swap(min_load, other.min_load);
+        std::swap(old_, other.old_);
+        std::swap(migrated_, other.migrated_);
+        std::swap(hash_, other.hash_);
+    }
+
+    /**
+     * @brief Swaps the storage of two hash tables, leaving the options and migration state in place.
+     *
+     * @param other Another hash table to swap storage with.
+     */
+    void swap_storage(Unordered_map& other) noexcept {
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(tombstones_, other.tombstones_);
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(array, other.array);
+        std::swap(dist_, other.dist_);
+        std::swap(mapping_, other.mapping_);
+        snapshots_.swap(other.snapshots_);
+    }
+
+    /**
+     * @brief Returns the table owning an entry array, either this one or the old table being drained.
+     *
+     * @param entries Pointer to the entries of one of the tables.
+     * @return Reference to the owning table.
+     */
+    Unordered_map& table_of(const entry_type* entries) {
+        return old_ && entries == old_->array ? *old_ : *this;
+    }
+
+    /**
+     * @brief Sets the control byte of a slot and its cloned copies.
+     *
+     * @param index Index of the slot.
+     * @param c The new control byte.
+     */
+    void set_ctrl(size_type index, std::int8_t c) {
+        snapshots_.preserve(index);
+        ctrl_[index] = c;
+        for (size_type clone = index; clone < ControlGroup::width - 1; clone += capacity_) {
+            ctrl_[capacity_ + clone] = c;
+        }
+    }
+
+    /**
+     * @brief Opens a slot for insertion at a given point of a Robin Hood probe sequence.
+     *
+     * The run of elements starting at the slot is shifted by one slot towards the next empty slot,
+     * which keeps every cluster ordered by home slot.
+     *
+     * @param index Index of the first slot whose element is closer to its home slot than the new one.
+     * @param distance Distance of the slot from the home slot of the new element.
+     * @return Index of the opened slot.
+     * @throw std::length_error if a distance no longer fits into the distance array.
+     */
+    size_type shift_for_insert(size_type index, size_type distance) {
+        size_type last = index;
+        while (Ctrl::is_full(ctrl_[last])) {
+            last = capacity_policy::wrap(last + 1, capacity_);
+        }
+        while (last != index) {
+            size_type prev = (last == 0 ? capacity_ : last) - 1;
+            if (dist_[prev] == std::numeric_limits<std::uint16_t>::max()) {
+                throw std::length_error("Unordered_map probe sequence is too long");
+            }
+            relocate(array[last], array[prev]);
+            set_ctrl(last, ctrl_[prev]);
+            dist_[last] = dist_[prev] + 1;
+            last = prev;
+        }
+        if (distance > std::numeric_limits<std::uint16_t>::max()) {
+            throw std::length_error("Unordered_map probe sequence is too long");
+        }
+        dist_[index] = static_cast<std::uint16_t>(distance);
+        return index;
+    }
+
+    /**
+     * @brief Finds a slot free for insertion on the probe sequence of a hash.
+     *
+     * Under the Robin Hood policy the slot is opened by shifting the elements that follow it, and
+     * under the cuckoo policy by moving elements to their other buckets.
+     *
+     * @param hash The hash of the key to insert.
+     * @return Index of the free slot, or capacity_ if the table is full.
+     */
+    size_type find_insert_slot(std::size_t hash) {
+        size_type pos = capacity_policy::index(hash, capacity_);
+        if constexpr (Policy::cuckoo) {
+            return cuckoo_insert_slot(hash);
+        } else if constexpr (Policy::robin_hood) {
+            if (size_ == capacity_) {
+                return capacity_;
+            }
+            if (tombstones_ != 0) {
+                close_wrapped_gaps();
+            }
+            size_type distance = 0;
+            while (Ctrl::is_full(ctrl_[pos]) && dist_[pos] >= distance) {
+                pos = capacity_policy::wrap(pos + 1, capacity_);
+                ++distance;
+            }
+            return shift_for_insert(pos, distance);
+        } else {
+            for (size_type probe = 0, limit = probe_limit(); probe < limit; ++probe) {
+                auto free = ControlGroup(ctrl_ + pos).match_empty_or_deleted();
+                if (free) {
+                    return capacity_policy::wrap(pos + free.lowest(), capacity_);
+                }
+                pos = next_probe(pos, probe, hash);
+            }
+            return capacity_;
+        }
+    }
+
+    /**
+     * @brief Finds the slot of a key, or prepares a slot for inserting it.
+     *
+     * A prepared slot is already marked as occupied and counted in the size, so the caller
+     * must store the element in it.
+     *
+     * @param key The key to search for.
+     * @return Pair with the index of the slot and a bool indicating whether a slot was prepared for insertion.
+     */
+    std::pair<size_type, bool> find_or_prepare_insert(const key_type& key) {
+        return find_or_prepare_insert(key, hash_of(key));
+    }
+
+    /**
+     * @brief Finds the slot of a key with a precomputed hash, or prepares a slot for inserting it.
+     *
+     * Tombstones count towards the maximum load, as probing passes over them like over elements.
+     * When the limit is reached and the elements alone fill at most seven eighths of it, the
+     * tombstones are cleared by rehashing in place instead of growing the table.
+     *
+     * @param key The key to search for.
+     * @param hash The hash of the key as returned by hash_of.
+     * @return Pair with the index of the slot and a bool indicating whether a slot was prepared for insertion.
+     */
+    std::pair<size_type, bool> find_or_prepare_insert(const key_type& key, std::size_t hash) {
+        migrate_step();
+        std::int8_t h2 = Ctrl::h2(hash);
+        size_type target = capacity_;
+        size_type distance = 0;
+        size_type probes = 0;
+        if (capacity_ != 0) {
+            size_type pos = capacity_policy::index(hash, capacity_);
+            if constexpr (Policy::cuckoo) {
+                auto [first, second] = cuckoo_buckets(hash);
+                for (size_type bucket : {first, second}) {
+                    ++probes;
+                    for (size_type idx = bucket; idx < bucket + cuckoo_bucket; ++idx) {
+                        if (ctrl_[idx] == h2 && hash_matches(idx, hash) && key_equal{}(array[idx].value.first, key)) {
+                            counters_.record_insert(probes);
+                            snapshots_.preserve(idx);
+                            return {idx, false};
+                        }
+                        if (target == capacity_ && !Ctrl::is_full(ctrl_[idx])) {
+                            target = idx;
+                        }
+                    }
+                }
+                if (target == capacity_ && size() + 1 <= max_load * capacity_) {
+                    target = cuckoo_insert_slot(hash);
+                }
+            } else if constexpr (Policy::robin_hood) {
+                while (true) {
+                    ++probes;
+                    if (ctrl_[pos] == Ctrl::empty || (Ctrl::is_full(ctrl_[pos]) && dist_[pos] < distance)) {
+                        target = pos;
+                        break;
+                    }
+                    if (ctrl_[pos] == h2 && hash_matches(pos, hash) && key_equal{}(array[pos].value.first, key)) {
+                        counters_.record_insert(probes);
+                        snapshots_.preserve(pos);
+                        return {pos, false};
+                    }
+                    pos = capacity_policy::wrap(pos + 1, capacity_);
+                    ++distance;
+                }
+            } else {
+                for (size_type probe = 0, limit = probe_limit(); probe < limit; ++probe) {
+                    ++probes;
+                    ControlGroup group(ctrl_ + pos);
+                    for (unsigned offset : group.match(h2)) {
+                        size_type idx = capacity_policy::wrap(pos + offset, capacity_);
+                        if (hash_matches(idx, hash) && key_equal{}(array[idx].value.first, key)) {
+                            counters_.record_insert(probes);
+                            snapshots_.preserve(idx);
+                            return {idx, false};
+                        }
+                    }
+                    if (target == capacity_) {
+                        auto free = group.match_empty_or_deleted();
+                        if (free) {
+                            target = capacity_policy::wrap(pos + free.lowest(), capacity_);
+                        }
+                    }
+                    if (group.match_empty()) {
+                        break;
+                    }
+                    pos = next_probe(pos, probe, hash);
+                }
+            }
+        }
+        if (old_) {
+            auto [old_index, old_probes] = old_->probe_index(key, hash);
+            probes += old_probes;
+            if (old_index != old_->capacity_) {
+                counters_.record_insert(probes);
+                return {migrate_slot(old_index), false};
+            }
+        }
+        counters_.record_insert(probes);
+        if constexpr (Policy::robin_hood) {
+            if (tombstones_ != 0) {
+                close_wrapped_gaps();
+                target = capacity_policy::index(hash, capacity_);
+                for (distance = 0; Ctrl::is_full(ctrl_[target]) && dist_[target] >= distance; ++distance) {
+                    target = capacity_policy::wrap(target + 1, capacity_);
+                }
+            }
+        }
+        bool reuses_tombstone = target != capacity_ && ctrl_[target] == Ctrl::deleted;
+        if (target == capacity_ || size() + tombstones_ + !reuses_tombstone > max_load * capacity_ || size_ == capacity_) {
+            if (tombstones_ != 0 && !old_ && (size_ + 1) * 8 <= max_load * capacity_ * 7) {
+                [[maybe_unused]] auto timer = counters_.time_rehash();
+                drop_tombstones();
+            } else {
+                rehash();
+            }
+            target = find_insert_slot(hash);
+            if constexpr (Policy::cuckoo) {
+                for (size_type growths = 1; target == capacity_; ++growths) {
+                    if (growths == cuckoo_max_growths) {
+                        throw std::length_error("Unordered_map cuckoo insertion found no free slot");
+                    }
+                    rehash();
+                    target = find_insert_slot(hash);
+                }
+            }
+        } else if constexpr (Policy::robin_hood) {
+            target = shift_for_insert(target, distance);
+        }
+        occupy(target, hash);
+        return {target, true};
+    }
+
+    /**
+     * @brief Marks a slot chosen for insertion as occupied by a key with a given hash.
+     *
+     * @param index Index of the slot.
+     * @param hash The hash of the key stored in the slot.
+     */
+    void occupy(size_type index, std::size_t hash) {
+        tombstones_ -= ctrl_[index] == Ctrl::deleted;
+        set_ctrl(index, Ctrl::h2(hash));
+        if constexpr (Policy::store_hash) {
+            array[index].hash = hash;
+        }
+        ++size_;
+    }
+
+    /**
+     * @brief Erases the element with a given key from whichever table holds it.
+     *
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key of the element to erase.
+     * @return Number of elements erased (0 or 1).
+     */
+    template<class K>
+    size_type erase_key(const K& key) {
+        return erase_key(key, hash_of(key));
     }
 
     /**
-     * @brief Returns a const iterator to the end of the unordered map.
+     * @brief Erases a key whose hash is known from whichever table holds it.
      *
-     * @return Const iterator to the end.
+     * The table shrinks afterwards if its load fell below the minimum load factor.
+     *
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key of the element to erase.
+     * @param hash The hash of the key as returned by hash_of.
+     * @return Number of elements erased (0 or 1).
      */
-    const_iterator end() const {
-        return const_iterator(array, capacity_, capacity_);
+    template<class K>
+    size_type erase_key(const K& key, std::size_t hash) {
+        migrate_step();
+        iterator it = locate<iterator>(key, hash, true);
+        if (it == end()) {
+            return 0;
+        }
+        table_of(it.ptr).erase_at(it.index);
+        shrink_if_underloaded();
+        return 1;
     }
 
     /**
-     * @brief Returns the number of elements in the unordered map.
+     * @brief Extracts the element with a given key from whichever table holds it.
      *
-     * @return Number of elements in the unordered map.
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key of the element to extract.
+     * @return Node handle owning the element, or an empty handle if the key is not present.
      */
-    size_type size() const {
-        return size_;
+    template<class K>
+    node_type extract_key(const K& key) {
+        migrate_step();
+        const_iterator it = locate<const_iterator>(key, true);
+        if (it == end()) {
+            return node_type();
+        }
+        node_type node = extract(it);
+        shrink_if_underloaded();
+        return node;
     }
 
     /**
-     * @brief Returns the number of elements that the unordered map can hold.
+     * @brief Moves an element of the old table into this one.
      *
-     * @return Capacity of the unordered map.
+     * @param old_index Index of the element in the old table.
+     * @return Index of the element in this table.
      */
-    size_type capacity() const {
-        return capacity_;
+    size_type migrate_slot(size_type old_index) {
+        std::size_t hash = old_->stored_hash(old_index);
+        size_type index = find_insert_slot(hash);
+        relocate(array[index], old_->array[old_index]);
+        occupy(index, hash);
+        old_->vacate(old_index);
+        return index;
     }
 
     /**
-     * @brief Returns the maximum number of elements the unordered map can hold.
+     * @brief Migrates the next Policy::resize_step slots of the old table, releasing it once drained.
      *
-     * @return Maximum size of the unordered map.
+     * Slots are visited in order. A slot refilled by a Robin Hood backward shift is visited again.
      */
-    size_type max_size() const {
-        return std::numeric_limits<size_type>::max();
+    void migrate_step() {
+        if constexpr (Policy::resize_step != 0) {
+            if (!old_) {
+                return;
+            }
+            for (size_type budget = Policy::resize_step; budget != 0 && migrated_ < old_->capacity_; --budget) {
+                if (Ctrl::is_full(old_->ctrl_[migrated_])) {
+                    migrate_slot(migrated_);
+                } else {
+                    ++migrated_;
+                }
+            }
+            release_drained_table();
+        }
     }
 
     /**
-     * @brief Checks if the unordered map is empty.
+     * @brief Releases the old table once it holds no more elements.
      *
-     * @return True if the unordered map is empty, false otherwise.
+     * An iterator that was in the old table has moved on to this one by then, as it skips free slots.
      */
-    bool empty() const {
-        return size_ == 0;
+    void release_drained_table() noexcept {
+        if constexpr (Policy::resize_step != 0) {
+            if (old_ && old_->size_ == 0) {
+                old_.reset();
+                migrated_ = 0;
+            }
+        }
     }
 
     /**
-     * @brief Calculates the load factor of the unordered map.
-     *
-     * @return Load factor of the unordered map.
+     * @brief Migrates all remaining elements of the old table.
      */
-    float load() const {
-        if (capacity_ == 0) {
-            return 0.0f;
+    void finish_migration() {
+        while (old_) {
+            migrate_step();
         }
-        return static_cast<float>(size_) / capacity_;
     }
 
     /**
-     * @brief Returns the maximum load factor of the unordered map.
+     * @brief Erases the element stored in a slot.
      *
-     * @return Maximum load factor of the unordered map.
+     * Under the Robin Hood policy the following elements of the cluster are shifted back by one slot,
+     * so no tombstone is left behind unless wrapping is disallowed, see shift_back. Under the cuckoo
+     * policy no lookup ever continues past a bucket, so the slot simply becomes empty. Otherwise the slot becomes empty again if no probe sequence can
+     * have passed over it while it was occupied, i.e. if no window of ControlGroup::width consecutive
+     * slots around it is full, and is marked as deleted if one may have.
+     *
+     * @param index Index of the slot to erase.
+     * @param wrap Whether a Robin Hood shift may move an element from the first slot into the last one,
+     *             which erasing through an iterator disallows.
      */
-    float get_max_load() const {
-        return max_load;
+    void erase_at(size_type index, bool wrap = true) {
+        snapshots_.preserve(index);
+        alloc_traits::destroy(alloc_, &array[index].value);
+        vacate(index, wrap);
     }
 
     /**
-     * @brief Clears the contents of the unordered map.
+     * @brief Releases an occupied slot whose element has already been destroyed or moved away.
+     *
+     * @param index Index of the slot, see erase_at.
+     * @param wrap See erase_at.
      */
-    void clear() {
-        delete[] array;
-        size_ = 0;
-        capacity_ = 0;
-        step = 1;
-        max_load = 0.8f;
-        array = nullptr;
+    void vacate(size_type index, bool wrap = true) {
+        --size_;
+        if constexpr (Policy::cuckoo) {
+            set_ctrl(index, Ctrl::empty);
+        } else if constexpr (Policy::robin_hood) {
+            shift_back(index, wrap);
+        } else {
+            bool was_never_full = capacity_ <= ControlGroup::width;
+            if (!was_never_full) {
+                size_type before = capacity_policy::wrap(index + capacity_ - ControlGroup::width, capacity_);
+                auto empty_before = ControlGroup(ctrl_ + before).match_empty();
+                auto empty_after = ControlGroup(ctrl_ + index).match_empty();
+                was_never_full = empty_before && empty_after &&
+                                 empty_after.trailing_zeros() + empty_before.leading_zeros() < ControlGroup::width;
+            }
+            set_ctrl(index, was_never_full ? Ctrl::empty : Ctrl::deleted);
+            tombstones_ += !was_never_full;
+        }
     }
 
     /**
-     * @brief Finds an element with a specific key in the unordered map.
+     * @brief Closes the gap at a slot of a Robin Hood table by shifting back the elements that follow it.
      *
-     * @param key The key of the element to search for.
-     * @return Iterator to the element with the specified key if found, end() otherwise.
+     * Unless wrapping is allowed, the shift stops at the end of the array: moving an element from
+     * the first slot into the last one would put it ahead of an iteration that already visited it.
+     * The gap is then left as a tombstone, which probing passes over, and so is a gap followed by
+     * one. These tombstones form a single run ending at the last slot, closed by close_wrapped_gaps.
+     *
+     * @param index Index of the gap.
+     * @param wrap Whether elements may be shifted from the first slot into the last one.
      */
-    iterator find(const Key& key) {
-        size_t hashValue = hasher{}(key);
-        size_t index = hashValue % capacity_;
-        size_t start = index;
-
-        while (true) {
-            if (array[index].busy == 0) {
-                return end();
-            } else if (array[index].value.first == key && array[index].busy != -1) {
-                return iterator(array, index, capacity_);
-            }
-
-            index = (index + 1) % capacity_;
-            if (index == start) {
-                return end();
+    void shift_back(size_type index, bool wrap) {
+        size_type next = capacity_policy::wrap(index + 1, capacity_);
+        while (Ctrl::is_full(ctrl_[next]) && dist_[next] > 0) {
+            if (next == 0 && !wrap) {
+                break;
             }
+            relocate(array[index], array[next]);
+            set_ctrl(index, ctrl_[next]);
+            dist_[index] = dist_[next] - 1;
+            index = next;
+            next = capacity_policy::wrap(next + 1, capacity_);
         }
+        bool keeps_gap = ctrl_[next] == Ctrl::deleted || (next == 0 && !wrap && Ctrl::is_full(ctrl_[0]) && dist_[0] > 0);
+        set_ctrl(index, keeps_gap ? Ctrl::deleted : Ctrl::empty);
+        tombstones_ += keeps_gap;
     }
 
     /**
-     * @brief Finds an element with a specific key in the unordered map (const version).
+     * @brief Completes the shifts left unfinished at the end of a Robin Hood table by shift_back.
      *
-     * @param key The key of the element to search for.
-     * @return Const iterator to the element with the specified key if found, end() otherwise.
+     * Called before an insertion, which moves elements anyway.
      */
-    const_iterator find(const Key& key) const {
-        size_t hashValue = hasher{}(key);
-        size_t index = hashValue % capacity_;
-        size_t start = index;
-
-        while (true) {
-            if (array[index].busy == 0) {
-                return end();
-            } else if (array[index].value.first == key && array[index].busy != -1) {
-                return const_iterator(array, index, capacity_);
-            }
-
-            index = (index + 1) % capacity_;
-            if (index == start) {
-                return end();
-            }
+    void close_wrapped_gaps() {
+        for (size_type index = capacity_ - 1; tombstones_ != 0; --index) {
+            --tombstones_;
+            shift_back(index, true);
         }
     }
 
     /**
-     * @brief Inserts an element or updates the element if the key already exists.
+     * @brief Rehashes the table in place at its current capacity, turning every tombstone back into an empty slot.
      *
-     * @param value The key-value pair to insert or update.
-     * @return Pair with an iterator to the inserted or updated element and a bool indicating whether the insertion took place.
+     * Every element is first marked as pending, then moved to the first empty or pending slot on
+     * its probe sequence, unless it already lies in the group of that slot. Moving onto a pending
+     * slot swaps the two elements and the displaced one is placed next. No memory is allocated.
+     * Under the Robin Hood policy the tombstones are instead closed by close_wrapped_gaps, and the
+     * cuckoo policy leaves none.
      */
-    std::pair<iterator, bool> insert(const value_type& value) {
-        if (size_ + 1 > max_load * capacity_) rehash();
-        size_t hashValue = hasher{}(value.first);
-        size_t index = hashValue % capacity_;
-        size_t start = index;
-
-        while (true) {
-            if (array[index].busy == 0) {
-                array[index].value = value;
-                array[index].busy = 1;
-                size_++;
-                return {iterator(array, index, capacity_), true};
-            } else if (array[index].value.first == value.first) {
-                return {iterator(array, index, capacity_), false};
+    void drop_tombstones() {
+        if constexpr (Policy::robin_hood) {
+            close_wrapped_gaps();
+            return;
+        }
+        snapshots_.detach();
+        for (size_type i = 0; i < capacity_; ++i) {
+            ctrl_[i] = Ctrl::is_full(ctrl_[i]) ? Ctrl::deleted : Ctrl::empty;
+        }
+        for (size_type i = 0; i < ControlGroup::width - 1; ++i) {
+            ctrl_[capacity_ + i] = ctrl_[i % capacity_];
+        }
+        tombstones_ = 0;
+        for (size_type i = 0; i < capacity_; ++i) {
+            while (ctrl_[i] == Ctrl::deleted) {
+                std::size_t hash = stored_hash(i);
+                size_type pos = capacity_policy::index(hash, capacity_);
+                size_type target = i;
+                for (size_type probe = 0, limit = probe_limit(); probe < limit; ++probe) {
+                    auto free = ControlGroup(ctrl_ + pos).match_empty_or_deleted();
+                    if (free) {
+                        target = capacity_policy::wrap(pos + free.lowest(), capacity_);
+                        break;
+                    }
+                    pos = next_probe(pos, probe, hash);
+                }
+                size_type offset = i >= pos ? i - pos : i + capacity_ - pos;
+                if (target == i || offset < ControlGroup::width) {
+                    set_ctrl(i, Ctrl::h2(hash));
+                } else if (ctrl_[target] == Ctrl::empty) {
+                    relocate(array[target], array[i]);
+                    set_ctrl(target, Ctrl::h2(hash));
+                    set_ctrl(i, Ctrl::empty);
+                } else {
+                    entry_type displaced;
+                    relocate(displaced, array[target]);
+                    relocate(array[target], array[i]);
+                    relocate(array[i], displaced);
+                    set_ctrl(target, Ctrl::h2(hash));
+                }
             }
+        }
+    }
 
-            index = (index + 1) % capacity_;
-            if (index == start) {
-                rehash();
-                return insert(value);
+    /**
+    * @brief Reallocates memory for the hash table with a new capacity.
+    *
+    * @param new_capacity The new capacity of the hash table.
+    */
+    void reallocate(std::size_t new_capacity) {
+        finish_migration();
+        snapshots_.detach();
+        Unordered_map old(hash_, alloc_);
+        swap_storage(old);
+        allocate(new_capacity);
+
+        for (std::size_t i = 0; i < old.capacity_; ++i) {
+            if (Ctrl::is_full(old.ctrl_[i])) {
+                std::size_t hash = old.stored_hash(i);
+                size_type new_index = find_insert_slot(hash);
+                if constexpr (Policy::cuckoo) {
+                    // The elements moved so far fill both buckets beyond the search; grow further.
+                    while (new_index == capacity_) {
+                        reallocate(capacity_ * 2);
+                        new_index = find_insert_slot(hash);
+                    }
+                }
+                relocate(array[new_index], old.array[i]);
+                old.ctrl_[i] = Ctrl::empty;
+                occupy(new_index, hash);
             }
         }
     }
 
     /**
-     * @brief Inserts an element or updates the element if the key already exists (move version).
+     * @brief Doubles the capacity of the hash table.
      *
-     * @param value The key-value pair to insert or update.
-     * @return Pair with an iterator to the inserted or updated element and a bool indicating whether the insertion took place.
+     * Under the incremental resize policy the current table becomes the old table: only its first
+     * Policy::resize_step slots are migrated here and the rest by the following operations.
      */
-    std::pair<iterator, bool> insert(value_type&& value) {
-        if (size_ + 1 > max_load * capacity_) rehash();
-        size_t hashValue = hasher{}(value.first);
-        size_t index = hashValue % capacity_;
-        size_t start = index;
-
-        while (true) {
-            if (array[index].busy == 0) {
-                array[index].value = std::move(value);
-                array[index].busy = 1;
-                size_++;
-                return {iterator(array, index, capacity_), true};
-            } else if (array[index].value.first == value.first) {
-                return {iterator(array, index, capacity_), false};
-            }
-
-            index = (index + 1) % capacity_;
-            if (index == start) {
-                rehash();
-                return insert(std::move(value));
+    void rehash() {
+        [[maybe_unused]] auto timer = counters_.time_rehash();
+        size_type new_capacity = capacity_ == 0 ? 1 : capacity_ * 2;
+        if constexpr (Policy::resize_step != 0) {
+            if (capacity_ != 0) {
+                finish_migration();
+                snapshots_.detach();
+                old_ = std::make_unique<Unordered_map>(hash_, alloc_);
+                swap_storage(*old_);
+                allocate(new_capacity);
+                migrate_step();
+                return;
             }
         }
+        reallocate(new_capacity);
     }
 
     /**
-     * @brief Inserts a new element into the unordered map using a key and arguments for the value constructor.
+     * @brief Cuts the slots of the old table, if any, followed by this table into ranges.
      *
-     * @tparam Args Types of the arguments for the value constructor.
-     * @param key The key of the new element.
-     * @param args Arguments for the value constructor.
-     * @return Pair with an iterator to the inserted element and a bool indicating whether the insertion took place.
+     * A range crossing from the old table into this one is a two-segment iterator whose second
+     * segment ends at the cut, so no range ever visits the slots of the next one.
+     *
+     * @tparam It Type of the iterators of the ranges.
+     * @param count Number of ranges, at least 1.
+     * @return The ranges, in iteration order.
      */
-    template<typename... Args>
-    std::pair<iterator, bool> emplace(const key_type& key, Args&&... args) {
-        iterator it = find(key);
-        if (it != end()) {
-            return {it, false};
-        } else {
-            if (size_ + 1 > max_load * capacity_) {
-                rehash();
+    template<class It>
+    std::vector<MapRange<It>> split_slots(size_type count) const {
+        const size_type old_capacity = old_ ? old_->capacity_ : 0;
+        const size_type total = old_capacity + capacity_;
+        count = std::max<size_type>(count, 1);
+        std::vector<MapRange<It>> ranges;
+        ranges.reserve(count);
+        for (size_type i = 0; i < count; ++i) {
+            size_type lo = total / count * i + std::min(i, total % count);
+            size_type hi = total / count * (i + 1) + std::min(i + 1, total % count);
+            It first;
+            It last;
+            if (lo >= old_capacity) {
+                first = It(ctrl_, array, lo - old_capacity, hi - old_capacity);
+                last = It(ctrl_, array, hi - old_capacity, hi - old_capacity);
+            } else if (hi <= old_capacity) {
+                first = It(old_->ctrl_, old_->array, lo, hi);
+                last = It(old_->ctrl_, old_->array, hi, hi);
+            } else {
+                first = It(old_->ctrl_, old_->array, lo, old_capacity, ctrl_, array, hi - old_capacity);
+                last = It(ctrl_, array, hi - old_capacity, hi - old_capacity);
             }
-            size_type index = hasher{}(key) % capacity_;
-            while (array[index].busy != 0) {
-                index = (index + step) % capacity_;
-            }
-            array[index].value = {key, mapped_type(std::forward<Args>(args)...)};
-            array[index].busy = 1;
-            ++size_;
-            if(load() >= max_load) rehash();
-            return {iterator(array, index, capacity_), true};
+            first.skip_free();
+            ranges.push_back({with_snapshots(first), with_snapshots(last)});
         }
+        return ranges;
     }
 
     /**
-     * @brief Accesses the mapped value associated with the given key.
+     * @brief Finds an element in this table or, while growing, in the old table.
      *
-     * @param key The key of the element to access.
-     * @return Reference to the mapped value of the element with the specified key.
-     * @throw std::out_of_range if the key is not found.
+     * @tparam It Type of the iterator to return.
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key of the element to find.
+     * @param erasing True to count the probes as an erasure rather than a lookup.
+     * @return Iterator to the element if found, end() otherwise.
      */
-    mapped_type& at(const key_type& key) {
-        iterator it = find(key);
-        if (it != end()) {
-            return it->second;
-        } else {
-            throw std::out_of_range("Key not found");
+    template<class It, class K>
+    It locate(const K& key, bool erasing = false) const {
+        if (capacity_ == 0) {
+            record_lookup(erasing, 0);
+            return It(ctrl_, array, capacity_, capacity_);
         }
+        return locate<It>(key, hash_of(key), erasing);
     }
 
     /**
-     * @brief Accesses the mapped value associated with the given key (const version).
+     * @brief Finds an element with a precomputed hash in this table or, while growing, in the old table.
      *
-     * @param key The key of the element to access.
-     * @return Const reference to the mapped value of the element with the specified key.
-     * @throw std::out_of_range if the key is not found.
+     * @tparam It Type of the iterator to return.
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key of the element to find.
+     * @param hash The hash of the key as returned by hash_of.
+     * @param erasing True to count the probes as an erasure rather than a lookup.
+     * @return Iterator to the element if found, end() otherwise.
      */
-    const mapped_type& at(const key_type& key) const {
-        const_iterator it = find(key);
-        if (it != end()) {
-            return it->second;
-        } else {
-            throw std::out_of_range("Key not found");
+    template<class It, class K>
+    It locate(const K& key, std::size_t hash, bool erasing = false) const {
+        auto [index, probes] = probe_index(key, hash);
+        if (index == capacity_ && old_) {
+            auto [old_index, old_probes] = old_->probe_index(key, hash);
+            record_lookup(erasing, probes + old_probes);
+            if (old_index != old_->capacity_) {
+                return with_snapshots(It(old_->ctrl_, old_->array, old_index, old_->capacity_, ctrl_, array, capacity_));
+            }
+            return It(ctrl_, array, index, capacity_);
         }
+        record_lookup(erasing, probes);
+        return with_snapshots(It(ctrl_, array, index, capacity_));
     }
 
     /**
-     * @brief Accesses or inserts an element with the given key.
+     * @brief Gives a mutable iterator the snapshot registry it preserves pages through when dereferenced.
      *
-     * @param key The key of the element to access or insert.
-     * @return Reference to the mapped value of the accessed or inserted element.
-     * @throw std::out_of_range if the key is not found.
+     * @tparam It Type of the iterator.
+     * @param it The iterator.
+     * @return The iterator, with the registry if it is mutable and the policy supports snapshots.
      */
-    mapped_type& operator[](const key_type& key) {
-        iterator it = find(key);
-        if (it != end()) {
-            return it->second;
-        } else {
-            emplace(key, mapped_type{});
-            return find(key)->second;
+    template<class It>
+    It with_snapshots(It it) const noexcept {
+        if constexpr (Policy::snapshots && std::is_same_v<It, iterator>) {
+            it.snapshots.registry = &snapshots_;
         }
+        return it;
     }
 
     /**
-     * @brief Accesses or inserts an element with the given key (const version).
+     * @brief Counts the probes of a lookup or an erasure in the statistics, if collected.
      *
-     * @param key The key of the element to access or insert.
-     * @return Const reference to the mapped value of the accessed or inserted element.
-     * @throw std::out_of_range if the key is not found.
+     * @param erasing True for an erasure, false for a lookup.
+     * @param probes Number of probes made.
      */
-    const mapped_type& operator[](const key_type& key) const {
-        const_iterator it = find(key);
-        if (it != end()) {
-            return it->second;
+    void record_lookup(bool erasing, size_type probes) const {
+        if (erasing) {
+            counters_.record_erase(probes);
         } else {
-            throw std::out_of_range("Key not found");
+            counters_.record_find(probes);
         }
     }
 
     /**
-     * @brief Erases an element from the unordered map at a specified position.
+     * @brief Looks up a range of keys in batches, hashing and prefetching a batch before probing it.
      *
-     * @param pos Iterator pointing to the element to erase.
-     * @return Iterator following the removed element.
+     * @tparam It Type of the iterators to write.
+     * @tparam KeyIt Type of the iterators over the keys.
+     * @tparam OutputIt Type of the output iterator.
+     * @param first Iterator to the first key.
+     * @param last Iterator past the last key.
+     * @param out Output receiving an iterator per key.
+     * @return Output iterator past the last iterator written.
      */
-    iterator erase(iterator pos) {
-        size_type idx = find_index(pos->first);
-        array[idx].busy = -1;
-        --size_;
-        return pos;
+    template<class It, class KeyIt, class OutputIt>
+    OutputIt locate_many(KeyIt first, KeyIt last, OutputIt out) const {
+        std::size_t hashes[batch_size];
+        while (first != last) {
+            size_type count = 0;
+            for (KeyIt it = first; it != last && count < batch_size; ++it, ++count) {
+                hashes[count] = hash_of(*it);
+                prefetch_home(hashes[count]);
+            }
+            for (size_type i = 0; i < count; ++i, ++first) {
+                *out++ = capacity_ == 0 ? It(ctrl_, array, capacity_, capacity_) : locate<It>(*first, hashes[i]);
+            }
+        }
+        return out;
     }
 
     /**
-     * @brief Erases an element from the unordered map at a specified position (const version).
+     * @brief Finds the index of an element with a specified key and precomputed hash in the hash table.
      *
-     * @param pos Const iterator pointing to the element to erase.
-     * @return Const iterator following the removed element.
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key of the element to find.
+     * @param hash The hash of the key as returned by hash_of.
+     * @return Index of the element in the hash table, or capacity_ if not found.
      */
-    const_iterator erase(const_iterator pos) {
-        size_type idx = find_index(pos->first);
-        array[idx].busy = -1;
-        --size_;
-        return pos;
+    template<class K>
+    size_type find_index(const K& key, std::size_t hash) const {
+        return probe_index(key, hash).first;
     }
 
     /**
-     * @brief Erases an element from the unordered map with a specified key.
+     * @brief Probes for a key with a precomputed hash, counting the probes made.
      *
-     * @param key The key of the element to erase.
-     * @return Number of elements erased (0 or 1).
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key of the element to find.
+     * @param hash The hash of the key as returned by hash_of.
+     * @return Pair with the index of the element or capacity_ if not found, and the number of
+     *         control groups (slots under the Robin Hood policy, buckets under the cuckoo policy) examined.
      */
-    size_type erase(const key_type& key) {
-        size_type idx = find_index(key);
-        if (idx != capacity_) {
-            array[idx].busy = -1;
-            --size_;
-            return 1;
+    template<class K>
+    std::pair<size_type, size_type> probe_index(const K& key, std::size_t hash) const {
+        if (capacity_ == 0) {
+            return {capacity_, 0};
         }
-        return 0;
-    }
+        std::int8_t h2 = Ctrl::h2(hash);
+        size_type pos = capacity_policy::index(hash, capacity_);
 
-    /**
-     * @brief Reserves space for a specified number of elements.
-     *
-     * @param new_capacity The new capacity of the unordered map.
-     */
-    void reserve(size_type new_capacity) {
-        if (new_capacity <= capacity_)
-            return;
+        if constexpr (Policy::cuckoo) {
+            auto [first, second] = cuckoo_buckets(hash);
+            for (size_type idx = first; idx < first + cuckoo_bucket; ++idx) {
+                if (ctrl_[idx] == h2 && hash_matches(idx, hash) && key_equal{}(array[idx].value.first, key)) {
+                    return {idx, 1};
+                }
+            }
+            for (size_type idx = second; idx < second + cuckoo_bucket; ++idx) {
+                if (ctrl_[idx] == h2 && hash_matches(idx, hash) && key_equal{}(array[idx].value.first, key)) {
+                    return {idx, 2};
+                }
+            }
+            return {capacity_, 2};
+        }
 
-        auto* new_array = new entry_type[new_capacity];
-        for (size_type i = 0; i < capacity_; ++i) {
-            if (array[i].busy == 1) {
-                size_type new_index = hasher{}(array[i].value.first) % new_capacity;
-                while (new_array[new_index].busy != 0) {
-                    new_index = (new_index + step) % new_capacity;
+        if constexpr (Policy::robin_hood) {
+            size_type distance = 0;
+            for (; ctrl_[pos] == Ctrl::deleted || (Ctrl::is_full(ctrl_[pos]) && dist_[pos] >= distance); ++distance) {
+                if (ctrl_[pos] == h2 && hash_matches(pos, hash) && key_equal{}(array[pos].value.first, key)) {
+                    return {pos, distance + 1};
+                }
+                pos = capacity_policy::wrap(pos + 1, capacity_);
+            }
+            return {capacity_, distance + 1};
+        }
+
+        size_type probe = 0;
+        for (size_type limit = probe_limit(); probe < limit; ++probe) {
+            ControlGroup group(ctrl_ + pos);
+            for (unsigned offset : group.match(h2)) {
+                size_type idx = capacity_policy::wrap(pos + offset, capacity_);
+                if (hash_matches(idx, hash) && key_equal{}(array[idx].value.first, key)) {
+                    return {idx, probe + 1};
                 }
-                new_array[new_index].value = std::move(array[i].value);
-                new_array[new_index].busy = 1;
             }
+            if (group.match_empty()) {
+                return {capacity_, probe + 1};  // Пустой слот в группе означает, что элемента нет дальше по последовательности проб
+            }
+            pos = next_probe(pos, probe, hash);
         }
-        delete[] array;
-        array = new_array;
-        capacity_ = new_capacity;
+
+        return {capacity_, probe};  // Возвращаем capacity_, если элемент не найден
     }
 
     /**
-     * @brief Counts the number of elements with a specific key.
+     * @brief Counts the probes of a lookup in this table and, if it misses and the map is growing, in the old table.
      *
-     * @param key The key of the elements to count.
-     * @return Number of elements with the specified key (0 or 1).
+     * @tparam K Type of the key, or of a key-like value for transparent lookup.
+     * @param key The key to look up.
+     * @return Number of probes made.
      */
-    size_type count(const key_type& key) const {
-        size_type count = 0;
-        size_type idx = find_index(key);
-        if (idx != capacity_) {
-            count = 1;
+    template<class K>
+    size_type probe_length_of(const K& key) const {
+        std::size_t hash = hash_of(key);
+        auto [index, probes] = probe_index(key, hash);
+        if (index == capacity_ && old_) {
+            probes += old_->probe_index(key, hash).second;
         }
-        return count;
+        return probes;
     }
 
     /**
-     * @brief Swaps the contents of two unordered maps.
+     * @brief Returns the number of probes after which the probing policy has visited every group.
      *
-     * @param other Another unordered map to swap with.
+     * @return Maximum number of probes of a lookup or insertion.
      */
-    void swap(Unordered_map& other) noexcept {
-        std::swap(size_, other.size_);
-        std::swap(capacity_, other.capacity_);
-        std::swap(step, other.step);
-        std::swap(max_load, other.max_load);
-        std::swap(array, other.array);
+    size_type probe_limit() const {
+        return probing::probe_limit((capacity_ + ControlGroup::width - 1) / ControlGroup::width);
     }
 
     /**
-     * @brief Checks if the unordered map contains an element with the given key.
+     * @brief Moves from one probed control group to the next on the probe sequence of a hash.
      *
-     * @param key The key to search for.
-     * @return True if the unordered map contains an element with the key, false otherwise.
+     * @param pos First slot of the current group.
+     * @param probe Number of the current probe, starting at 0 for the home group.
+     * @param hash The hash of the key as returned by hash_of.
+     * @return First slot of the next group.
      */
-    bool contains(const key_type& key) const {
-        return find_index(key) != capacity_;
+    size_type next_probe(size_type pos, size_type probe, std::size_t hash) const {
+        size_type groups = (capacity_ + ControlGroup::width - 1) / ControlGroup::width;
+        return capacity_policy::wrap(pos + ControlGroup::width * probing::step(probe, hash, groups), capacity_);
     }
 
     /**
-     * @brief Merges the contents of another unordered map into this one.
+     * @brief Returns the two buckets of a hash under the cuckoo policy.
      *
-     * @param other Another unordered map to merge with.
+     * The low bits and the high half of the hash select the buckets, acting as two independent
+     * hash functions; the buckets always differ.
+     *
+     * @param hash The hash of the key as returned by hash_of.
+     * @return Pair with the first slots of the two buckets.
      */
-    void merge(Unordered_map& other) {
-        for (auto& entry : other) {
-            insert(std::move(entry));
-        }
-        other.clear();
-    }
-
-private:
-
-    std::size_t size_ = 0; /**< Number of elements in the unordered map. */
-    std::size_t capacity_ = 0; /**< Capacity of the hash table. */
-    std::size_t step = 1; /**< Step size for resolving collisions. */
-    float max_load = 0.8f; /**< Maximum load factor before rehashing. */
-    entry_type* array = nullptr; /**< Array of hash table entries. */
-
-    /**
-    * @brief Reallocates memory for the hash table with a new capacity.
-    *
-    * @param new_capacity The new capacity of the hash table.
-    */
-    void reallocate(std::size_t new_capacity) {
-        auto* new_array = new entry_type[new_capacity];
-        for (std::size_t i = 0; i < capacity_; ++i) {
-            if (array[i].busy == 1) {
-                std::size_t new_index = hasher{}(array[i].value.first) % new_capacity;
-                while (new_array[new_index].busy == 1) {
-                    new_index = (new_index + step) % new_capacity;
-                }
-                new_array[new_index].value = std::move(array[i].value);
-                new_array[new_index].busy = 1;
-            }
-        }
-        if(capacity_ != 0) delete[] array;
-        array = new_array;
-        capacity_ = new_capacity;
+    std::pair<size_type, size_type> cuckoo_buckets(std::size_t hash) const {
+        size_type mask = capacity_ - cuckoo_bucket;
+        size_type first = hash & mask;
+        size_type second = std::rotr(static_cast<std::uint64_t>(hash), 32) & mask;
+        return {first, second == first ? second ^ cuckoo_bucket : second};
     }
 
     /**
-     * @brief Rehashes the contents of the unordered map.
+     * @brief Moves an element to an empty slot.
+     *
+     * @param from Index of the occupied slot, empty afterwards.
+     * @param to Index of the empty slot.
      */
-    void rehash() {
-        reallocate((capacity_ == 0 ? 1 : capacity_ * 2));
+    void move_slot(size_type from, size_type to) {
+        relocate(array[to], array[from]);
+        set_ctrl(to, ctrl_[from]);
+        set_ctrl(from, Ctrl::empty);
     }
 
     /**
-     * @brief Finds the index of an element with a specified key in the hash table.
+     * @brief Frees a slot in one of the two buckets of a hash under the cuckoo policy.
      *
-     * @param key The key of the element to find.
-     * @return Index of the element in the hash table, or capacity_ if not found.
+     * Searches breadth-first from the two buckets, following every element to its other bucket,
+     * for the nearest bucket with an empty slot. The elements on the path to it are then moved
+     * one step each, starting from its end, so no element is ever without a slot.
+     *
+     * @param hash The hash of the key to insert.
+     * @return Index of the freed slot, or capacity_ if the search found no empty slot.
      */
-    size_type find_index(const key_type& key) const {
-        size_type idx = hasher()(key) % capacity_;
-        size_type initial_idx = idx;
-
-        while (array[idx].busy == 1) {
-            if (key_equal()(array[idx].value.first, key)) {
-                return idx;
+    size_type cuckoo_insert_slot(std::size_t hash) {
+        struct Step {
+            size_type bucket; /**< First slot of the bucket reached. */
+            size_type parent; /**< Step the bucket was reached from, or cuckoo_search_limit for the two start buckets. */
+            size_type slot; /**< Slot in the parent bucket whose element would move into this bucket. */
+        };
+        Step path[cuckoo_search_limit];
+        auto [first, second] = cuckoo_buckets(hash);
+        path[0] = {first, cuckoo_search_limit, 0};
+        path[1] = {second, cuckoo_search_limit, 0};
+        size_type count = 2;
+        for (size_type n = 0; n < count; ++n) {
+            size_type bucket = path[n].bucket;
+            for (size_type idx = bucket; idx < bucket + cuckoo_bucket; ++idx) {
+                if (!Ctrl::is_full(ctrl_[idx])) {
+                    for (size_type m = n; path[m].parent != cuckoo_search_limit; m = path[m].parent) {
+                        move_slot(path[m].slot, idx);
+                        idx = path[m].slot;
+                    }
+                    return idx;
+                }
             }
-            idx = (idx + step) % capacity_;
-            if (idx == initial_idx) {
-                break;  // Если мы вернулись в начальную позицию, значит элемент не найден
+            for (size_type idx = bucket; idx < bucket + cuckoo_bucket && count < cuckoo_search_limit; ++idx) {
+                // A slot already on the path would be vacated twice.
+                bool on_path = false;
+                for (size_type m = n; path[m].parent != cuckoo_search_limit && !on_path; m = path[m].parent) {
+                    on_path = path[m].slot == idx;
+                }
+                if (!on_path) {
+                    auto [home, other] = cuckoo_buckets(stored_hash(idx));
+                    path[count++] = {home == bucket ? other : home, n, idx};
+                }
             }
         }
-
-        return capacity_;  // Возвращаем capacity_, если элемент не найден
+        return capacity_;
     }
 };
 
+namespace pmr {
+
+/**
+ * @brief Unordered_map taking its memory from a std::pmr::memory_resource.
+ */
+template<class Key, class T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>, class Policy = DefaultMapPolicy>
+using Unordered_map = ::Unordered_map<Key, T, Hash, KeyEqual, Policy, std::pmr::polymorphic_allocator<std::pair<Key, T>>>;
+
+}
+
 #endif //UNORDERED_MAP_H